@@ -0,0 +1,26 @@
+/*
+Copyright 2019 Ilia S. Kovalev
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef BENCHMARKS_HPP
+#define BENCHMARKS_HPP
+
+// Benchmarks take the arguments following their name on the command line.
+
+int numa_placement(int argc, char* argv[]);
+int transport_throughput(int argc, char* argv[]);
+int serialization_throughput(int argc, char* argv[]);
+
+#endif
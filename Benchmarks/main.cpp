@@ -0,0 +1,64 @@
+/*
+Copyright 2019 Ilia S. Kovalev
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "benchmarks.hpp"
+
+#include <cstdio>
+#include <exception>
+#include <string>
+
+namespace
+{
+	struct Benchmark
+	{
+		const char* name;
+		int (*run)(int argc, char* argv[]);
+	};
+
+	const Benchmark benchmarks[] = {
+		{ "numa_placement", numa_placement },
+		{ "transport_throughput", transport_throughput },
+		{ "serialization_throughput", serialization_throughput },
+	};
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc < 2)
+	{
+		std::puts("Usage: Benchmarks <benchmark> [arguments]\nBenchmarks:");
+		for (auto& b : benchmarks)
+			std::printf("  %s\n", b.name);
+		return 1;
+	}
+
+	for (auto& b : benchmarks)
+		if (argv[1] == std::string(b.name))
+		{
+			try
+			{
+				return b.run(argc - 2, argv + 2);
+			}
+			catch (const std::exception& e)
+			{
+				std::fprintf(stderr, "%s\n", e.what());
+				return 1;
+			}
+		}
+
+	std::fprintf(stderr, "Unknown benchmark %s\n", argv[1]);
+	return 1;
+}
@@ -0,0 +1,123 @@
+/*
+Copyright 2019 Ilia S. Kovalev
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "benchmarks.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <future>
+#include <vector>
+
+#include <algorithm_assembler/utils/numa.hpp>
+#include <algorithm_assembler/utils/thread_pool.hpp>
+
+namespace
+{
+	using namespace algorithm_assembler;
+
+	using Buffer = std::vector<std::uint64_t, utils::Numa_allocator<std::uint64_t>>;
+
+	/// <summary>
+	/// Keeps the sums from being optimized away.
+	/// </summary>
+	volatile std::uint64_t checksum_sink = 0;
+
+	/// <summary>
+	/// Reads all buffers by the pool, buffer i is read by a single task.
+	/// </summary>
+	/// <returns>Read bandwidth in GB/s.</returns>
+	double read_bandwidth(utils::Thread_pool& pool, const std::vector<Buffer>& buffers, int passes)
+	{
+		std::uint64_t checksum = 0;
+		auto start = std::chrono::steady_clock::now();
+
+		for (int pass = 0; pass < passes; ++pass)
+		{
+			std::vector<std::future<std::uint64_t>> sums;
+			for (auto& buffer : buffers)
+				sums.push_back(pool.submit([&buffer]() {
+					std::uint64_t sum = 0;
+					for (auto v : buffer)
+						sum += v;
+					return sum;
+				}));
+
+			for (auto& s : sums)
+				checksum += s.get();
+		}
+
+		std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+		double bytes = 0;
+		for (auto& buffer : buffers)
+			bytes += static_cast<double>(buffer.size() * sizeof(std::uint64_t)) * passes;
+
+		checksum_sink = checksum;
+
+		return bytes / elapsed.count() / 1e9;
+	}
+
+	std::vector<Buffer> make_buffers(std::size_t node, std::size_t count, std::size_t size)
+	{
+		std::vector<Buffer> buffers;
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			buffers.emplace_back(utils::Numa_allocator<std::uint64_t>(node));
+			buffers.back().resize(size, i);
+		}
+		return buffers;
+	}
+}
+
+/// <summary>
+/// Reads buffers by workers pinned to the first online node with the buffers placed on it
+/// and on the last online node.
+/// Arguments: [megabytes per worker] [passes]
+/// </summary>
+int numa_placement(int argc, char* argv[])
+{
+	std::size_t megabytes = argc > 0 ? std::strtoul(argv[0], nullptr, 10) : 256;
+	int passes = argc > 1 ? std::atoi(argv[1]) : 10;
+
+	auto nodes = detail::numa_nodes();
+	auto local_node = nodes.front();
+	auto remote_node = nodes.back();
+
+	utils::Thread_pool_settings settings;
+	settings.numa_node = local_node;
+	utils::Thread_pool pool(settings);
+
+	auto size = (megabytes << 20) / sizeof(std::uint64_t);
+	std::printf("%zu online NUMA nodes, %zu workers on node %zu, %zu MB per worker\n",
+		nodes.size(), pool.size(), local_node, megabytes);
+
+	auto local = make_buffers(local_node, pool.size(), size);
+	std::printf("local  (node %zu): %.2f GB/s\n", local_node, read_bandwidth(pool, local, passes));
+	local.clear();
+
+	if (remote_node == local_node)
+	{
+		std::puts("single node system, no remote placement to compare");
+		return 0;
+	}
+
+	auto far = make_buffers(remote_node, pool.size(), size);
+	std::printf("remote (node %zu): %.2f GB/s\n", remote_node, read_bandwidth(pool, far, passes));
+
+	return 0;
+}
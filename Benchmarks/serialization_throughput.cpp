@@ -0,0 +1,124 @@
+/*
+Copyright 2019 Ilia S. Kovalev
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "benchmarks.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include <algorithm_assembler/serialization.hpp>
+
+namespace
+{
+	using namespace algorithm_assembler;
+
+	struct Sample
+	{
+		std::uint64_t index;
+		double values[7];
+	};
+
+	/// <summary>
+	/// Item with a hook: a header, a string and a block of trivially copyable values.
+	/// </summary>
+	struct Frame
+	{
+		std::uint64_t index;
+		std::string source;
+		std::vector<float> pixels;
+
+		template<class Archive>
+		void serialize(Archive& archive) { archive(index, source, pixels); }
+	};
+
+	/// <summary>
+	/// Keeps the results from being optimized away.
+	/// </summary>
+	volatile std::size_t checksum_sink = 0;
+
+	void report(const char* what, std::uint64_t items, std::size_t bytes, std::chrono::steady_clock::time_point start)
+	{
+		std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+		std::printf("%-14s %9.2f M items/s %9.1f MB/s\n",
+			what, items / elapsed.count() / 1e6, bytes / elapsed.count() / 1e6);
+	}
+
+	/// <summary>
+	/// Writes the items into one preallocated buffer and reads them back.
+	/// </summary>
+	template<typename T>
+	void run(const char* name, const std::vector<T>& items, std::uint64_t rounds)
+	{
+		std::size_t size = 0;
+		for (auto& item : items)
+			size += utils::serialized_size(item);
+
+		std::vector<std::byte> buffer(size);
+		utils::Binary_writer writer(buffer.data(), buffer.size());
+
+		auto start = std::chrono::steady_clock::now();
+		for (std::uint64_t r = 0; r < rounds; ++r)
+		{
+			writer.clear();
+			for (auto& item : items)
+				writer(item);
+			checksum_sink = checksum_sink + static_cast<std::size_t>(buffer[r % size]);
+		}
+		report((std::string(name) + " write").c_str(), rounds * items.size(), rounds * size, start);
+
+		T value{};
+		start = std::chrono::steady_clock::now();
+		for (std::uint64_t r = 0; r < rounds; ++r)
+		{
+			utils::Binary_reader reader(buffer.data(), buffer.size());
+			for (std::size_t i = 0; i < items.size(); ++i)
+				reader(value);
+			checksum_sink = checksum_sink + reader.position();
+		}
+		report((std::string(name) + " read").c_str(), rounds * items.size(), rounds * size, start);
+	}
+}
+
+/// <summary>
+/// Serializes trivially copyable 64-byte items and items with a serialize hook
+/// into a preallocated buffer and deserializes them.
+/// Arguments: [rounds] [pixels in a frame]
+/// </summary>
+int serialization_throughput(int argc, char* argv[])
+{
+	std::uint64_t rounds = argc > 0 ? std::strtoull(argv[0], nullptr, 10) : 1000;
+	std::size_t pixels = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1024;
+
+	std::vector<Sample> samples(4096);
+	for (std::size_t i = 0; i < samples.size(); ++i)
+		samples[i] = { i, { i * 0.5 } };
+
+	std::vector<Frame> frames(64);
+	for (std::size_t i = 0; i < frames.size(); ++i)
+		frames[i] = { i, "camera " + std::to_string(i % 4), std::vector<float>(pixels, i * 0.25f) };
+
+	std::printf("%llu rounds, frames of %zu pixels\n", static_cast<unsigned long long>(rounds), pixels);
+
+	run("sample", samples, rounds);
+	run("frame", frames, rounds);
+
+	return 0;
+}
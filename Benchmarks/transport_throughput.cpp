@@ -0,0 +1,164 @@
+/*
+Copyright 2019 Ilia S. Kovalev
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "benchmarks.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+
+#include <algorithm_assembler/data_processor.hpp>
+#include <algorithm_assembler/modules/channel_stages.hpp>
+#include <algorithm_assembler/modules/transport_stages.hpp>
+
+namespace
+{
+	using namespace algorithm_assembler;
+
+	struct Sample
+	{
+		std::uint64_t index;
+		double values[7];
+	};
+
+	struct Samples : public Functor<Sample>
+	{
+		std::uint64_t next = 0;
+		std::uint64_t last = 0;
+
+		Sample operator()() override { auto i = next++; return { i, { i * 0.5 } }; }
+		bool is_active() const override { return next < last; }
+	};
+
+	struct Checksum : public Functor<std::uint64_t, const Sample&>
+	{
+		std::uint64_t sum = 0;
+
+		std::uint64_t operator()(const Sample& in) override { return sum += in.index; }
+	};
+
+	/// <summary>
+	/// Keeps the sums from being optimized away.
+	/// </summary>
+	volatile std::uint64_t checksum_sink = 0;
+
+	void report(const char* path, std::uint64_t items, std::chrono::steady_clock::time_point start)
+	{
+		std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+		auto rate = static_cast<double>(items) / elapsed.count();
+		std::printf("%-8s %8.2f M items/s %8.1f MB/s\n", path, rate / 1e6, rate * sizeof(Sample) / 1e6);
+	}
+
+	/// <summary>
+	/// Both stages in one Data_processor.
+	/// </summary>
+	void run_direct(std::uint64_t items)
+	{
+		Data_processor<Samples, Checksum> processor;
+		processor.module<0>().last = items;
+
+		auto start = std::chrono::steady_clock::now();
+		while (processor.is_active())
+			checksum_sink = processor();
+		report("direct", items, start);
+	}
+
+	/// <summary>
+	/// Stages in two pipelines on different threads connected by a channel.
+	/// </summary>
+	void run_channel(std::uint64_t items)
+	{
+		utils::Channel<Sample> channel;
+
+		Data_processor<Samples, modules::Channel_sink<Sample>> producer;
+		producer.module<0>().last = items;
+		producer.module<1>().connect(channel);
+
+		Data_processor<modules::Channel_source<Sample>, Checksum> consumer;
+		consumer.module<0>().connect(channel);
+
+		auto start = std::chrono::steady_clock::now();
+		std::thread producing([&]() {
+			while (producer.is_active())
+				producer();
+			channel.close();
+		});
+
+		while (consumer.is_active())
+			checksum_sink = consumer();
+		producing.join();
+		report("channel", items, start);
+	}
+
+	/// <summary>
+	/// Stages in two pipelines on different threads connected by a socket.
+	/// </summary>
+	void run_transport(const char* path, modules::Transport_settings settings, std::uint64_t items)
+	{
+		Data_processor<modules::Transport_source<Sample>, Checksum> consumer;
+		consumer.module<0>().set(settings);
+		if (settings.protocol == Transport_protocol::tcp)
+			settings.port = consumer.module<0>().port();
+
+		Data_processor<Samples, modules::Transport_sink<Sample>> producer;
+		producer.module<0>().last = items;
+		producer.module<1>().set(settings);
+
+		auto start = std::chrono::steady_clock::now();
+		std::thread producing([&]() {
+			while (producer.is_active())
+				producer();
+			producer.module<1>().close();
+		});
+
+		while (consumer.is_active())
+			checksum_sink = consumer();
+		producing.join();
+		report(path, items, start);
+	}
+}
+
+/// <summary>
+/// Passes 64-byte items between two stages in one pipeline, through a channel
+/// and through TCP and Unix socket transports on the loopback.
+/// Arguments: [millions of items] [batch size]
+/// </summary>
+int transport_throughput(int argc, char* argv[])
+{
+	std::uint64_t items = (argc > 0 ? std::strtoull(argv[0], nullptr, 10) : 10) * 1000000;
+
+	modules::Transport_settings settings;
+	settings.address = "127.0.0.1";
+	settings.batch_size = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 256;
+
+	std::printf("%llu items of %zu bytes, batches of %zu items\n",
+		static_cast<unsigned long long>(items), sizeof(Sample), settings.batch_size);
+
+	run_direct(items);
+	run_channel(items);
+	run_transport("tcp", settings, items);
+
+#ifndef _WIN32
+	settings.protocol = Transport_protocol::unix_socket;
+	settings.address = "/tmp/aa_transport_throughput";
+	run_transport("unix", settings, items);
+#endif
+
+	return 0;
+}
@@ -0,0 +1,136 @@
+/*
+Copyright 2019 Ilia S. Kovalev
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "pch.h"
+
+#include <algorithm_assembler/modules/aligned_join.hpp>
+
+namespace aligned_join_test
+{
+	struct Sample
+	{
+		int timestamp;
+		std::string value;
+	};
+
+	/// <summary>
+	/// Returns samples with timestamps first, first + step, ... while below last.
+	/// </summary>
+	struct Sampler : public aa::Functor<Sample>
+	{
+		int first = 0;
+		int step = 1;
+		int last = 0;
+		int failing_at = -1;
+
+		int next = 0;
+		bool is_started = false;
+
+		Sample operator()() override
+		{
+			if (!is_started)
+			{
+				next = first;
+				is_started = true;
+			}
+
+			int t = next;
+			next += step;
+			if (t == failing_at)
+				throw std::runtime_error("failure");
+			return { t, std::to_string(t) };
+		}
+
+		bool is_active() const override { return (is_started ? next : first) < last; }
+	};
+
+	struct Describe : public aa::Functor<std::string, std::tuple<Sample, Sample>>
+	{
+		std::string operator()(std::tuple<Sample, Sample> in) override
+		{
+			return std::get<0>(in).value + ":" + std::get<1>(in).value;
+		}
+	};
+
+	using Join = aa::modules::Aligned_join<aa::modules::Timestamp_field, Sampler, Sampler>;
+
+	void setup(Join& join, int last_a, int last_b)
+	{
+		join.source<0>().step = 10;
+		join.source<0>().last = last_a;
+
+		join.source<1>().first = 1;
+		join.source<1>().step = 5;
+		join.source<1>().last = last_b;
+	}
+}
+
+TEST(Aligned_join, tolerance)
+{
+	using namespace aligned_join_test;
+
+	aa::Data_processor<Join, Describe> f;
+	f.module<0>().set(aa::modules::Aligned_join_settings{ 2, 4 });
+	setup(f.module<0>(), 1000, 1000);
+
+	std::vector<std::string> outs;
+	while (f.is_active())
+		outs.push_back(f());
+
+	// 0:1, 10:11, 20:21, ... samples 6, 16, ... of the faster source are dropped.
+	ASSERT_EQ(outs.size(), 100);
+	for (int i = 0; i < 100; ++i)
+		ASSERT_EQ(outs[i], std::to_string(i * 10) + ":" + std::to_string(i * 10 + 1));
+	ASSERT_EQ(f.module<0>().dropped(), 99);
+}
+
+TEST(Aligned_join, source_end)
+{
+	using namespace aligned_join_test;
+
+	Join join;
+	join.set(aa::modules::Aligned_join_settings{ 0, 2 });
+	join.source<0>().first = 5;
+	join.source<0>().step = 5;
+	join.source<0>().last = 1000;
+	join.source<1>().first = 0;
+	join.source<1>().step = 3;
+	join.source<1>().last = 31;
+
+	std::vector<int> timestamps;
+	while (join.is_active())
+	{
+		auto [a, b] = join();
+		ASSERT_EQ(a.timestamp, b.timestamp);
+		timestamps.push_back(a.timestamp);
+	}
+
+	ASSERT_EQ(timestamps, (std::vector<int>{ 15, 30 }));
+	ASSERT_FALSE(join.is_active());
+	ASSERT_THROW(join(), std::runtime_error);
+}
+
+TEST(Aligned_join, exceptions)
+{
+	using namespace aligned_join_test;
+
+	Join join;
+	setup(join, 1000, 1000);
+	join.set(aa::modules::Aligned_join_settings{ 2, 8 });
+	join.source<1>().failing_at = 31;
+
+	ASSERT_THROW(while (join.is_active()) join(), std::runtime_error);
+}
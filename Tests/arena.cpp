@@ -0,0 +1,128 @@
+/*
+Copyright 2019 Ilia S. Kovalev
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "pch.h"
+
+#include <algorithm_assembler/utils/arena.hpp>
+
+namespace arena_test
+{
+	struct Counting_resource : public std::pmr::memory_resource
+	{
+		size_t allocations = 0;
+		size_t deallocations = 0;
+
+		void* do_allocate(size_t bytes, size_t alignment) override
+		{
+			++allocations;
+			return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+		}
+
+		void do_deallocate(void* p, size_t bytes, size_t alignment) override
+		{
+			++deallocations;
+			std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+		}
+
+		bool do_is_equal(const std::pmr::memory_resource& o) const noexcept override { return this == &o; }
+	};
+}
+
+TEST(Arena, lazy_allocation)
+{
+	arena_test::Counting_resource upstream;
+
+	{
+		Monotonic_arena arena(1024, &upstream);
+		ASSERT_EQ(upstream.allocations, 0);
+		ASSERT_EQ(arena.capacity(), 0);
+	}
+
+	ASSERT_EQ(upstream.deallocations, 0);
+}
+
+TEST(Arena, alignment)
+{
+	Monotonic_arena arena(1024);
+
+	arena.allocate(1, 1);
+	auto p = arena.allocate(sizeof(double), 64);
+
+	ASSERT_EQ(reinterpret_cast<std::uintptr_t>(p) % 64, 0);
+}
+
+TEST(Arena, big_allocation)
+{
+	Monotonic_arena arena(16);
+
+	auto p = static_cast<char*>(arena.allocate(1000, 8));
+	p[999] = 'a';
+
+	ASSERT_GE(arena.capacity(), 1000);
+}
+
+TEST(Arena, reset_merges_blocks)
+{
+	arena_test::Counting_resource upstream;
+	Monotonic_arena arena(64, &upstream);
+
+	for (int i = 0; i < 10; ++i)
+		arena.allocate(60, 4);
+
+	ASSERT_GT(arena.blocks_count(), 1);
+
+	arena.reset();
+
+	ASSERT_EQ(arena.blocks_count(), 0);
+
+	for (int i = 0; i < 10; ++i)
+		arena.allocate(60, 4);
+
+	ASSERT_EQ(arena.blocks_count(), 1);
+
+	auto allocations = upstream.allocations;
+
+	for (int run = 0; run < 5; ++run)
+	{
+		arena.reset();
+		for (int i = 0; i < 10; ++i)
+			arena.allocate(60, 4);
+	}
+
+	ASSERT_EQ(upstream.allocations, allocations);
+	ASSERT_EQ(arena.blocks_count(), 1);
+}
+
+TEST(Arena, pmr_containers)
+{
+	arena_test::Counting_resource upstream;
+	Monotonic_arena arena(4096, &upstream);
+
+	for (int run = 0; run < 3; ++run)
+	{
+		arena.reset();
+
+		std::pmr::vector<int> v(&arena);
+		for (int i = 0; i < 100; ++i)
+			v.push_back(i);
+
+		std::pmr::string s("a string long enough to skip small string optimisation", &arena);
+
+		ASSERT_EQ(v[99], 99);
+	}
+
+	ASSERT_EQ(upstream.allocations, 1);
+}
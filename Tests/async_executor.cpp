@@ -0,0 +1,204 @@
+/*
+Copyright 2019 Ilia S. Kovalev
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "pch.h"
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <numeric>
+
+#include <algorithm_assembler/async_executor.hpp>
+
+#ifdef ALGORITHM_ASSEMBLER_HAS_COROUTINES
+
+namespace async_executor_test
+{
+	struct Lookup : public aa::Async_functor<int, int>
+	{
+		Thread_pool pool{ 8 };
+		std::atomic<int> waiting = 0;
+		std::atomic<int> max_waiting = 0;
+
+		Task<int> operator()(int in) override
+		{
+			co_await resume_on(pool);
+
+			int w = ++waiting;
+			int m = max_waiting;
+			while (w > m && !max_waiting.compare_exchange_weak(m, w)) {}
+
+			std::this_thread::sleep_for(std::chrono::milliseconds(5));
+			--waiting;
+
+			co_return in * 10;
+		}
+	};
+
+	struct Increment : public aa::Functor<int, int>
+	{
+		std::vector<std::thread::id> threads;
+
+		int operator()(int in) override
+		{
+			threads.push_back(std::this_thread::get_id());
+			return in + 1;
+		}
+	};
+
+	struct Cached : public aa::Async_functor<int, int>
+	{
+		Task<int> operator()(int in) override { co_return in; }
+	};
+}
+
+TEST(Async_executor, data_processor_waits_for_async_modules)
+{
+	using namespace async_executor_test;
+
+	aa::Data_processor<Increment, Lookup, Increment> f;
+
+	ASSERT_EQ(f(1), 21);
+	ASSERT_EQ(f(2), 31);
+}
+
+TEST(Async_executor, items_in_flight)
+{
+	using namespace async_executor_test;
+
+	aa::Data_processor<Increment, Lookup, Increment> f;
+	Async_executor executor(f, 16);
+
+	std::vector<int> inputs(64);
+	std::iota(inputs.begin(), inputs.end(), 0);
+
+	std::map<size_t, int> outputs;
+	executor.process(inputs, [&outputs](size_t i, int out) { outputs[i] = out; });
+
+	ASSERT_EQ(outputs.size(), inputs.size());
+	for (size_t i = 0; i < inputs.size(); ++i)
+		ASSERT_EQ(outputs[i], (inputs[i] + 1) * 10 + 1);
+
+	ASSERT_GT(f.module<1>().max_waiting.load(), 1);
+	ASSERT_LE(f.module<1>().max_waiting.load(), 8);
+
+	// Synchronous modules are called on the thread running the executor.
+	for (auto id : f.module<2>().threads)
+		ASSERT_EQ(id, std::this_thread::get_id());
+}
+
+TEST(Async_executor, modules_completing_without_suspension)
+{
+	using namespace async_executor_test;
+
+	aa::Data_processor<Cached, Increment, Cached> f;
+	Async_executor executor(f, 4);
+
+	std::vector<int> inputs{ 1, 2, 3 };
+	std::vector<int> outputs(3);
+	executor.process(inputs, [&outputs](size_t i, int out) { outputs[i] = out; });
+
+	ASSERT_EQ(outputs, (std::vector<int>{ 2, 3, 4 }));
+}
+
+namespace async_executor_test
+{
+	struct Source : public aa::Functor<int>
+	{
+		int left = 20;
+
+		int operator()() override { return left--; }
+		bool is_active() const override { return left > 0; }
+	};
+
+	struct Failing : public aa::Async_functor<int, int>
+	{
+		Thread_pool pool{ 2 };
+
+		Task<int> operator()(int in) override
+		{
+			co_await resume_on(pool);
+			if (in == 7)
+				throw std::runtime_error("failure");
+			co_return in;
+		}
+	};
+}
+
+TEST(Async_executor, sources)
+{
+	using namespace async_executor_test;
+
+	aa::Data_processor<Source, Lookup> f;
+	Async_executor executor(f);
+
+	int sum = 0;
+	size_t count = 0;
+	executor.process([&](size_t, int out) { sum += out; ++count; });
+
+	ASSERT_EQ(count, 20);
+	ASSERT_EQ(sum, 10 * 20 * 21 / 2);
+}
+
+namespace async_executor_test
+{
+	struct Scratch : public aa::Functor<int, int>, public aa::Uses_arena
+	{
+		std::pmr::memory_resource* arena = nullptr;
+
+		void set_arena(std::pmr::memory_resource& a) override { arena = &a; }
+
+		int operator()(int in) override
+		{
+			arena->allocate(16 * 1024);
+			return in;
+		}
+	};
+}
+
+TEST(Async_executor, arena_bounded)
+{
+	using namespace async_executor_test;
+
+	aa::Data_processor<Scratch, Lookup> f;
+	Async_executor executor(f, 4);
+
+	std::vector<int> inputs(100);
+	size_t count = 0;
+	executor.process(inputs, [&count](size_t, int) { ++count; });
+
+	// The arena keeps temporaries of at most 4 items, not of the whole run.
+	ASSERT_EQ(count, inputs.size());
+	ASSERT_LE(f.arena().capacity(), 256 * 1024);
+}
+
+TEST(Async_executor, exceptions)
+{
+	using namespace async_executor_test;
+
+	// A failing item completes on the executor thread, which then stops and rethrows.
+	for (int i = 0; i < 20; ++i)
+	{
+		aa::Data_processor<Source, Failing> f;
+		Async_executor executor(f, 4);
+
+		ASSERT_THROW(executor.process([](size_t, int) {}), std::runtime_error);
+	}
+
+	ASSERT_THROW(aa::Data_processor<Failing>()(7), std::runtime_error);
+}
+
+#endif
@@ -0,0 +1,247 @@
+/*
+Copyright 2019 Ilia S. Kovalev
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "pch.h"
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+
+#include <algorithm_assembler/modules/async_file_sink.hpp>
+
+using namespace algorithm_assembler::modules;
+
+namespace async_file_sink_test
+{
+	struct Temp_path
+	{
+		std::filesystem::path path;
+
+		Temp_path(const std::string& name) : path(std::filesystem::temp_directory_path() / name) {}
+		~Temp_path() { std::filesystem::remove(path); }
+
+		std::vector<char> read() const
+		{
+			std::ifstream f(path, std::ios::binary);
+			return { std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>() };
+		}
+
+		template<typename T>
+		std::vector<T> read_as() const
+		{
+			auto bytes = read();
+			std::vector<T> values(bytes.size() / sizeof(T));
+			std::memcpy(values.data(), bytes.data(), values.size() * sizeof(T));
+			return values;
+		}
+	};
+}
+
+TEST(Async_file_sink, writing)
+{
+	using namespace async_file_sink_test;
+
+	for (unsigned queue_depth : { 0u, 32u })
+	{
+		Temp_path file("aa_sink_writing.bin");
+
+		Async_file_sink<int> sink;
+		File_sink_settings settings;
+		settings.path = file.path.string();
+		settings.flush_size = 1000;
+		settings.queue_depth = queue_depth;
+		sink.set(settings);
+
+		if (queue_depth == 0)
+			ASSERT_FALSE(sink.uses_io_uring());
+
+		for (int i = 0; i < 10000; ++i)
+			sink(i);
+		sink.flush();
+
+		auto values = file.read_as<int>();
+		ASSERT_EQ(values.size(), 10000);
+		for (int i = 0; i < 10000; ++i)
+			ASSERT_EQ(values[i], i);
+	}
+}
+
+TEST(Async_file_sink, variable_size_items)
+{
+	using namespace async_file_sink_test;
+
+	Temp_path file("aa_sink_strings.bin");
+	std::string expected;
+
+	{
+		Async_file_sink<std::string> sink;
+		File_sink_settings settings;
+		settings.path = file.path.string();
+		settings.flush_size = 16;
+		sink.set(settings);
+
+		for (int i = 0; i < 100; ++i)
+		{
+			std::string s(i, static_cast<char>('a' + i % 26));
+			expected += s;
+			sink(s);
+		}
+	}
+
+	auto content = file.read();
+	ASSERT_EQ(std::string(content.begin(), content.end()), expected);
+}
+
+TEST(Async_file_sink, append)
+{
+	using namespace async_file_sink_test;
+
+	Temp_path file("aa_sink_append.bin");
+
+	File_sink_settings settings;
+	settings.path = file.path.string();
+
+	Async_file_sink<char> sink;
+	sink.set(settings);
+	sink('a');
+	sink.close();
+
+	settings.append = true;
+	sink.set(settings);
+	sink('b');
+	sink.close();
+
+	auto content = file.read();
+	ASSERT_EQ(std::string(content.begin(), content.end()), "ab");
+}
+
+TEST(Async_file_sink, flush_interval)
+{
+	using namespace async_file_sink_test;
+
+	Temp_path file("aa_sink_interval.bin");
+
+	Async_file_sink<int> sink;
+	File_sink_settings settings;
+	settings.path = file.path.string();
+	settings.flush_interval = std::chrono::milliseconds(0);
+	sink.set(settings);
+
+	for (int i = 0; i < 64; ++i)
+		sink(i);
+
+	while (sink.pending_buffers() > 0)
+		std::this_thread::yield();
+
+	ASSERT_EQ(file.read_as<int>().size(), 64);
+}
+
+TEST(Async_file_sink, idle_stream)
+{
+	using namespace async_file_sink_test;
+
+	Temp_path file("aa_sink_idle.bin");
+
+	Async_file_sink<int> sink;
+	File_sink_settings settings;
+	settings.path = file.path.string();
+	settings.flush_interval = std::chrono::milliseconds(10);
+	sink.set(settings);
+
+	sink(1);
+	sink(2);
+	sink(3);
+
+	// No more items come, the writer hands the buffer over on its own.
+	auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+	while (file.read_as<int>().size() < 3 && std::chrono::steady_clock::now() < deadline)
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+	ASSERT_EQ(file.read_as<int>(), (std::vector<int>{ 1, 2, 3 }));
+}
+
+TEST(Async_file_sink, backpressure)
+{
+	using namespace async_file_sink_test;
+
+	Temp_path file("aa_sink_backpressure.bin");
+
+	Async_file_sink<int> sink;
+	File_sink_settings settings;
+	settings.path = file.path.string();
+	settings.flush_size = sizeof(int);
+	settings.max_pending_buffers = 1;
+	sink.set(settings);
+
+	bool waited = false;
+	for (int i = 0; i < 10000; ++i)
+	{
+		waited |= !sink(i);
+		ASSERT_LE(sink.pending_buffers(), 1);
+	}
+	sink.flush();
+
+	ASSERT_TRUE(waited);
+	ASSERT_EQ(file.read_as<int>().size(), 10000);
+}
+
+TEST(Async_file_sink, errors)
+{
+	Async_file_sink<int> sink;
+	File_sink_settings settings;
+	settings.path = "aa_missing_directory/file.bin";
+
+	ASSERT_THROW(sink.set(settings), std::system_error);
+}
+
+namespace async_file_sink_test
+{
+	struct Source : public aa::Functor<double>
+	{
+		int left = 1000;
+
+		double operator()() override { return left--; }
+		bool is_active() const override { return left > 0; }
+	};
+
+	struct Square : public aa::Functor<double, double>
+	{
+		double operator()(double in) override { return in * in; }
+	};
+}
+
+TEST(Async_file_sink, data_processor)
+{
+	using namespace async_file_sink_test;
+
+	Temp_path file("aa_sink_dp.bin");
+
+	aa::Data_processor<Source, Square, Async_file_sink<double>> f;
+
+	File_sink_settings settings;
+	settings.path = file.path.string();
+	settings.flush_size = 256;
+	f.module<2>().set(settings);
+
+	while (f.module<0>().is_active())
+		f();
+	f.module<2>().flush();
+
+	auto values = file.read_as<double>();
+	ASSERT_EQ(values.size(), 1000);
+	ASSERT_EQ(values[0], 1000. * 1000.);
+	ASSERT_EQ(values[999], 1.);
+}
@@ -0,0 +1,157 @@
+/*
+Copyright 2019 Ilia S. Kovalev
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "pch.h"
+
+#include <filesystem>
+#include <fstream>
+
+#include <algorithm_assembler/modules/async_read_source.hpp>
+
+using namespace algorithm_assembler::modules;
+
+namespace async_read_source_test
+{
+	struct Temp_files
+	{
+		std::vector<std::string> paths;
+
+		/// <summary>
+		/// File i has sizes[i] bytes equal to i.
+		/// </summary>
+		Temp_files(const std::string& name, const std::vector<size_t>& sizes)
+		{
+			for (size_t i = 0; i < sizes.size(); ++i)
+			{
+				auto path = std::filesystem::temp_directory_path() / (name + std::to_string(i) + ".bin");
+				std::vector<char> content(sizes[i], static_cast<char>(i));
+				std::ofstream(path, std::ios::binary).write(content.data(), content.size());
+				paths.push_back(path.string());
+			}
+		}
+
+		~Temp_files()
+		{
+			for (auto& p : paths)
+				std::filesystem::remove(p);
+		}
+	};
+
+	void check_reading(const std::vector<size_t>& sizes, size_t chunk_size, size_t queue_depth, bool use_io_uring)
+	{
+		Temp_files files("aa_async_read_", sizes);
+
+		Async_read_source source;
+		Async_read_settings settings;
+		settings.paths = files.paths;
+		settings.chunk_size = chunk_size;
+		settings.queue_depth = queue_depth;
+		settings.use_io_uring = use_io_uring;
+		source.set(settings);
+
+		if (!use_io_uring)
+			ASSERT_FALSE(source.uses_io_uring());
+
+		std::vector<size_t> read(sizes.size(), 0);
+		while (source.is_active())
+		{
+			auto chunk = source();
+			ASSERT_EQ(chunk.offset, read[chunk.file]);
+			for (auto b : chunk.data)
+				ASSERT_EQ(b, static_cast<std::byte>(chunk.file));
+
+			// Chunks go in file order.
+			for (size_t i = chunk.file + 1; i < sizes.size(); ++i)
+				ASSERT_EQ(read[i], 0);
+
+			read[chunk.file] += chunk.data.size();
+		}
+
+		ASSERT_EQ(read, sizes);
+	}
+}
+
+TEST(Async_read_source, reading)
+{
+	using namespace async_read_source_test;
+
+	for (bool use_io_uring : { true, false })
+	{
+		check_reading({ 10, 20, 30 }, 64, 4, use_io_uring);
+		check_reading({ 1000, 1, 4096, 333 }, 100, 3, use_io_uring);
+		check_reading({ 100 }, 7, 1, use_io_uring);
+	}
+}
+
+TEST(Async_read_source, empty_files)
+{
+	using namespace async_read_source_test;
+
+	for (bool use_io_uring : { true, false })
+	{
+		check_reading({ 0, 10, 0, 0, 5, 0 }, 4, 2, use_io_uring);
+		check_reading({ 0 }, 4, 2, use_io_uring);
+	}
+}
+
+TEST(Async_read_source, errors)
+{
+	Async_read_source source;
+	ASSERT_FALSE(source.is_active());
+
+	Async_read_settings settings;
+	settings.paths = { "aa_missing_file.bin" };
+	ASSERT_THROW(source.set(settings), std::filesystem::filesystem_error);
+
+	settings.chunk_size = 0;
+	ASSERT_THROW(source.set(settings), std::invalid_argument);
+
+	settings.chunk_size = std::size_t{ 1 } << 32;
+	ASSERT_THROW(source.set(settings), std::invalid_argument);
+}
+
+namespace async_read_source_test
+{
+	struct Sum : public aa::Functor<size_t, File_chunk>
+	{
+		size_t operator()(File_chunk chunk) override
+		{
+			size_t s = 0;
+			for (auto b : chunk.data)
+				s += static_cast<size_t>(b);
+			return s;
+		}
+	};
+}
+
+TEST(Async_read_source, data_processor)
+{
+	using namespace async_read_source_test;
+
+	Temp_files files("aa_async_read_dp_", { 10, 10, 10 });
+
+	aa::Data_processor<Async_read_source, Sum> f;
+
+	Async_read_settings settings;
+	settings.paths = files.paths;
+	f.module<0>().set(settings);
+
+	size_t sum = 0;
+	while (f.module<0>().is_active())
+		sum += f();
+
+	ASSERT_EQ(sum, 10 * (0 + 1 + 2));
+}
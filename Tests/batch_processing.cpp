@@ -0,0 +1,336 @@
+/*
+Copyright 2019 Ilia S. Kovalev
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "pch.h"
+
+namespace batch_processing_test
+{
+	struct Scale : public aa::Batch_functor<float, float>
+	{
+		size_t batches = 0;
+
+		void process_batch(Span<float> outs, Span<const float> ins) override
+		{
+			++batches;
+			for (size_t i = 0; i < outs.size(); ++i)
+				outs[i] = ins[i] * 2;
+		}
+	};
+
+	struct Offset : public aa::Functor<float, float>
+	{
+		size_t calls = 0;
+
+		float operator()(float in) override
+		{
+			++calls;
+			return in + 1;
+		}
+	};
+
+	struct Split : public aa::Functor<std::tuple<float, int>, float>
+	{
+		std::tuple<float, int> operator()(float in) override { return { in, static_cast<int>(in) * 10 }; }
+	};
+
+	struct Sum : public aa::Batch_functor<double, float, int>
+	{
+		size_t batches = 0;
+
+		void process_batch(Span<double> outs, Span<const float> fs, Span<const int> is) override
+		{
+			++batches;
+			for (size_t i = 0; i < outs.size(); ++i)
+				outs[i] = fs[i] + is[i];
+		}
+	};
+
+	struct Sum_scalar : public aa::Functor<double, float, int>
+	{
+		double operator()(float f, int i) override { return f + i; }
+	};
+}
+
+TEST(Batch_processing, batch_functor_as_functor)
+{
+	using namespace batch_processing_test;
+
+	Scale s;
+	ASSERT_EQ(s(2.f), 4.f);
+	ASSERT_EQ(s.batches, 1);
+
+	Sum sum;
+	ASSERT_EQ(sum(1.5f, 2), 3.5);
+}
+
+TEST(Batch_processing, is_batch_functor)
+{
+	using namespace batch_processing_test;
+
+	static_assert(is_batch_functor_v<Scale>);
+	static_assert(!is_batch_functor_v<Offset>);
+
+	static_assert(is_batch_storable_v<float>);
+	static_assert(is_batch_storable_v<std::tuple<float, int>>);
+	static_assert(!is_batch_storable_v<float&>);
+	static_assert(!is_batch_storable_v<std::tuple<float&, int>>);
+}
+
+TEST(Batch_processing, mixed_modules)
+{
+	using namespace batch_processing_test;
+
+	aa::Data_processor<Scale, Offset, Scale, Split, Sum> f;
+
+	std::vector<float> ins{ 1.f, 2.f, 3.f, 4.f };
+	std::vector<double> outs(ins.size());
+
+	f.process_batch(outs, ins);
+
+	for (size_t i = 0; i < ins.size(); ++i)
+	{
+		float v = (ins[i] * 2 + 1) * 2;
+		ASSERT_EQ(outs[i], v + static_cast<int>(v) * 10);
+		ASSERT_EQ(outs[i], f(ins[i]));
+	}
+
+	ASSERT_EQ(f.module<0>().batches, 1 + ins.size());
+	ASSERT_EQ(f.module<1>().calls, 2 * ins.size());
+	ASSERT_EQ(f.module<4>().batches, 1 + ins.size());
+}
+
+TEST(Batch_processing, several_inputs)
+{
+	using namespace batch_processing_test;
+
+	aa::Data_processor<Sum, Offset> f1;
+	aa::Data_processor<Sum_scalar, Offset> f2;
+
+	std::vector<float> fs{ 1.f, 2.f, 3.f };
+	std::vector<int> is{ 10, 20, 30 };
+	std::vector<float> outs1(3);
+	std::vector<float> outs2(3);
+
+	f1.process_batch(outs1, fs, is);
+	f2.process_batch(outs2, fs, is);
+
+	for (size_t i = 0; i < fs.size(); ++i)
+	{
+		ASSERT_EQ(outs1[i], fs[i] + is[i] + 1);
+		ASSERT_EQ(outs2[i], fs[i] + is[i] + 1);
+	}
+}
+
+namespace batch_processing_test
+{
+	struct Counter_source : public aa::Functor<float>
+	{
+		int left = 5;
+
+		float operator()() override { return static_cast<float>(left--); }
+		bool is_active() const override { return left > 0; }
+	};
+
+	struct Iota_source : public aa::Batch_functor<float>
+	{
+		float next = 0;
+
+		size_t process_batch(Span<float> outs) override
+		{
+			for (auto& o : outs)
+				o = next++;
+			return outs.size();
+		}
+
+		bool is_active() const override { return true; }
+	};
+}
+
+TEST(Batch_processing, sources)
+{
+	using namespace batch_processing_test;
+
+	aa::Data_processor<Counter_source, Scale> f;
+	std::vector<float> outs(4);
+
+	ASSERT_EQ(f.process_batch(outs), 4);
+	ASSERT_EQ(outs, (std::vector<float>{ 10.f, 8.f, 6.f, 4.f }));
+
+	ASSERT_EQ(f.process_batch(outs), 1);
+	ASSERT_EQ(outs[0], 2.f);
+
+	ASSERT_EQ(f.process_batch(outs), 0);
+
+	aa::Data_processor<Iota_source, Offset> g;
+
+	ASSERT_EQ(g.process_batch(outs), 4);
+	ASSERT_EQ(outs, (std::vector<float>{ 1.f, 2.f, 3.f, 4.f }));
+	ASSERT_EQ(g(), 5.f);
+}
+
+namespace batch_processing_test
+{
+	struct Gain_generator :
+		public aa::Functor<float, float>,
+		public aa::Generates<Types_with_policy<Updating_policy::always, double>>
+	{
+		double gain = 3;
+		size_t gets = 0;
+
+		template<typename T, class F>
+		static T get(F& f) { ++f.gets; return f.gain; }
+
+		float operator()(float in) override
+		{
+			gain = in;
+			return in;
+		}
+	};
+
+	struct Gain : public aa::Functor<float, float>, public aa::Demands<double>
+	{
+		double gain = 0;
+		size_t sets = 0;
+
+		void set(const double& g) override { ++sets; gain = g; }
+		float operator()(float in) override { return static_cast<float>(in * gain); }
+	};
+}
+
+TEST(Batch_processing, aux_data_per_item)
+{
+	using namespace batch_processing_test;
+
+	aa::Data_processor<Gain_generator, Scale, Gain> f;
+
+	std::vector<float> ins{ 1.f, 2.f, 3.f };
+	std::vector<float> outs(3);
+
+	f.process_batch(outs, ins);
+
+	// Gain changes from item to item, so the batch is processed item by item.
+	ASSERT_EQ(outs, (std::vector<float>{ 2.f, 8.f, 18.f }));
+	ASSERT_EQ(f.module<0>().gets, 3);
+	ASSERT_EQ(f.module<2>().sets, 3);
+
+	for (size_t i = 0; i < ins.size(); ++i)
+		ASSERT_EQ(outs[i], f(ins[i]));
+}
+
+namespace batch_processing_test
+{
+	struct Length : public aa::Functor<size_t, std::string&&>
+	{
+		size_t operator()(std::string&& in) override
+		{
+			std::string consumed = std::move(in);
+			return consumed.size();
+		}
+	};
+}
+
+TEST(Batch_processing, caller_columns_kept)
+{
+	using namespace batch_processing_test;
+
+	aa::Data_processor<Length> f;
+
+	std::vector<std::string> ins{ "a", "bc", "def" };
+	std::vector<size_t> outs(3);
+
+	f.process_batch(outs, ins);
+
+	ASSERT_EQ(outs, (std::vector<size_t>{ 1, 2, 3 }));
+	ASSERT_EQ(ins, (std::vector<std::string>{ "a", "bc", "def" }));
+}
+
+TEST(Batch_processing, columns_allocation)
+{
+	using namespace batch_processing_test;
+
+	aa::Data_processor<Scale, Offset, Split, Sum> f;
+
+	std::vector<float> ins(1000, 1.f);
+	std::vector<double> outs(1000);
+
+	f.process_batch(outs, ins);
+	f.process_batch(outs, ins);
+
+	auto copy = f;
+	copy.process_batch(outs, ins);
+
+	ASSERT_EQ(outs[999], 3.f + 30);
+}
+
+namespace batch_processing_test
+{
+	using Calibration = std::vector<float>;
+
+	struct Calibration_source :
+		public aa::Functor<float, float>,
+		public aa::Generates<Types_with_policy<Updating_policy::never, Contiguous<Calibration>>>
+	{
+		template<typename T, class F>
+		static T get(F&) { return Calibration{ 1.f, 2.f, 3.f }; }
+
+		float operator()(float in) override { return in; }
+	};
+
+	struct Calibration_scaler :
+		public aa::Functor<float, float>,
+		public aa::Transforms<Types_with_policy<Updating_policy::always, Contiguous<Calibration>>>
+	{
+		size_t kernel_calls = 0;
+
+		void transform(Span<float> data) override
+		{
+			++kernel_calls;
+			for (auto& d : data)
+				d *= 10;
+		}
+
+		float operator()(float in) override { return in; }
+	};
+
+	struct Calibrated : public aa::Functor<float, float>, public aa::Demands<Calibration>
+	{
+		Calibration calibration;
+
+		void set(const Calibration& c) override { calibration = c; }
+		float operator()(float in) override { return in * calibration[static_cast<size_t>(in)]; }
+	};
+}
+
+TEST(Batch_processing, contiguous_transform_once_per_batch)
+{
+	using namespace batch_processing_test;
+
+	static_assert(std::is_base_of_v<detail::Generates_type<Calibration>, Calibration_source>);
+
+	aa::Data_processor<Calibration_source, Calibration_scaler, Calibrated> f;
+
+	std::vector<float> ins{ 0.f, 1.f, 2.f };
+	std::vector<float> outs(3);
+
+	f.process_batch(outs, ins);
+
+	ASSERT_EQ(outs, (std::vector<float>{ 0.f, 20.f, 60.f }));
+	ASSERT_EQ(f.module<1>().kernel_calls, 1);
+	ASSERT_EQ(f.module<2>().calibration, (Calibration{ 10.f, 20.f, 30.f }));
+
+	ASSERT_EQ(f(2.f), 60.f);
+	ASSERT_EQ(f.module<1>().kernel_calls, 2);
+}
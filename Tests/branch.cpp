@@ -0,0 +1,183 @@
+/*
+Copyright 2019 Ilia S. Kovalev
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "pch.h"
+
+#include <numeric>
+#include <vector>
+
+#include <algorithm_assembler/branch.hpp>
+
+namespace branch_test
+{
+	struct Is_even
+	{
+		bool operator()(int in) const { return in % 2 == 0; }
+	};
+
+	struct Half : public aa::Functor<int, int>
+	{
+		size_t calls = 0;
+		int operator()(int in) override { ++calls; return in / 2; }
+	};
+
+	struct Triple : public aa::Functor<int, int>
+	{
+		size_t calls = 0;
+		int operator()(int in) override { ++calls; return in * 3; }
+	};
+
+	struct Scaled : public aa::Functor<int, int>, public aa::Demands<double>
+	{
+		double gain = 1;
+
+		int operator()(int in) override { return static_cast<int>(in * gain); }
+		void set(const double& g) override { gain = g; }
+	};
+
+	struct Gain :
+		public aa::Functor<int, int>,
+		public aa::Generates<Types_with_policy<Updating_policy::always, double>>
+	{
+		double gain = 1;
+
+		template<typename T, class F>
+		static T get(F& f) { return f.gain; }
+
+		int operator()(int in) override { return in; }
+	};
+
+	struct Labeled :
+		public aa::Functor<int, int>,
+		public aa::Generates<Types_with_policy<Updating_policy::always, std::string>>
+	{
+		std::string label;
+
+		template<typename T, class F>
+		static T get(F& f) { return f.label; }
+
+		int operator()(int in) override { label = "odd " + std::to_string(in); return in; }
+	};
+
+	struct Summed : public aa::Functor<int, int>, public aa::Uses_arena
+	{
+		std::pmr::memory_resource* arena = nullptr;
+
+		void set_arena(std::pmr::memory_resource& a) override { arena = &a; }
+
+		int operator()(int in) override
+		{
+			std::pmr::vector<int> ones(in, 1, arena);
+			return std::accumulate(ones.begin(), ones.end(), 0);
+		}
+	};
+
+	struct Last_label : public aa::Functor<int, int>, public aa::Demands<std::string>
+	{
+		std::string label;
+		size_t sets = 0;
+
+		int operator()(int in) override { return in; }
+		void set(const std::string& l) override { label = l; ++sets; }
+	};
+}
+
+TEST(Branch, routing)
+{
+	using namespace branch_test;
+
+	aa::Data_processor<Branch<Is_even, aa::Data_processor<Half, Half>, Triple>> f;
+
+	ASSERT_EQ(f(8), 2);
+	ASSERT_EQ(f(3), 9);
+	ASSERT_EQ(f(12), 3);
+
+	auto& branch = f.module<0>();
+	ASSERT_EQ((branch.module<0, 0>().calls), 2);
+	ASSERT_EQ((branch.module<0, 1>().calls), 2);
+	ASSERT_EQ((branch.module<1, 0>().calls), 1);
+}
+
+TEST(Branch, demanded_data)
+{
+	using namespace branch_test;
+
+	aa::Data_processor<Gain, Branch<Is_even, Scaled, Triple>> f;
+
+	ASSERT_EQ(f(4), 4);
+	f.module<0>().gain = 2;
+	ASSERT_EQ(f(4), 8);
+	ASSERT_EQ(f(3), 9);
+}
+
+TEST(Branch, arena)
+{
+	using namespace branch_test;
+
+	aa::Data_processor<Branch<Is_even, Summed, aa::Data_processor<Triple, Summed>>> f;
+
+	ASSERT_EQ(f(4), 4);
+	ASSERT_EQ(f(3), 9);
+
+	auto& branch = f.module<0>();
+	ASSERT_NE((branch.module<0, 0>().arena), nullptr);
+	ASSERT_NE((branch.module<1, 1>().arena), nullptr);
+}
+
+TEST(Branch, generated_data)
+{
+	using namespace branch_test;
+
+	aa::Data_processor<Branch<Is_even, Half, aa::Data_processor<Labeled, Triple>>, Last_label> f;
+
+	ASSERT_EQ(f(3), 9);
+	ASSERT_EQ(f.module<1>().label, "odd 3");
+	ASSERT_EQ(f.module<1>().sets, 1);
+
+	ASSERT_EQ(f(4), 2);
+	ASSERT_EQ(f.module<1>().label, "odd 3");
+	ASSERT_EQ(f.module<1>().sets, 1);
+
+	ASSERT_EQ(f(5), 15);
+	ASSERT_EQ(f.module<1>().label, "odd 5");
+	ASSERT_EQ(f.module<1>().sets, 2);
+}
+
+TEST(Branch, nested)
+{
+	using namespace branch_test;
+
+	struct Is_small
+	{
+		bool operator()(int in) const { return in < 10; }
+	};
+
+	aa::Data_processor<Branch<Is_small, Branch<Is_even, Half, Triple>, Scaled>> f;
+
+	ASSERT_EQ(f(4), 2);
+	ASSERT_EQ(f(5), 15);
+	ASSERT_EQ(f(20), 20);
+}
+
+TEST(Branch, data_processor_demands)
+{
+	using namespace branch_test;
+
+	aa::Data_processor<Half, Scaled> f;
+	f.set(3.);
+
+	ASSERT_EQ(f(4), 6);
+}
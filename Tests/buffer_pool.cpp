@@ -0,0 +1,166 @@
+/*
+Copyright 2019 Ilia S. Kovalev
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "pch.h"
+
+#include <thread>
+
+#include <algorithm_assembler/utils/buffer_pool.hpp>
+
+TEST(Buffer_pool, recycling)
+{
+	Buffer_pool<std::vector<int>> pool;
+
+	int* data = nullptr;
+	{
+		auto b = pool.acquire(1000, 1);
+		ASSERT_EQ(b->size(), 1000);
+		data = b->data();
+		ASSERT_EQ(pool.free_count(), 0);
+	}
+
+	ASSERT_EQ(pool.free_count(), 1);
+
+	auto b = pool.acquire(10, 0);
+	ASSERT_EQ(b->data(), data);
+	ASSERT_EQ(b->size(), 1000);
+	ASSERT_EQ(pool.created_count(), 1);
+}
+
+TEST(Buffer_pool, max_free)
+{
+	Buffer_pool<int> pool(1);
+
+	{
+		auto b1 = pool.acquire();
+		auto b2 = pool.acquire();
+	}
+
+	ASSERT_EQ(pool.created_count(), 2);
+	ASSERT_EQ(pool.free_count(), 1);
+}
+
+TEST(Buffer_pool, reserve)
+{
+	Buffer_pool<std::string> pool;
+	pool.reserve(3, "abc"s);
+
+	ASSERT_EQ(pool.free_count(), 3);
+
+	auto b = pool.acquire();
+	ASSERT_EQ(*b, "abc"s);
+	ASSERT_EQ(pool.created_count(), 3);
+
+	Buffer_pool<std::string> small_pool(2);
+	small_pool.reserve(5);
+
+	ASSERT_EQ(small_pool.free_count(), 2);
+	ASSERT_EQ(small_pool.created_count(), 2);
+}
+
+TEST(Buffer_pool, handle_moving)
+{
+	Buffer_pool<int> pool;
+
+	Pooled<int> h;
+	ASSERT_FALSE(h);
+
+	{
+		auto b = pool.acquire(5);
+		h = std::move(b);
+		ASSERT_FALSE(b);
+	}
+
+	ASSERT_EQ(pool.free_count(), 0);
+	ASSERT_EQ(*h, 5);
+
+	h.release();
+	ASSERT_FALSE(h);
+	ASSERT_EQ(pool.free_count(), 1);
+}
+
+TEST(Buffer_pool, handle_outlives_pool)
+{
+	Pooled<int> h;
+	{
+		Buffer_pool<int> pool;
+		h = pool.acquire(1);
+	}
+
+	ASSERT_EQ(*h, 1);
+	h.release();
+}
+
+TEST(Buffer_pool, release_from_other_thread)
+{
+	Buffer_pool<int> pool;
+
+	auto h = pool.acquire(1);
+	std::thread t([h = std::move(h)]() mutable { h.release(); });
+	t.join();
+
+	ASSERT_EQ(pool.free_count(), 1);
+}
+
+namespace buffer_pool_test
+{
+	using Frame = std::vector<unsigned char>;
+
+	struct Source : public aa::Functor<Pooled<Frame>>
+	{
+		Buffer_pool<Frame> pool;
+		unsigned char value = 0;
+
+		Pooled<Frame> operator()() override
+		{
+			auto frame = pool.acquire(4096);
+			std::fill(frame->begin(), frame->end(), ++value);
+			return frame;
+		}
+
+		bool is_active() const override { return true; }
+	};
+
+	struct Filter : public aa::Functor<Pooled<Frame>, Pooled<Frame>&&>
+	{
+		Buffer_pool<Frame> pool;
+
+		Pooled<Frame> operator()(Pooled<Frame>&& in) override
+		{
+			auto out = pool.acquire(in->size());
+			std::transform(in->begin(), in->end(), out->begin(), [](auto v) { return v * 2; });
+			return out;
+		}
+	};
+}
+
+TEST(Buffer_pool, data_processor)
+{
+	using namespace buffer_pool_test;
+
+	aa::Data_processor<Source, Filter> f;
+
+	for (int i = 1; i <= 10; ++i)
+	{
+		auto out = f();
+		ASSERT_EQ((*out)[0], 2 * i);
+		ASSERT_EQ(f.module<0>().pool.free_count(), 1);
+	}
+
+	ASSERT_EQ(f.module<0>().pool.created_count(), 1);
+	ASSERT_EQ(f.module<1>().pool.created_count(), 1);
+	ASSERT_EQ(f.module<1>().pool.free_count(), 1);
+}
@@ -0,0 +1,171 @@
+/*
+Copyright 2019 Ilia S. Kovalev
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "pch.h"
+
+#include <thread>
+
+#include <algorithm_assembler/modules/channel_stages.hpp>
+
+namespace channel_test
+{
+	struct Counter : public aa::Functor<int>
+	{
+		int next = 0;
+		int last = 1000;
+
+		int operator()() override { return next++; }
+		bool is_active() const override { return next < last; }
+	};
+
+	struct Twice : public aa::Functor<int, int>
+	{
+		int operator()(int in) override { return in * 2; }
+	};
+
+	std::vector<int> drain(utils::Channel<int>& channel)
+	{
+		std::vector<int> values;
+		while (auto v = channel.try_pop())
+			values.push_back(*v);
+		return values;
+	}
+
+	std::vector<int> fill(Backpressure_policy policy, Channel_stats& stats)
+	{
+		Channel_settings settings;
+		settings.capacity = 4;
+		settings.policy = policy;
+		settings.sample_period = 3;
+
+		utils::Channel<int> channel(settings);
+		for (int i = 0; i < 10; ++i)
+			channel.push(i);
+
+		auto values = drain(channel);
+		stats = channel.stats();
+		return values;
+	}
+}
+
+TEST(Channel, dropping_policies)
+{
+	using namespace channel_test;
+
+	Channel_stats stats;
+
+	ASSERT_EQ(fill(Backpressure_policy::drop_oldest, stats), (std::vector<int>{ 6, 7, 8, 9 }));
+	ASSERT_EQ(stats.dropped, 6);
+	ASSERT_EQ(stats.pushed, 10);
+	ASSERT_EQ(stats.popped, 4);
+
+	ASSERT_EQ(fill(Backpressure_policy::drop_newest, stats), (std::vector<int>{ 0, 1, 2, 3 }));
+	ASSERT_EQ(stats.dropped, 6);
+
+	// Items 6 and 9 are the third ones arriving at the full channel.
+	ASSERT_EQ(fill(Backpressure_policy::sample, stats), (std::vector<int>{ 2, 3, 6, 9 }));
+	ASSERT_EQ(stats.dropped, 6);
+	ASSERT_EQ(stats.waits, 0);
+}
+
+TEST(Channel, blocking)
+{
+	using namespace channel_test;
+
+	Channel_settings settings;
+	settings.capacity = 2;
+	utils::Channel<int> channel(settings);
+
+	std::thread producer([&channel]() {
+		for (int i = 0; i < 100; ++i)
+			channel.push(i);
+		channel.close();
+	});
+
+	std::vector<int> values;
+	while (auto v = channel.pop())
+	{
+		ASSERT_LE(channel.size(), 2);
+		values.push_back(*v);
+	}
+	producer.join();
+
+	ASSERT_EQ(values.size(), 100);
+	for (int i = 0; i < 100; ++i)
+		ASSERT_EQ(values[i], i);
+	ASSERT_EQ(channel.stats().dropped, 0);
+
+	ASSERT_FALSE(channel.push(1));
+	ASSERT_EQ(channel.stats().dropped, 1);
+}
+
+TEST(Channel, pipelines)
+{
+	using namespace channel_test;
+
+	Channel_settings settings;
+	settings.capacity = 8;
+	settings.policy = Backpressure_policy::drop_newest;
+	utils::Channel<int> channel(settings);
+
+	aa::Data_processor<modules::Paced<Counter>, Twice, modules::Channel_sink<int>> producer;
+	producer.module<0>().pace_by(channel);
+	producer.module<2>().connect(channel);
+
+	aa::Data_processor<modules::Channel_source<int>, Twice> consumer;
+	consumer.module<0>().connect(channel);
+
+	std::thread producing([&]() {
+		while (producer.is_active())
+			producer();
+		channel.close();
+	});
+
+	std::vector<int> values;
+	while (consumer.is_active())
+		values.push_back(consumer());
+	producing.join();
+
+	// Paced source waits for the consumer, so nothing is dropped.
+	ASSERT_EQ(values.size(), 1000);
+	for (int i = 0; i < 1000; ++i)
+		ASSERT_EQ(values[i], i * 4);
+	ASSERT_EQ(channel.stats().dropped, 0);
+}
+
+TEST(Channel, congestion)
+{
+	Channel_settings settings;
+	settings.capacity = 10;
+	settings.high_watermark = 6;
+	settings.low_watermark = 2;
+	utils::Channel<int> channel(settings);
+
+	for (int i = 0; i < 5; ++i)
+		channel.push(i);
+	ASSERT_FALSE(channel.is_congested());
+
+	channel.push(5);
+	ASSERT_TRUE(channel.is_congested());
+
+	for (int i = 0; i < 3; ++i)
+		channel.pop();
+	ASSERT_TRUE(channel.is_congested());
+
+	channel.pop();
+	ASSERT_FALSE(channel.is_congested());
+	channel.wait_until_relieved();
+}
@@ -18,6 +18,8 @@ Copyright 2019 Ilia S. Kovalev
 
 #include "test_objects.hpp"
 
+#include <numeric>
+
 INI_TEST_OBJECT(0)
 INI_TEST_OBJECT(1)
 INI_TEST_OBJECT(2)
@@ -121,6 +123,95 @@ TEST(Data_processor, processor_simple)
 }
 
 
+TEST(Data_processor, nested_processors_are_flattened)
+{
+	reset_counters<0>();
+
+	struct F : public aa::Functor<
+		Test_data<string, 0>&,
+		Test_data<string, 0>&
+	>
+	{
+		Test_data<string, 0>& operator()(Test_data<string, 0>& in) override
+		{
+			in.data += "processed "s;
+			return in;
+		}
+	};
+
+	struct G : public aa::Functor<
+		Test_data<string, 0>&,
+		Test_data<string, 0>&
+	>
+	{
+		Test_data<string, 0>& operator()(Test_data<string, 0>& in) override
+		{
+			in.data += "finished"s;
+			return in;
+		}
+	};
+
+	using Inner = aa::Data_processor<F, F>;
+	using Outer = aa::Data_processor<Inner, aa::Data_processor<Inner, G>>;
+
+	static_assert(is_same_v<Inner::Modules_list, Typelist<F, F>>);
+	static_assert(is_same_v<Outer::Modules_list, Typelist<F, F, F, F, G>>);
+
+	Outer f;
+
+	Test_data<string, 0> in("input "s);
+
+	auto&& out = f(in);
+
+	ASSERT_EQ(out, "input processed processed processed processed finished"s);
+
+	ASSERT_EQ(Test_object<0>::default_counter, 0);
+	ASSERT_EQ(Test_object<0>::copy_counter, 0);
+	ASSERT_EQ(Test_object<0>::move_counter, 0);
+	ASSERT_EQ(Test_object<0>::other_counter, 1);
+}
+
+
+TEST(Data_processor, arena)
+{
+	struct F :
+		public aa::Functor<size_t, size_t>,
+		public aa::Uses_arena
+	{
+		std::pmr::memory_resource* arena = nullptr;
+
+		void set_arena(std::pmr::memory_resource& a) override { arena = &a; }
+
+		size_t operator()(size_t n) override
+		{
+			std::pmr::vector<size_t> v(n, 1, arena);
+			return std::accumulate(v.begin(), v.end(), size_t(0));
+		}
+	};
+
+	struct G : public aa::Functor<size_t, size_t>
+	{
+		size_t operator()(size_t n) override { return n; }
+	};
+
+	aa::Data_processor<G, F> f;
+
+	ASSERT_EQ(f.module<1>().arena, &f.arena());
+	ASSERT_EQ(f(100), 100);
+
+	auto capacity = f.arena().capacity();
+	ASSERT_GT(capacity, 0);
+
+	for (int i = 0; i < 10; ++i)
+		ASSERT_EQ(f(100), 100);
+
+	ASSERT_EQ(f.arena().capacity(), capacity);
+	ASSERT_EQ(f.arena().blocks_count(), 1);
+
+	static_assert(is_empty_v<DP_Arena<false>>);
+}
+
+
 TEST(Data_processor_detail, is_types_with_policy)
 {
 	using types1 = Types_with_policy<Updating_policy::never, void>;
@@ -129,6 +220,32 @@ TEST(Data_processor_detail, is_types_with_policy)
 	static_assert(!is_types_with_policy<Updating_policy::always>::predicate<types1>::value);
 }
 
+TEST(Data_processor_detail, is_data_processor)
+{
+	struct F : public aa::Functor<int, int>
+	{
+		int operator()(int i) override { return i; }
+	};
+
+	static_assert(is_data_processor_v<aa::Data_processor<F>>);
+	static_assert(!is_data_processor_v<F>);
+}
+
+TEST(Data_processor_detail, flatten_modules)
+{
+	struct F1 {};
+	struct F2 {};
+	struct F3 : public aa::Functor<int, int>
+	{
+		int operator()(int i) override { return i; }
+	};
+
+	static_assert(is_same_v<
+		flatten_modules_t<F1, aa::Data_processor<F3, F3>, F2>,
+		Typelist<F1, F3, F3, F2>
+	>);
+}
+
 TEST(Data_processor_detail, is_generator)
 {
 	struct D : public aa::Generates<Types_with_policy<Updating_policy::always, int, float>> {};
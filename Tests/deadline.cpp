@@ -0,0 +1,145 @@
+/*
+Copyright 2019 Ilia S. Kovalev
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "pch.h"
+
+#include <algorithm_assembler/deadline.hpp>
+
+namespace deadline_test
+{
+	struct Denoise : public aa::Functor<int, int>, public aa::Optional_stage
+	{
+		size_t calls = 0;
+
+		int operator()(int in) override { ++calls; return in * 10; }
+		std::chrono::nanoseconds required_time() const override { return std::chrono::milliseconds(5); }
+	};
+
+	struct Slow : public aa::Functor<int, int>
+	{
+		std::chrono::milliseconds delay{ 0 };
+
+		int operator()(int in) override
+		{
+			std::this_thread::sleep_for(delay);
+			return in + 1;
+		}
+	};
+
+	struct Time_left : public aa::Functor<int, int>, public aa::Demands<Deadline>
+	{
+		Deadline deadline;
+
+		int operator()(int in) override { return in; }
+		void set(const Deadline& d) override { deadline = d; }
+	};
+}
+
+TEST(Budgeted, optional_stage_skipped_without_budget)
+{
+	using namespace deadline_test;
+
+	Data_processor<Budgeted<Denoise>, Budgeted<Slow>> processor;
+	auto& denoise = processor.module<0>();
+
+	ASSERT_EQ(processor(1), 11);
+	ASSERT_EQ(denoise.stats().calls, 1u);
+
+	processor.set(Deadline::after(std::chrono::seconds(10)));
+	ASSERT_EQ(processor(2), 21);
+
+	processor.set(Deadline::after(std::chrono::milliseconds(1)));
+	ASSERT_EQ(processor(3), 4);
+	ASSERT_FALSE(denoise.has_run());
+	ASSERT_EQ(denoise.stats().calls, 2u);
+	ASSERT_EQ(denoise.stats().skipped, 1u);
+	ASSERT_EQ(denoise.module<0>().calls, 2u);
+	ASSERT_EQ(processor.module<1>().stats().calls, 3u);
+}
+
+TEST(Budgeted, misses_and_overruns_per_stage)
+{
+	using namespace deadline_test;
+
+	Data_processor<Item_budget<int>, Budgeted<Slow>, Budgeted<Time_left>> processor;
+	processor.module<0>().set_budget(std::chrono::milliseconds(2));
+
+	auto& slow = processor.module<1>();
+	slow.module<0>().delay = std::chrono::milliseconds(5);
+	slow.set_budget(std::chrono::milliseconds(1));
+
+	ASSERT_EQ(processor(1), 2);
+	ASSERT_EQ(processor(2), 3);
+
+	ASSERT_EQ(slow.stats().calls, 2u);
+	ASSERT_EQ(slow.stats().misses, 2u);
+	ASSERT_EQ(slow.stats().overruns, 2u);
+	ASSERT_GE(slow.stats().max_time, std::chrono::milliseconds(5));
+	ASSERT_LE(processor.module<2>().module<0>().deadline.remaining(), std::chrono::nanoseconds(0));
+
+	slow.module<0>().delay = std::chrono::milliseconds(0);
+	slow.reset_stats();
+	processor.module<0>().set_budget(std::chrono::seconds(10));
+
+	ASSERT_EQ(processor(3), 4);
+	ASSERT_EQ(slow.stats().misses, 0u);
+	ASSERT_EQ(processor.module<2>().stats().misses, 2u);
+}
+
+TEST(Budgeted, sub_pipeline_gets_deadline)
+{
+	using namespace deadline_test;
+
+	Budgeted<Data_processor<Slow, Time_left>> stage;
+	auto deadline = Deadline::after(std::chrono::seconds(1));
+	stage.set(deadline);
+
+	ASSERT_EQ(stage(1), 2);
+	ASSERT_EQ(stage.module<1>().deadline, deadline);
+	ASSERT_EQ(stage.stats().misses, 0u);
+}
+
+TEST(Watchdog, reports_running_stage)
+{
+	using namespace deadline_test;
+
+	Budgeted<Slow> stage;
+	stage.module<0>().delay = std::chrono::milliseconds(50);
+	stage.set_budget(std::chrono::milliseconds(5));
+
+	std::mutex mutex;
+	std::vector<std::string> reported;
+	{
+		Watchdog watchdog([&](const std::string& name, std::chrono::nanoseconds elapsed)
+			{
+				ASSERT_GT(elapsed, std::chrono::milliseconds(5));
+				std::lock_guard<std::mutex> lock(mutex);
+				reported.push_back(name);
+			},
+			std::chrono::milliseconds(1));
+		watchdog.add(stage, "slow");
+
+		stage(1);
+		stage.module<0>().delay = std::chrono::milliseconds(0);
+		stage(2);
+
+		ASSERT_EQ(watchdog.reports(), 1u);
+	}
+
+	ASSERT_EQ(reported.size(), 1u);
+	ASSERT_EQ(reported[0], "slow");
+	ASSERT_EQ(stage.stats().overruns, 1u);
+}
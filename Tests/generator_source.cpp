@@ -0,0 +1,168 @@
+/*
+Copyright 2019 Ilia S. Kovalev
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "pch.h"
+
+#include <algorithm_assembler/generator_source.hpp>
+
+#ifdef ALGORITHM_ASSEMBLER_HAS_COROUTINES
+
+namespace generator_source_test
+{
+	Batch_generator<int> iota(int n)
+	{
+		for (int i = 0; i < n; ++i)
+			co_yield i;
+	}
+
+	/// <summary>
+	/// Parses comma separated numbers, the parser state lives in the coroutine.
+	/// </summary>
+	struct Parser :
+		public aa::Generator_source<int>,
+		public aa::Uses_settings<std::string>
+	{
+		std::string text;
+		mutable size_t generated = 0;
+
+		Parser() : Generator_source(4) {}
+
+		void set(const std::string& t) override { text = t; }
+
+		Batch_generator<int> generate() const override
+		{
+			++generated;
+
+			int value = 0;
+			bool has_digits = false;
+			for (char c : text)
+			{
+				if (c == ',')
+				{
+					if (has_digits)
+						co_yield value;
+					value = 0;
+					has_digits = false;
+				}
+				else
+				{
+					value = value * 10 + (c - '0');
+					has_digits = true;
+				}
+			}
+			if (has_digits)
+				co_yield value;
+		}
+	};
+
+	struct Failing : public aa::Generator_source<int>
+	{
+		Batch_generator<int> generate() const override
+		{
+			co_yield 1;
+			throw std::runtime_error("failure");
+		}
+	};
+
+	struct Twice : public aa::Functor<int, int>
+	{
+		int operator()(int in) override { return in * 2; }
+	};
+}
+
+TEST(Batch_generator, batch_per_resumption)
+{
+	using namespace generator_source_test;
+
+	auto g = iota(10);
+
+	std::vector<int> batch(4);
+	ASSERT_EQ(g.fill(batch), 4);
+	ASSERT_EQ(batch, (std::vector<int>{ 0, 1, 2, 3 }));
+	ASSERT_EQ(g.fill(batch), 4);
+	ASSERT_EQ(g.fill(batch), 2);
+	ASSERT_EQ(batch[1], 9);
+	ASSERT_TRUE(g.done());
+	ASSERT_EQ(g.fill(batch), 0);
+}
+
+TEST(Generator_source, single_items)
+{
+	using namespace generator_source_test;
+
+	Parser p;
+	p.set("1,22,,333,4,5,6");
+
+	std::vector<int> values;
+	while (p.is_active())
+		values.push_back(p());
+
+	ASSERT_EQ(values, (std::vector<int>{ 1, 22, 333, 4, 5, 6 }));
+	ASSERT_EQ(p.generated, 1);
+	ASSERT_THROW(p(), std::runtime_error);
+	ASSERT_THROW(p(), std::runtime_error);
+
+	p.restart();
+	ASSERT_TRUE(p.is_active());
+	ASSERT_EQ(p(), 1);
+	ASSERT_EQ(p.generated, 2);
+}
+
+TEST(Generator_source, empty_generator)
+{
+	using namespace generator_source_test;
+
+	Parser p;
+	ASSERT_FALSE(p.is_active());
+}
+
+TEST(Generator_source, batches)
+{
+	using namespace generator_source_test;
+
+	std::string text;
+	for (int i = 0; i < 100; ++i)
+		text += std::to_string(i) + ",";
+
+	aa::Data_processor<Parser, Twice> f;
+	f.module<0>().set(text);
+
+	std::vector<int> outs(30);
+	std::vector<int> all;
+
+	ASSERT_EQ(f(), 0);
+	ASSERT_EQ(f(), 2);
+
+	while (f.is_active())
+	{
+		auto n = f.process_batch(outs);
+		all.insert(all.end(), outs.begin(), outs.begin() + n);
+	}
+
+	ASSERT_EQ(all.size(), 98);
+	for (int i = 0; i < 98; ++i)
+		ASSERT_EQ(all[i], (i + 2) * 2);
+}
+
+TEST(Generator_source, exceptions)
+{
+	using namespace generator_source_test;
+
+	Failing f;
+	ASSERT_THROW(f(), std::runtime_error);
+}
+
+#endif
@@ -0,0 +1,167 @@
+/*
+Copyright 2019 Ilia S. Kovalev
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "pch.h"
+
+#include <numeric>
+
+namespace incremental_processing_test
+{
+	struct Quantize : public aa::Functor<int, int>, public aa::Comparable_output
+	{
+		int operator()(int in) override { return in / 10; }
+	};
+
+	struct Expensive : public aa::Functor<int, int>
+	{
+		size_t calls = 0;
+
+		int operator()(int in) override
+		{
+			++calls;
+			if (in < 0)
+				throw std::runtime_error("failure");
+			return in;
+		}
+	};
+
+	struct Scaled : public aa::Functor<int, int>, public aa::Demands<double>
+	{
+		size_t calls = 0;
+		double gain = 1;
+
+		int operator()(int in) override { ++calls; return static_cast<int>(in * gain); }
+		void set(const double& g) override { gain = g; }
+	};
+
+	struct Gain :
+		public aa::Functor<int, int>,
+		public aa::Generates<Types_with_policy<Updating_policy::always, double>>
+	{
+		double gain = 1;
+
+		template<typename T, class F>
+		static T get(F& f) { return f.gain; }
+
+		int operator()(int in) override { return in; }
+	};
+
+	struct Frame : public aa::Functor<const std::vector<int>&, int>, public aa::Versioned_output
+	{
+		std::vector<int> frame;
+		std::uint64_t version = 0;
+
+		const std::vector<int>& operator()(int in) override
+		{
+			if (frame.empty() || frame.back() != in)
+			{
+				frame.assign(1000, in);
+				++version;
+			}
+			return frame;
+		}
+
+		std::uint64_t output_version() const override { return version; }
+	};
+
+	struct Sum : public aa::Functor<int, const std::vector<int>&>
+	{
+		size_t calls = 0;
+
+		int operator()(const std::vector<int>& in) override
+		{
+			++calls;
+			return std::accumulate(in.begin(), in.end(), 0);
+		}
+	};
+}
+
+TEST(Incremental_processing, unchanged_output)
+{
+	using namespace incremental_processing_test;
+
+	aa::Data_processor<Quantize, Expensive> f;
+
+	ASSERT_EQ(f(11), 1);
+	ASSERT_EQ(f(12), 1);
+	ASSERT_EQ(f(19), 1);
+	ASSERT_EQ(f.module<1>().calls, 1);
+
+	ASSERT_EQ(f(20), 2);
+	ASSERT_EQ(f(25), 2);
+	ASSERT_EQ(f(15), 1);
+	ASSERT_EQ(f.module<1>().calls, 3);
+
+	f.reset_last_result();
+	ASSERT_EQ(f(15), 1);
+	ASSERT_EQ(f.module<1>().calls, 4);
+}
+
+TEST(Incremental_processing, changed_aux_data)
+{
+	using namespace incremental_processing_test;
+
+	aa::Data_processor<Gain, Quantize, Scaled> f;
+
+	ASSERT_EQ(f(20), 2);
+	ASSERT_EQ(f(21), 2);
+	ASSERT_EQ(f.module<2>().calls, 1);
+
+	f.module<0>().gain = 2;
+	ASSERT_EQ(f(21), 4);
+	ASSERT_EQ(f(22), 4);
+	ASSERT_EQ(f.module<2>().calls, 2);
+}
+
+TEST(Incremental_processing, set_demanded_data)
+{
+	using namespace incremental_processing_test;
+
+	aa::Data_processor<Quantize, Scaled> f;
+
+	ASSERT_EQ(f(20), 2);
+	ASSERT_EQ(f(21), 2);
+	ASSERT_EQ(f.module<1>().calls, 1);
+
+	f.set(2.0);
+	ASSERT_EQ(f(21), 4);
+	ASSERT_EQ(f(22), 4);
+	ASSERT_EQ(f.module<1>().calls, 2);
+}
+
+TEST(Incremental_processing, versioned_output)
+{
+	using namespace incremental_processing_test;
+
+	aa::Data_processor<Frame, Sum> f;
+
+	ASSERT_EQ(f(1), 1000);
+	ASSERT_EQ(f(1), 1000);
+	ASSERT_EQ(f(2), 2000);
+	ASSERT_EQ(f(2), 2000);
+	ASSERT_EQ(f.module<1>().calls, 2);
+}
+
+TEST(Incremental_processing, exceptions)
+{
+	using namespace incremental_processing_test;
+
+	aa::Data_processor<Quantize, Expensive> f;
+
+	ASSERT_THROW(f(-15), std::runtime_error);
+	ASSERT_THROW(f(-15), std::runtime_error);
+	ASSERT_EQ(f.module<1>().calls, 2);
+}
@@ -0,0 +1,198 @@
+/*
+Copyright 2019 Ilia S. Kovalev
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "pch.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+#include <algorithm_assembler/modules/mapped_file_source.hpp>
+
+using namespace algorithm_assembler::modules;
+
+namespace mapped_file_source_test
+{
+	struct Temp_file
+	{
+		std::filesystem::path path;
+
+		Temp_file(const std::string& name, const std::vector<char>& content) :
+			path(std::filesystem::temp_directory_path() / name)
+		{
+			std::ofstream(path, std::ios::binary).write(content.data(), content.size());
+		}
+
+		~Temp_file() { std::filesystem::remove(path); }
+	};
+
+	std::vector<char> fixed_records(size_t count, size_t size)
+	{
+		std::vector<char> content(count * size);
+		for (size_t i = 0; i < content.size(); ++i)
+			content[i] = static_cast<char>(i / size);
+		return content;
+	}
+
+	std::vector<char> prefixed_records(size_t count)
+	{
+		std::vector<char> content;
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			uint32_t size = i * 37 % 1000;
+			content.resize(content.size() + sizeof(size));
+			std::memcpy(content.data() + content.size() - sizeof(size), &size, sizeof(size));
+			content.insert(content.end(), size, static_cast<char>(i));
+		}
+		return content;
+	}
+}
+
+TEST(Mapped_file_source, fixed_size_records)
+{
+	using namespace mapped_file_source_test;
+
+	Temp_file file("aa_mapped_fixed.bin", fixed_records(100, 24));
+
+	Mapped_file_source source;
+	source.set({ file.path.string(), Record_format::fixed_size, 24 });
+
+	for (int i = 0; i < 100; ++i)
+	{
+		ASSERT_TRUE(source.is_active());
+		auto record = source();
+		ASSERT_EQ(record.size(), 24);
+		ASSERT_EQ(record[0], static_cast<std::byte>(i));
+		ASSERT_EQ(record[23], static_cast<std::byte>(i));
+	}
+
+	ASSERT_FALSE(source.is_active());
+}
+
+TEST(Mapped_file_source, remapping_by_windows)
+{
+	using namespace mapped_file_source_test;
+
+	// Records cross window borders, so windows are extended.
+	Temp_file file("aa_mapped_windows.bin", fixed_records(1000, 100));
+
+	Mapped_file_source source;
+	source.set({ file.path.string(), Record_format::fixed_size, 100, 1 });
+
+	for (int i = 0; i < 1000; ++i)
+	{
+		auto record = source();
+		ASSERT_EQ(record.size(), 100);
+		ASSERT_EQ(record[0], static_cast<std::byte>(i));
+		ASSERT_EQ(record[99], static_cast<std::byte>(i));
+	}
+
+	ASSERT_FALSE(source.is_active());
+}
+
+TEST(Mapped_file_source, length_prefixed_records)
+{
+	using namespace mapped_file_source_test;
+
+	Temp_file file("aa_mapped_prefixed.bin", prefixed_records(500));
+
+	for (size_t window : { size_t{ 1 }, size_t{ 1 } << 20 })
+	{
+		Mapped_file_source source;
+		source.set({ file.path.string(), Record_format::length_prefixed, 0, window });
+
+		for (uint32_t i = 0; i < 500; ++i)
+		{
+			ASSERT_TRUE(source.is_active());
+			auto record = source();
+			ASSERT_EQ(record.size(), i * 37 % 1000);
+			for (auto b : record)
+				ASSERT_EQ(b, static_cast<std::byte>(i));
+		}
+
+		ASSERT_FALSE(source.is_active());
+	}
+}
+
+TEST(Mapped_file_source, truncated_record)
+{
+	using namespace mapped_file_source_test;
+
+	auto content = fixed_records(3, 10);
+	content.pop_back();
+	Temp_file file("aa_mapped_truncated.bin", content);
+
+	Mapped_file_source source;
+	source.set({ file.path.string(), Record_format::fixed_size, 10 });
+
+	source();
+	source();
+	ASSERT_FALSE(source.is_active());
+}
+
+TEST(Mapped_file_source, truncated_length_prefix)
+{
+	using namespace mapped_file_source_test;
+
+	auto content = prefixed_records(3);
+	content.insert(content.end(), { 1, 2 });
+	Temp_file file("aa_mapped_truncated_prefix.bin", content);
+
+	Mapped_file_source source;
+	source.set({ file.path.string(), Record_format::length_prefixed, 0, 1 });
+
+	for (int i = 0; i < 3; ++i)
+		source();
+
+	ASSERT_FALSE(source.is_active());
+	ASSERT_TRUE(source().empty());
+	ASSERT_TRUE(source().empty());
+	ASSERT_EQ(source.position(), content.size());
+}
+
+TEST(Mapped_file_source, errors)
+{
+	Mapped_file_source source;
+
+	ASSERT_FALSE(source.is_active());
+	ASSERT_THROW(source.set({ "aa_missing_file.bin", Record_format::fixed_size, 1 }), std::system_error);
+	ASSERT_THROW(source.set({ "aa_missing_file.bin", Record_format::fixed_size, 0 }), std::invalid_argument);
+}
+
+namespace mapped_file_source_test
+{
+	struct Parser : public aa::Functor<int, Record_view>
+	{
+		int operator()(Record_view record) override { return static_cast<int>(record.size()); }
+	};
+}
+
+TEST(Mapped_file_source, data_processor)
+{
+	using namespace mapped_file_source_test;
+
+	Temp_file file("aa_mapped_dp.bin", prefixed_records(10));
+
+	aa::Data_processor<Mapped_file_source, Parser> f;
+	f.module<0>().set({ file.path.string(), Record_format::length_prefixed });
+
+	std::vector<int> sizes;
+	while (f.module<0>().is_active())
+		sizes.push_back(f());
+
+	ASSERT_EQ(sizes.size(), 10);
+	ASSERT_EQ(sizes[9], 9 * 37);
+}
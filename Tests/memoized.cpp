@@ -0,0 +1,208 @@
+/*
+Copyright 2019 Ilia S. Kovalev
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "pch.h"
+
+#include <map>
+#include <random>
+
+#include <algorithm_assembler/memoized.hpp>
+
+namespace memoized_test
+{
+	struct Square :
+		public aa::Functor<int, int>,
+		public aa::Demands<int>
+	{
+		int offset = 0;
+		size_t calls = 0;
+
+		int operator()(int in) override { ++calls; return in * in + offset; }
+		void set(const int& o) override { offset = o; }
+	};
+
+	struct Offset :
+		public aa::Functor<int>,
+		public aa::Generates<Types_with_policy<Updating_policy::always, int>>
+	{
+		int offset = 0;
+
+		int operator()() override { return 3; }
+		bool is_active() const override { return true; }
+
+		template<typename T, class F>
+		static T get(F& f) { return f.offset; }
+	};
+
+	struct Scale :
+		public aa::Functor<int, int>,
+		public aa::Generates<Types_with_policy<Updating_policy::always, double>>
+	{
+		template<typename T, class F>
+		static T get(F&) { return 0.5; }
+
+		int operator()(int in) override { return in; }
+	};
+
+	struct Scaled : public aa::Functor<double, int>, public aa::Demands<double>
+	{
+		double scale = 0;
+
+		double operator()(int in) override { return in * scale; }
+		void set(const double& s) override { scale = s; }
+	};
+
+	struct Concat : public aa::Functor<std::string, const std::string&, int>
+	{
+		std::string operator()(const std::string& s, int n) override
+		{
+			std::string out;
+			for (int i = 0; i < n; ++i)
+				out += s;
+			return out;
+		}
+	};
+}
+
+TEST(Clock_cache, eviction)
+{
+	Clock_cache<int, int> cache(4);
+
+	for (int i = 0; i < 4; ++i)
+		cache.find_or_insert(i, [i]() { return i * 10; });
+	ASSERT_EQ(cache.size(), 4);
+
+	// Referenced entries get a second chance.
+	ASSERT_NE(cache.find(0), nullptr);
+	ASSERT_NE(cache.find(1), nullptr);
+
+	auto [value, is_found] = cache.find_or_insert(4, []() { return 40; });
+	ASSERT_FALSE(is_found);
+	ASSERT_EQ(value, 40);
+	ASSERT_EQ(cache.size(), 4);
+
+	ASSERT_NE(cache.find(0), nullptr);
+	ASSERT_NE(cache.find(1), nullptr);
+	ASSERT_EQ(cache.find(2), nullptr);
+	ASSERT_EQ(*cache.find(3), 30);
+}
+
+TEST(Clock_cache, random_operations)
+{
+	Clock_cache<int, int> cache(64);
+	std::map<int, int> reference;
+
+	std::mt19937 random(1);
+	for (int i = 0; i < 100000; ++i)
+	{
+		int key = random() % 256;
+
+		if (random() % 8 == 0)
+		{
+			ASSERT_EQ(cache.erase(key), reference.erase(key) > 0);
+			continue;
+		}
+
+		auto [value, is_found] = cache.find_or_insert(key, [key]() { return -key; });
+		ASSERT_EQ(value, -key);
+
+		if (!is_found)
+		{
+			reference[key] = -key;
+			if (reference.size() > 64)
+				for (auto it = reference.begin(); it != reference.end();)
+					it = cache.find(it->first) ? std::next(it) : reference.erase(it);
+		}
+		ASSERT_EQ(cache.size(), reference.size());
+	}
+}
+
+TEST(Clock_cache, throwing_make)
+{
+	Clock_cache<int, int> cache(2);
+
+	ASSERT_THROW(cache.find_or_insert(1, []() -> int { throw std::runtime_error("failure"); }), std::runtime_error);
+	ASSERT_EQ(cache.size(), 0);
+	ASSERT_EQ(cache.find(1), nullptr);
+}
+
+TEST(Memoized, hits_and_misses)
+{
+	using namespace memoized_test;
+
+	Memoized<Square, 8> f;
+
+	ASSERT_EQ(f(3), 9);
+	ASSERT_EQ(f(3), 9);
+	ASSERT_EQ(f(4), 16);
+	ASSERT_EQ(f(3), 9);
+
+	ASSERT_EQ(f.calls, 2);
+	ASSERT_EQ(f.hits(), 2);
+	ASSERT_EQ(f.misses(), 2);
+
+	for (int i = 0; i < 100; ++i)
+		ASSERT_EQ(f(i), i * i);
+	ASSERT_EQ(f.calls, 100);
+
+	f.clear_cache();
+	ASSERT_EQ(f(99), 99 * 99);
+	ASSERT_EQ(f.calls, 101);
+}
+
+TEST(Memoized, several_inputs)
+{
+	using namespace memoized_test;
+
+	Memoized<Concat> f;
+
+	ASSERT_EQ(f("ab", 2), "abab");
+	ASSERT_EQ(f("ab", 3), "ababab");
+	ASSERT_EQ(f("ab", 2), "abab");
+	ASSERT_EQ(f.hits(), 1);
+}
+
+TEST(Memoized, changed_demanded_data)
+{
+	using namespace memoized_test;
+
+	aa::Data_processor<Offset, Memoized<Square>> f;
+
+	ASSERT_EQ(f(), 9);
+	ASSERT_EQ(f(), 9);
+	ASSERT_EQ(f.module<1>().calls, 1);
+
+	// Unchanged value keeps the cache.
+	f.module<0>().offset = 0;
+	ASSERT_EQ(f(), 9);
+	ASSERT_EQ(f.module<1>().calls, 1);
+
+	f.module<0>().offset = 1;
+	ASSERT_EQ(f(), 10);
+	ASSERT_EQ(f(), 10);
+	ASSERT_EQ(f.module<1>().calls, 2);
+}
+
+TEST(Memoized, generated_data)
+{
+	using namespace memoized_test;
+
+	aa::Data_processor<Memoized<Scale>, Scaled> f;
+
+	ASSERT_EQ(f(4), 2.);
+	ASSERT_EQ(f(4), 2.);
+	ASSERT_EQ(f.module<0>().hits(), 1);
+}
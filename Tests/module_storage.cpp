@@ -0,0 +1,100 @@
+/*
+Copyright 2019 Ilia S. Kovalev
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "pch.h"
+
+#include <cstdint>
+#include <thread>
+
+namespace module_storage_test
+{
+	struct Counter : public aa::Functor<int, int>
+	{
+		size_t calls = 0;
+
+		int operator()(int in) override { ++calls; return in + 1; }
+	};
+
+	struct Scaled : public aa::Functor<int, int>, public aa::Demands<int>
+	{
+		int gain = 1;
+
+		int operator()(int in) override { return in * gain; }
+		void set(const int& g) override { gain = g; }
+	};
+
+	using Aligned = aa::Module_storage<Storage_policy::cache_aligned>;
+
+	std::uintptr_t address(const void* p)
+	{
+		return reinterpret_cast<std::uintptr_t>(p);
+	}
+}
+
+TEST(Module_storage, cache_aligned)
+{
+	using namespace module_storage_test;
+
+	aa::Data_processor<Aligned, Counter, aa::Data_processor<Counter, Scaled>> f;
+	f.set(3);
+
+	ASSERT_EQ(f(1), 9);
+	ASSERT_EQ(f.module<0>().calls, 1);
+	ASSERT_EQ(f.module<1>().calls, 1);
+
+	auto first = address(&f.module<0>());
+	auto second = address(&f.module<1>());
+	auto third = address(&f.module<2>());
+
+	ASSERT_EQ(first % utils::cache_line_size, 0);
+	ASSERT_EQ(second % utils::cache_line_size, 0);
+	ASSERT_EQ(third % utils::cache_line_size, 0);
+	ASSERT_GE(std::max(first, second) - std::min(first, second), utils::cache_line_size);
+
+	auto heap = std::make_unique<aa::Data_processor<Aligned, Counter, Counter>>();
+	ASSERT_EQ(address(&heap->module<1>()) % utils::cache_line_size, 0);
+	ASSERT_EQ((*heap)(0), 2);
+}
+
+TEST(Module_storage, compact_by_default)
+{
+	using namespace module_storage_test;
+
+	using Compact = aa::Data_processor<Counter, Counter>;
+	using Padded = aa::Data_processor<Aligned, Counter, Counter>;
+
+	ASSERT_LT(sizeof(Compact), sizeof(Padded));
+	ASSERT_TRUE((std::is_same_v<Compact::Modules_list, Padded::Modules_list>));
+	ASSERT_EQ(Compact()(5), 7);
+}
+
+TEST(Module_storage, threads)
+{
+	using namespace module_storage_test;
+
+	aa::Data_processor<Aligned, Counter, Counter> f;
+
+	std::thread other([&f]() {
+		for (int i = 0; i < 100000; ++i)
+			f.module<1>()(i);
+	});
+	for (int i = 0; i < 100000; ++i)
+		f.module<0>()(i);
+	other.join();
+
+	ASSERT_EQ(f.module<0>().calls, 100000);
+	ASSERT_EQ(f.module<1>().calls, 100000);
+}
@@ -0,0 +1,147 @@
+/*
+Copyright 2019 Ilia S. Kovalev
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "pch.h"
+
+#include <algorithm_assembler/multi_rate.hpp>
+
+namespace multi_rate_test
+{
+	struct Mean :
+		public aa::Functor<double, int>,
+		public aa::Generates<Types_with_policy<Updating_policy::always, std::string>>
+	{
+		double sum = 0;
+		size_t calls = 0;
+
+		template<typename T, class F>
+		static T get(F& f) { return "mean of " + std::to_string(f.calls); }
+
+		double operator()(int in) override
+		{
+			sum += in;
+			return sum / ++calls;
+		}
+	};
+
+	struct Scaled : public aa::Functor<int, int>, public aa::Demands<int>
+	{
+		int gain = 1;
+		size_t calls = 0;
+
+		int operator()(int in) override { ++calls; return in * gain; }
+		void set(const int& g) override { gain = g; }
+	};
+
+	struct Gain :
+		public aa::Functor<int, int>,
+		public aa::Generates<Types_with_policy<Updating_policy::always, int>>
+	{
+		int gain = 1;
+
+		template<typename T, class F>
+		static T get(F& f) { return f.gain; }
+
+		int operator()(int in) override { return in; }
+	};
+
+	struct Label : public aa::Functor<std::string, double>, public aa::Demands<std::string>
+	{
+		std::string label;
+		size_t sets = 0;
+
+		std::string operator()(double in) override { return label + " " + std::to_string(static_cast<int>(in)); }
+		void set(const std::string& l) override { label = l; ++sets; }
+	};
+
+	struct Manual_clock
+	{
+		using duration = std::chrono::milliseconds;
+		using rep = duration::rep;
+		using period = duration::period;
+		using time_point = std::chrono::time_point<Manual_clock>;
+
+		static constexpr bool is_steady = true;
+
+		static inline time_point current{};
+
+		static time_point now() noexcept { return current; }
+	};
+}
+
+TEST(Every, skipping)
+{
+	using namespace multi_rate_test;
+
+	aa::Data_processor<Every<3, Mean>, Label> f;
+
+	std::vector<std::string> outs;
+	for (int i = 0; i < 7; ++i)
+		outs.push_back(f(i * 2));
+
+	ASSERT_EQ(outs, (std::vector<std::string>{
+		"mean of 1 0", "mean of 1 0", "mean of 1 0",
+		"mean of 2 3", "mean of 2 3", "mean of 2 3",
+		"mean of 3 6" }));
+	ASSERT_EQ(f.module<0>().module<0>().calls, 3);
+	ASSERT_EQ(f.module<1>().sets, 3);
+
+	f.module<0>().reset();
+	ASSERT_EQ(f(100), "mean of 4 29");
+	ASSERT_TRUE(f.module<0>().has_run());
+	ASSERT_EQ(f(0), "mean of 4 29");
+	ASSERT_FALSE(f.module<0>().has_run());
+}
+
+TEST(Every, demanded_data)
+{
+	using namespace multi_rate_test;
+
+	aa::Data_processor<Gain, Every<2, Scaled>> f;
+
+	ASSERT_EQ(f(1), 1);
+	f.module<0>().gain = 10;
+	ASSERT_EQ(f(2), 1);
+	ASSERT_EQ(f(3), 30);
+	ASSERT_EQ(f.module<1>().module<0>().calls, 2);
+}
+
+TEST(Periodic, elapsed_time)
+{
+	using namespace multi_rate_test;
+
+	using namespace std::chrono_literals;
+
+	aa::Data_processor<Periodic<Mean, Manual_clock>, Label> f;
+	f.module<0>().set_period(10ms);
+
+	ASSERT_EQ(f(4), "mean of 1 4");
+
+	Manual_clock::current += 5ms;
+	ASSERT_EQ(f(8), "mean of 1 4");
+	ASSERT_EQ(f.module<1>().sets, 1);
+
+	Manual_clock::current += 5ms;
+	ASSERT_EQ(f(8), "mean of 2 6");
+	ASSERT_EQ(f.module<1>().sets, 2);
+
+	Manual_clock::current += 9ms;
+	ASSERT_EQ(f(0), "mean of 2 6");
+
+	f.module<0>().reset();
+	ASSERT_EQ(f(0), "mean of 3 4");
+	ASSERT_EQ(f.module<0>().module<0>().calls, 3);
+}
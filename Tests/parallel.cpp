@@ -0,0 +1,163 @@
+/*
+Copyright 2019 Ilia S. Kovalev
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "pch.h"
+
+#include <algorithm>
+#include <numeric>
+
+#include <algorithm_assembler/parallel.hpp>
+
+namespace parallel_test
+{
+	/// <summary>
+	/// Input which can not be copied.
+	/// </summary>
+	struct Frame
+	{
+		std::vector<int> values;
+
+		Frame(std::vector<int> v) : values(std::move(v)) {}
+		Frame(const Frame&) = delete;
+	};
+
+	struct Sum : public aa::Functor<int, const Frame&>
+	{
+		std::thread::id thread;
+
+		int operator()(const Frame& in) override
+		{
+			thread = std::this_thread::get_id();
+			return std::accumulate(in.values.begin(), in.values.end(), 0);
+		}
+	};
+
+	struct Max :
+		public aa::Functor<int, const Frame&>,
+		public aa::Generates<Types_with_policy<Updating_policy::always, std::string>>
+	{
+		std::thread::id thread;
+		std::string label;
+
+		template<typename T, class F>
+		static T get(F& f) { return f.label; }
+
+		int operator()(const Frame& in) override
+		{
+			thread = std::this_thread::get_id();
+			if (in.values.empty())
+				throw std::invalid_argument("empty frame");
+
+			int m = *std::max_element(in.values.begin(), in.values.end());
+			label = "max " + std::to_string(m);
+			return m;
+		}
+	};
+
+	struct Scaled_size : public aa::Functor<double, const Frame&>, public aa::Demands<double>
+	{
+		double gain = 1;
+
+		double operator()(const Frame& in) override { return in.values.size() * gain; }
+		void set(const double& g) override { gain = g; }
+	};
+
+	struct Half : public aa::Functor<double, double>
+	{
+		double operator()(double in) override { return in / 2; }
+	};
+
+	struct Gain :
+		public aa::Functor<const Frame&, const Frame&>,
+		public aa::Generates<Types_with_policy<Updating_policy::always, double>>
+	{
+		double gain = 1;
+
+		template<typename T, class F>
+		static T get(F& f) { return f.gain; }
+
+		const Frame& operator()(const Frame& in) override { return in; }
+	};
+
+	struct Join :
+		public aa::Functor<std::string, std::tuple<int, int, double>>,
+		public aa::Demands<std::string>
+	{
+		std::string label;
+
+		std::string operator()(std::tuple<int, int, double> in) override
+		{
+			auto [sum, max, size] = in;
+			return std::to_string(sum) + " " + std::to_string(max) + " " + std::to_string(static_cast<int>(size)) + " " + label;
+		}
+
+		void set(const std::string& l) override { label = l; }
+	};
+
+	using Features = aa::Parallel<Sum, Max, aa::Data_processor<Scaled_size, Half>>;
+}
+
+TEST(Parallel, join)
+{
+	using namespace parallel_test;
+
+	aa::Data_processor<Gain, Features, Join> f;
+
+	ASSERT_EQ(f(Frame({ 1, 5, 3, 4 })), "13 5 2 max 5");
+
+	f.module<0>().gain = 4;
+	ASSERT_EQ(f(Frame({ 2, 1 })), "3 2 4 max 2");
+}
+
+TEST(Parallel, threads)
+{
+	using namespace parallel_test;
+
+	Thread_pool pool(2);
+
+	aa::Data_processor<Gain, Features, Join> f;
+	auto& features = f.module<1>();
+	features.set_thread_pool(pool);
+
+	for (int i = 1; i < 100; ++i)
+	{
+		std::vector<int> values(i);
+		std::iota(values.begin(), values.end(), 0);
+
+		ASSERT_EQ(f(Frame(values)),
+			std::to_string(i * (i - 1) / 2) + " " + std::to_string(i - 1) + " " + std::to_string(i / 2) + " max " + std::to_string(i - 1));
+	}
+
+	ASSERT_EQ((features.module<0, 0>().thread), std::this_thread::get_id());
+	ASSERT_NE((features.module<1, 0>().thread), std::this_thread::get_id());
+
+	features.run_sequentially();
+	ASSERT_EQ(f(Frame({ 7 })), "7 7 0 max 7");
+	ASSERT_EQ((features.module<1, 0>().thread), std::this_thread::get_id());
+}
+
+TEST(Parallel, exceptions)
+{
+	using namespace parallel_test;
+
+	Thread_pool pool(2);
+
+	aa::Data_processor<Features> f;
+	f.module<0>().set_thread_pool(pool);
+
+	ASSERT_THROW(f(Frame({})), std::invalid_argument);
+	ASSERT_EQ(std::get<0>(f(Frame({ 1, 2 }))), 3);
+}
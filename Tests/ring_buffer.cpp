@@ -0,0 +1,96 @@
+/*
+Copyright 2019 Ilia S. Kovalev
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "pch.h"
+
+#include <numeric>
+
+#include <algorithm_assembler/modules/window.hpp>
+
+namespace ring_buffer_test
+{
+	struct Mean : public aa::Functor<float, utils::Span<const float>>
+	{
+		float operator()(utils::Span<const float> window) override
+		{
+			return std::accumulate(window.begin(), window.end(), 0.f) / window.size();
+		}
+	};
+}
+
+TEST(Ring_buffer, contiguous_view)
+{
+	Ring_buffer<int> buffer(3);
+	ASSERT_TRUE(buffer.empty());
+
+	buffer.push(1);
+	buffer.push(2);
+	ASSERT_EQ(std::vector<int>(buffer.view().begin(), buffer.view().end()), (std::vector<int>{ 1, 2 }));
+
+	for (int i = 3; i < 20; ++i)
+	{
+		buffer.push(i);
+
+		auto view = buffer.view();
+		ASSERT_TRUE(buffer.full());
+		ASSERT_EQ(std::vector<int>(view.begin(), view.end()), (std::vector<int>{ i - 2, i - 1, i }));
+		ASSERT_EQ(buffer.front(), i - 2);
+		ASSERT_EQ(buffer.back(), i);
+		ASSERT_EQ(buffer[1], i - 1);
+	}
+
+	buffer.clear();
+	ASSERT_TRUE(buffer.view().empty());
+}
+
+TEST(Ring_buffer, movable_values)
+{
+	Ring_buffer<std::string> buffer(2);
+
+	buffer.push("a"s);
+	buffer.push("b"s);
+	buffer.push("c"s);
+
+	ASSERT_EQ(buffer.view()[0], "b");
+	ASSERT_EQ(buffer.view()[1], "c");
+}
+
+TEST(Window, moving_average)
+{
+	using namespace ring_buffer_test;
+
+	aa::Data_processor<aa::modules::Window<3, float>, Mean> f;
+
+	ASSERT_EQ(f(3.f), 3.f);
+	ASSERT_EQ(f(6.f), 4.5f);
+	ASSERT_EQ(f(9.f), 6.f);
+	ASSERT_EQ(f(12.f), 9.f);
+	ASSERT_TRUE(f.module<0>().is_full());
+}
+
+TEST(Window, batch_processing)
+{
+	using namespace ring_buffer_test;
+
+	aa::Data_processor<aa::modules::Window<3, float>, Mean> f;
+
+	std::vector<float> ins{ 3.f, 6.f, 9.f, 12.f, 15.f };
+	std::vector<float> outs(ins.size());
+
+	f.process_batch(outs, ins);
+
+	ASSERT_EQ(outs, (std::vector<float>{ 3.f, 4.5f, 6.f, 9.f, 12.f }));
+}
@@ -0,0 +1,146 @@
+/*
+Copyright 2019 Ilia S. Kovalev
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "pch.h"
+
+#include <future>
+
+#include <algorithm_assembler/scheduler.hpp>
+
+namespace scheduler_test
+{
+	struct Counter : public aa::Functor<int>
+	{
+		int next = 0;
+		int last = 100;
+
+		int operator()() override { return next++; }
+		bool is_active() const override { return next < last; }
+	};
+
+	struct Twice : public aa::Functor<int, int>
+	{
+		int operator()(int in) override
+		{
+			if (in < 0)
+				throw std::invalid_argument("negative");
+			return in * 2;
+		}
+	};
+
+	struct Label : public aa::Functor<std::string, const std::string&, int>
+	{
+		std::string operator()(const std::string& s, int n) override { return s + std::to_string(n); }
+	};
+}
+
+TEST(Scheduler, sources)
+{
+	using namespace scheduler_test;
+
+	std::vector<aa::Data_processor<Counter, Twice>> processors(50);
+	std::vector<std::vector<int>> outputs(processors.size());
+
+	Scheduler scheduler(Scheduler_settings{ 4, 8 });
+	for (size_t i = 0; i < processors.size(); ++i)
+	{
+		processors[i].module<0>().last = static_cast<int>(i * 10);
+		scheduler.add_source(processors[i], [&out = outputs[i]](int v) { out.push_back(v); });
+	}
+	scheduler.wait();
+
+	for (size_t i = 0; i < processors.size(); ++i)
+	{
+		ASSERT_EQ(outputs[i].size(), i * 10);
+		for (size_t j = 0; j < outputs[i].size(); ++j)
+			ASSERT_EQ(outputs[i][j], static_cast<int>(j * 2));
+	}
+}
+
+TEST(Scheduler, inputs)
+{
+	using namespace scheduler_test;
+
+	std::vector<aa::Data_processor<Label>> processors(20);
+	std::vector<std::vector<std::string>> outputs(processors.size());
+
+	Scheduler scheduler(Scheduler_settings{ 3, 4 });
+
+	std::vector<Scheduler::Input_job<aa::Data_processor<Label>, std::function<void(std::string)>>*> jobs;
+	for (size_t i = 0; i < processors.size(); ++i)
+		jobs.push_back(&scheduler.add(processors[i],
+			std::function<void(std::string)>([&out = outputs[i]](std::string s) { out.push_back(std::move(s)); })));
+
+	for (int round = 0; round < 2; ++round)
+	{
+		for (int n = 0; n < 100; ++n)
+			for (auto job : jobs)
+				job->push("item ", n);
+		scheduler.wait();
+	}
+
+	for (auto& out : outputs)
+	{
+		ASSERT_EQ(out.size(), 200);
+		for (int n = 0; n < 200; ++n)
+			ASSERT_EQ(out[n], "item " + std::to_string(n % 100));
+	}
+	ASSERT_EQ(jobs[0]->queued(), 0);
+}
+
+TEST(Scheduler, priorities)
+{
+	using namespace scheduler_test;
+
+	aa::Data_processor<Counter> a;
+	aa::Data_processor<Counter> b;
+	a.module<0>().last = 6;
+	b.module<0>().last = 18;
+
+	std::string order;
+	std::promise<void> b_added;
+	auto b_added_future = b_added.get_future();
+
+	Scheduler scheduler(Scheduler_settings{ 1, 2 });
+	scheduler.add_source(a, [&](int v) {
+		if (v == 0)
+			b_added_future.wait();
+		order += 'a';
+	});
+	scheduler.add_source(b, [&](int) { order += 'b'; }, 3);
+	b_added.set_value();
+
+	scheduler.wait();
+	ASSERT_EQ(order, "aabbbbbbaabbbbbbaabbbbbb");
+}
+
+TEST(Scheduler, exceptions)
+{
+	using namespace scheduler_test;
+
+	aa::Data_processor<Twice> f;
+	std::vector<int> outputs;
+
+	Scheduler scheduler;
+	auto& job = scheduler.add(f, [&outputs](int v) { outputs.push_back(v); });
+	job.push(1);
+	job.push(-1);
+	job.push(2);
+
+	ASSERT_THROW(scheduler.wait(), std::invalid_argument);
+	ASSERT_EQ(outputs, (std::vector<int>{ 2, 4 }));
+	ASSERT_NO_THROW(scheduler.wait());
+}
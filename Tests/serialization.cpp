@@ -0,0 +1,241 @@
+/*
+Copyright 2019 Ilia S. Kovalev
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "pch.h"
+
+#include <algorithm_assembler/serialization.hpp>
+#include <algorithm_assembler/modules/async_read_source.hpp>
+#include <algorithm_assembler/modules/transport_stages.hpp>
+
+namespace serialization_test
+{
+	struct Point
+	{
+		float x, y;
+	};
+
+	struct Track
+	{
+		std::string name;
+		std::vector<Point> points;
+		std::optional<int> id;
+
+		template<class Archive>
+		void serialize(Archive& archive) { archive(name, points, id); }
+	};
+
+	bool operator==(const Point& l, const Point& r) { return l.x == r.x && l.y == r.y; }
+	bool operator==(const Track& l, const Track& r) { return l.name == r.name && l.points == r.points && l.id == r.id; }
+
+	struct Gain :
+		public aa::Functor<int, const int&>,
+		public aa::Generates<Types_with_policy<Updating_policy::always, double>>
+	{
+		double gain = 2;
+
+		template<typename T, class F>
+		static T get(F& f) { return f.gain; }
+
+		int operator()(const int& in) override { return static_cast<int>(in * gain); }
+	};
+
+	struct Labeled :
+		public aa::Functor<std::string, int>,
+		public aa::Generates<Types_with_policy<Updating_policy::always, std::string, double>>
+	{
+		std::string label;
+
+		template<typename T, class F>
+		static T get(F& f)
+		{
+			if constexpr (std::is_same_v<T, double>)
+				return 0.5;
+			else
+				return f.label;
+		}
+
+		std::string operator()(int in) override { return label = "value " + std::to_string(in); }
+	};
+}
+
+TEST(Serialization, round_trip)
+{
+	using namespace serialization_test;
+
+	Track track{ "first", { { 1, 2 }, { 3, 4 } }, 7 };
+	std::tuple<int, std::pair<std::string, double>, std::array<std::string, 2>> other{ 5, { "pair", 0.25 }, { "a", "bc" } };
+	std::vector<bool> flags{ true, false, true };
+
+	auto size = serialized_size(track, other, flags);
+	ASSERT_EQ(size, 8 + 5 + 8 + 2 * sizeof(Point) + 1 + sizeof(int)
+		+ sizeof(int) + 8 + 4 + sizeof(double) + 8 + 1 + 8 + 2
+		+ 8 + 3);
+
+	std::vector<std::byte> buffer(size);
+	Binary_writer writer(buffer.data(), buffer.size());
+	writer(track, other, flags);
+	ASSERT_EQ(writer.size(), size);
+
+	Track track_read;
+	decltype(other) other_read;
+	std::vector<bool> flags_read;
+	Binary_reader reader(buffer.data(), buffer.size());
+	reader(track_read, other_read, flags_read);
+
+	ASSERT_EQ(reader.remaining(), 0);
+	ASSERT_EQ(track_read, track);
+	ASSERT_EQ(other_read, other);
+	ASSERT_EQ(flags_read, flags);
+
+	writer.clear();
+	writer(Track{});
+	reader = Binary_reader(buffer.data(), writer.size());
+	ASSERT_EQ(deserialize<Track>(reader), Track{});
+}
+
+TEST(Serialization, buffer_bounds)
+{
+	using namespace serialization_test;
+
+	std::vector<std::byte> buffer(10);
+	Binary_writer writer(buffer.data(), buffer.size());
+	writer(1.0);
+	ASSERT_THROW(writer(1.0), std::length_error);
+	ASSERT_EQ(writer.size(), sizeof(double));
+
+	std::vector<int> values(100);
+	buffer.resize(serialized_size(values));
+	writer = Binary_writer(buffer.data(), buffer.size());
+	writer(values);
+
+	// A truncated buffer or a broken length must not read past the end or allocate too much.
+	Binary_reader truncated(buffer.data(), buffer.size() - 1);
+	ASSERT_THROW(deserialize<std::vector<int>>(truncated), std::length_error);
+
+	std::uint64_t huge = std::uint64_t{ 1 } << 60;
+	std::memcpy(buffer.data(), &huge, sizeof(huge));
+	Binary_reader broken(buffer.data(), buffer.size());
+	ASSERT_THROW(deserialize<std::vector<int>>(broken), std::length_error);
+
+	// Serialized size of a track is unknown, the vector grows only while tracks are read.
+	std::vector<Track> tracks(3, Track{ "track", { { 1, 2 } }, 1 });
+	buffer.resize(serialized_size(tracks));
+	writer = Binary_writer(buffer.data(), buffer.size());
+	writer(tracks);
+
+	std::memcpy(buffer.data(), &huge, sizeof(huge));
+	Binary_reader broken_tracks(buffer.data(), buffer.size());
+	ASSERT_THROW(deserialize<std::vector<Track>>(broken_tracks), std::length_error);
+}
+
+TEST(Serialization, spans)
+{
+	using namespace serialization_test;
+
+	// Spans are written with their elements and are read back as vectors.
+	std::vector<Point> points{ { 1, 2 }, { 3, 4 } };
+	std::vector<Track> tracks(2, Track{ "track", points, 1 });
+	Span<const Point> point_view(points);
+	Span<const Track> track_view(tracks);
+
+	ASSERT_EQ(serialized_size(point_view), serialized_size(points));
+	ASSERT_EQ(serialized_size(track_view), serialized_size(tracks));
+
+	std::vector<std::byte> buffer(serialized_size(point_view, track_view));
+	Binary_writer writer(buffer.data(), buffer.size());
+	writer(point_view, track_view);
+
+	Binary_reader reader(buffer.data(), buffer.size());
+	ASSERT_EQ(deserialize<std::vector<Point>>(reader), points);
+	ASSERT_EQ(deserialize<std::vector<Track>>(reader), tracks);
+	ASSERT_EQ(reader.remaining(), 0);
+
+	static_assert(is_unrestorable_v<aa::modules::File_chunk>);
+}
+
+TEST(Serialization, pipeline_types)
+{
+	using namespace serialization_test;
+
+	static_assert(std::is_same_v<inputs_tuple_t<Gain>, std::tuple<int>>);
+	static_assert(std::is_same_v<output_value_t<Gain>, int>);
+	static_assert(std::is_same_v<generated_tuple_t<Gain>, std::tuple<double>>);
+
+	using Processor = Data_processor<Gain, Labeled>;
+	static_assert(std::is_same_v<inputs_tuple_t<Processor>, std::tuple<int>>);
+	static_assert(std::is_same_v<output_value_t<Processor>, std::string>);
+	static_assert(std::is_same_v<generated_tuple_t<Processor>, std::tuple<double, std::string>>);
+
+	Gain gain;
+	ASSERT_EQ(generated_values(gain), std::make_tuple(2.0));
+
+	// The last generator of double is Labeled.
+	Processor processor;
+	processor(3);
+	ASSERT_EQ(generated_values(processor), std::make_tuple(0.5, std::string("value 6")));
+}
+
+TEST(Serialization, call_record)
+{
+	using namespace serialization_test;
+
+	Data_processor<Gain, Labeled> processor;
+	processor.module<0>().gain = 3;
+
+	auto record = record_call(processor, 2);
+	ASSERT_EQ(record.output, "value 6");
+
+	std::vector<std::byte> buffer(serialized_size(record));
+	Binary_writer(buffer.data(), buffer.size())(record);
+
+	Binary_reader reader(buffer.data(), buffer.size());
+	auto read = deserialize<Call_record<decltype(processor)>>(reader);
+	ASSERT_EQ(read.inputs, std::make_tuple(2));
+	ASSERT_EQ(read.output, "value 6");
+	ASSERT_EQ(read.generated, std::make_tuple(0.5, std::string("value 6")));
+}
+
+TEST(Serialization, binary_serializer_transport)
+{
+	using namespace serialization_test;
+
+	auto settings = modules::Transport_settings{};
+	settings.address = "127.0.0.1";
+	settings.batch_size = 8;
+
+	modules::Transport_source<Track, Binary_serializer<Track>> source;
+	source.set(settings);
+	settings.port = source.port();
+
+	modules::Transport_sink<Track, Binary_serializer<Track>> sink;
+	sink.set(settings);
+
+	std::thread producing([&]() {
+		for (int i = 0; i < 100; ++i)
+			sink(Track{ std::to_string(i), std::vector<Point>(i % 5, Point{ 1, 2 }), i });
+		sink.close();
+	});
+
+	int count = 0;
+	while (source.is_active())
+	{
+		ASSERT_EQ(source(), (Track{ std::to_string(count), std::vector<Point>(count % 5, Point{ 1, 2 }), count }));
+		++count;
+	}
+	producing.join();
+
+	ASSERT_EQ(count, 100);
+}
@@ -0,0 +1,179 @@
+/*
+Copyright 2019 Ilia S. Kovalev
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "pch.h"
+
+#include <algorithm_assembler/modules/shared_memory_stages.hpp>
+
+#ifndef _WIN32
+	#include <sys/wait.h>
+	#include <unistd.h>
+#endif
+
+namespace shared_memory_test
+{
+	struct Sample
+	{
+		int index;
+		double value;
+	};
+
+	struct Samples : public aa::Functor<Sample>
+	{
+		int next = 0;
+		int last = 1000;
+
+		Sample operator()() override { auto i = next++; return { i, i * 0.5 }; }
+		bool is_active() const override { return next < last; }
+	};
+
+	struct Index : public aa::Functor<int, const Sample&>
+	{
+		int operator()(const Sample& in) override { return in.index; }
+	};
+
+	std::string ring_name(const std::string& test)
+	{
+#ifdef _WIN32
+		return "Local\\aa_" + test + "_" + std::to_string(GetCurrentProcessId());
+#else
+		return "/aa_" + test + "_" + std::to_string(getpid());
+#endif
+	}
+}
+
+TEST(Shared_memory, values_read_in_place)
+{
+	using namespace shared_memory_test;
+
+	static_assert(modules::is_read_in_place_v<Sample, modules::Raw_serializer<Sample>>);
+
+	modules::Shared_memory_settings settings;
+	settings.name = ring_name("in_place");
+	settings.capacity = 512;
+
+	aa::Data_processor<Samples, modules::Shared_memory_sink<Sample>> producer;
+	producer.module<1>().set(settings);
+
+	aa::Data_processor<modules::Shared_memory_source<Sample>, Index> consumer;
+	consumer.module<0>().set(settings);
+
+	std::thread producing([&]() {
+		while (producer.is_active())
+			producer();
+		producer.module<1>().close();
+	});
+
+	std::vector<int> indices;
+	while (consumer.is_active())
+		indices.push_back(consumer());
+	producing.join();
+
+	ASSERT_EQ(indices.size(), 1000);
+	for (int i = 0; i < 1000; ++i)
+		ASSERT_EQ(indices[i], i);
+}
+
+TEST(Shared_memory, serialized_values)
+{
+	using namespace shared_memory_test;
+
+	modules::Shared_memory_settings settings;
+	settings.name = ring_name("serialized");
+	settings.capacity = 256;
+
+	modules::Shared_memory_sink<std::vector<int>> sink;
+	sink.set(settings);
+
+	modules::Shared_memory_source<std::vector<int>> source;
+	source.set(settings);
+
+	// Records of different sizes wrap around the small ring and make the sink wait.
+	std::thread producing([&]() {
+		for (int i = 0; i < 200; ++i)
+			sink(std::vector<int>(i % 13, i));
+		sink.close();
+	});
+
+	int count = 0;
+	while (source.is_active())
+	{
+		auto& v = source();
+		ASSERT_EQ(v, std::vector<int>(count % 13, count));
+		++count;
+	}
+	producing.join();
+
+	ASSERT_EQ(count, 200);
+	ASSERT_THROW(source(), std::runtime_error);
+}
+
+TEST(Shared_memory, errors)
+{
+	using namespace shared_memory_test;
+
+	modules::Shared_memory_settings settings;
+	settings.name = ring_name("errors");
+	settings.capacity = 64;
+
+	modules::Shared_memory_source<int> unset;
+	ASSERT_THROW(unset.is_active(), std::logic_error);
+	ASSERT_THROW(unset.set(settings), std::system_error);
+
+	modules::Shared_memory_sink<std::string> sink;
+	sink.set(settings);
+	ASSERT_THROW(sink(std::string(100, 'a')), std::length_error);
+	ASSERT_TRUE(sink(std::string(10, 'a')));
+}
+
+#ifndef _WIN32
+TEST(Shared_memory, processes)
+{
+	using namespace shared_memory_test;
+
+	modules::Shared_memory_settings settings;
+	settings.capacity = 1024;
+
+	modules::Shared_memory_sink<Sample> sink;
+	sink.set(settings);
+
+	auto child = fork();
+	ASSERT_GE(child, 0);
+
+	if (child == 0)
+	{
+		// The child reads the memfd inherited from the parent.
+		modules::Shared_memory_source<Sample> source;
+		source.open(sink.descriptor());
+
+		int expected = 0;
+		while (source.is_active())
+			if (source().index != expected++)
+				_exit(1);
+		_exit(expected == 1000 ? 0 : 2);
+	}
+
+	Samples samples;
+	while (samples.is_active())
+		sink(samples());
+	sink.close();
+
+	int status = 0;
+	waitpid(child, &status, 0);
+	ASSERT_TRUE(WIFEXITED(status));
+	ASSERT_EQ(WEXITSTATUS(status), 0);
+}
+#endif
@@ -0,0 +1,72 @@
+/*
+Copyright 2019 Ilia S. Kovalev
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "pch.h"
+
+#include <algorithm_assembler/async_functor.hpp>
+
+#ifdef ALGORITHM_ASSEMBLER_HAS_COROUTINES
+
+namespace task_test
+{
+	Task<int> value(int v) { co_return v; }
+
+	Task<int> sum(int a, int b) { co_return co_await value(a) + co_await value(b); }
+
+	Task<std::string> on_pool(Thread_pool& pool)
+	{
+		co_await resume_on(pool);
+		co_return "pool"s;
+	}
+
+	Task<> failing()
+	{
+		throw std::runtime_error("failure");
+		co_return;
+	}
+
+	Task<int> lazy(bool& started)
+	{
+		started = true;
+		co_return 1;
+	}
+}
+
+TEST(Task, sync_wait)
+{
+	using namespace task_test;
+
+	ASSERT_EQ(sync_wait(sum(1, 2)), 3);
+
+	Thread_pool pool(1);
+	ASSERT_EQ(sync_wait(on_pool(pool)), "pool"s);
+
+	ASSERT_THROW(sync_wait(failing()), std::runtime_error);
+}
+
+TEST(Task, lazy_start)
+{
+	using namespace task_test;
+
+	bool started = false;
+	auto t = lazy(started);
+	ASSERT_FALSE(started);
+
+	ASSERT_EQ(sync_wait(std::move(t)), 1);
+	ASSERT_TRUE(started);
+}
+
+#endif
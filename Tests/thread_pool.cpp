@@ -0,0 +1,108 @@
+/*
+Copyright 2019 Ilia S. Kovalev
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "pch.h"
+
+#include <algorithm>
+#include <atomic>
+
+#include <algorithm_assembler/utils/numa.hpp>
+#include <algorithm_assembler/utils/thread_pool.hpp>
+
+TEST(Thread_pool, results)
+{
+	Thread_pool pool(4);
+	ASSERT_EQ(pool.size(), 4);
+
+	std::vector<std::future<int>> results;
+	for (int i = 0; i < 100; ++i)
+		results.push_back(pool.submit([i]() { return i * i; }));
+
+	for (int i = 0; i < 100; ++i)
+		ASSERT_EQ(results[i].get(), i * i);
+}
+
+TEST(Thread_pool, exceptions)
+{
+	Thread_pool pool(1);
+
+	auto f = pool.submit([]() -> int { throw std::runtime_error("error"); });
+	ASSERT_THROW(f.get(), std::runtime_error);
+
+	ASSERT_EQ(pool.submit([]() { return 1; }).get(), 1);
+}
+
+TEST(Thread_pool, queued_tasks_are_finished)
+{
+	std::atomic<int> counter = 0;
+	{
+		Thread_pool pool(2);
+		for (int i = 0; i < 1000; ++i)
+			pool.submit([&counter]() { ++counter; });
+	}
+	ASSERT_EQ(counter, 1000);
+}
+
+TEST(Thread_pool, pinned_workers)
+{
+	Thread_pool_settings settings;
+	settings.threads = 2;
+	settings.cpus = { 0 };
+
+	Thread_pool pool(settings);
+	ASSERT_EQ(pool.size(), 2);
+	ASSERT_FALSE(pool.numa_node().has_value());
+
+	std::vector<std::future<size_t>> cpus;
+	for (int i = 0; i < 20; ++i)
+		cpus.push_back(pool.submit([]() { return detail::current_cpu(); }));
+
+	for (auto& cpu : cpus)
+		ASSERT_EQ(cpu.get(), 0);
+}
+
+TEST(Thread_pool, numa_node)
+{
+	Thread_pool_settings settings;
+	settings.numa_node = 0;
+
+	Thread_pool pool(settings);
+	ASSERT_EQ(pool.size(), detail::numa_node_cpus(0).size());
+	ASSERT_EQ(pool.numa_node(), 0);
+
+	auto node_cpus = detail::numa_node_cpus(0);
+	auto cpu = pool.submit([]() { return detail::current_cpu(); }).get();
+	ASSERT_NE(std::find(node_cpus.begin(), node_cpus.end(), cpu), node_cpus.end());
+
+	for (auto node : detail::numa_nodes())
+		ASSERT_FALSE(detail::numa_node_cpus(node).empty());
+
+	settings.numa_node = detail::numa_node_count();
+	ASSERT_THROW(Thread_pool{ settings }, std::invalid_argument);
+}
+
+TEST(Thread_pool, node_local_memory)
+{
+	Node_local<std::vector<int>> local(0, 3, 7);
+	ASSERT_EQ(local->size(), 3);
+	ASSERT_EQ((*local)[2], 7);
+	ASSERT_EQ(local.node(), 0);
+
+	std::vector<double, Numa_allocator<double>> queue(Numa_allocator<double>(0));
+	for (int i = 0; i < 10000; ++i)
+		queue.push_back(i);
+	ASSERT_EQ(queue[9999], 9999);
+}
@@ -0,0 +1,172 @@
+/*
+Copyright 2019 Ilia S. Kovalev
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "pch.h"
+
+#include <algorithm_assembler/modules/transport_stages.hpp>
+
+namespace transport_test
+{
+	struct Counter : public aa::Functor<int>
+	{
+		int next = 0;
+		int last = 10000;
+
+		int operator()() override { return next++; }
+		bool is_active() const override { return next < last; }
+	};
+
+	struct Twice : public aa::Functor<int, const int&>
+	{
+		int operator()(const int& in) override { return in * 2; }
+	};
+
+	modules::Transport_settings loopback()
+	{
+		modules::Transport_settings settings;
+		settings.address = "127.0.0.1";
+		settings.batch_size = 64;
+		settings.reconnect_interval = std::chrono::milliseconds(10);
+		return settings;
+	}
+}
+
+TEST(Transport, tcp_pipelines)
+{
+	using namespace transport_test;
+
+	auto settings = loopback();
+
+	aa::Data_processor<modules::Transport_source<int>, Twice> consumer;
+	consumer.module<0>().set(settings);
+	settings.port = consumer.module<0>().port();
+
+	aa::Data_processor<Counter, modules::Transport_sink<int>> producer;
+	producer.module<1>().set(settings);
+
+	std::thread producing([&]() {
+		while (producer.is_active())
+			producer();
+		producer.module<1>().close();
+	});
+
+	std::vector<int> values;
+	while (consumer.is_active())
+		values.push_back(consumer());
+	producing.join();
+
+	ASSERT_EQ(values.size(), 10000);
+	for (int i = 0; i < 10000; ++i)
+		ASSERT_EQ(values[i], i * 2);
+	ASSERT_EQ(producer.module<1>().reconnects(), 0);
+}
+
+#ifndef _WIN32
+TEST(Transport, unix_socket_serialized_values)
+{
+	auto settings = transport_test::loopback();
+	settings.protocol = Transport_protocol::unix_socket;
+	settings.address = "/tmp/aa_transport_" + std::to_string(getpid());
+	settings.batch_bytes = 100;
+
+	modules::Transport_source<std::string> source;
+	source.set(settings);
+
+	modules::Transport_sink<std::string> sink;
+	sink.set(settings);
+
+	std::thread producing([&]() {
+		for (int i = 0; i < 1000; ++i)
+			sink(std::string(i % 50, 'a' + i % 26));
+		sink.close();
+	});
+
+	int count = 0;
+	while (source.is_active())
+	{
+		ASSERT_EQ(source(), std::string(count % 50, 'a' + count % 26));
+		++count;
+	}
+	producing.join();
+
+	ASSERT_EQ(count, 1000);
+	ASSERT_THROW(source(), std::runtime_error);
+}
+#endif
+
+TEST(Transport, reconnect)
+{
+	auto settings = transport_test::loopback();
+	settings.batch_size = 1;
+
+	modules::Transport_source<int> source;
+	source.set(settings);
+	settings.port = source.port();
+
+	modules::Transport_sink<int> sink;
+	sink.set(settings);
+
+	std::atomic<bool> is_disconnected{ false };
+	std::thread producing([&]() {
+		int i = 0;
+		while (!is_disconnected)
+			sink(i++);
+
+		// Writes to the dropped connection fail after a few values.
+		while (sink.reconnects() == 0)
+			sink(i++);
+		for (int k = 0; k < 10; ++k)
+			sink(i++);
+
+		sink(-1);
+		sink.close();
+	});
+
+	ASSERT_TRUE(source.is_active());
+	ASSERT_EQ(source(), 0);
+	source.disconnect();
+	is_disconnected = true;
+
+	std::vector<int> values;
+	while (source.is_active())
+		values.push_back(source());
+	producing.join();
+
+	ASSERT_GE(sink.reconnects(), 1);
+	ASSERT_GE(values.size(), 11);
+	ASSERT_EQ(values.back(), -1);
+	for (std::size_t i = 1; i + 1 < values.size(); ++i)
+		ASSERT_LT(values[i - 1], values[i]);
+}
+
+TEST(Transport, errors)
+{
+	auto settings = transport_test::loopback();
+	settings.connect_attempts = 2;
+
+	modules::Transport_source<int> unset;
+	ASSERT_THROW(unset.is_active(), std::logic_error);
+
+	modules::Transport_sink<int> sink;
+	ASSERT_THROW(sink(1), std::logic_error);
+
+	{
+		modules::Transport_source<int> source;
+		source.set(settings);
+		settings.port = source.port();
+	}
+	ASSERT_THROW(sink.set(settings), std::system_error);
+}
@@ -17,7 +17,12 @@ Copyright 2019 Ilia S. Kovalev
 #ifndef INTERFACES_HPP
 #define INTERFACES_HPP
 
+#include <chrono>
+#include <cstdint>
+#include <memory_resource>
+
 #include "enums.hpp"
+#include "utils/span.hpp"
 #include "utils/typelist.hpp"
 #include "detail/interfaces_detail.hpp"
 #include "utils/heterogeneous_container_functions.hpp"
@@ -65,6 +70,101 @@ namespace algorithm_assembler
 		virtual bool is_active() const = 0;
 	};
 
+	/// <summary>
+	/// Interface for modules processing whole batches of items at once.
+	/// Inputs are passed as separate columns (struct of arrays), so a module
+	/// is able to vectorise across items. Data_processor mixes batch and per-item modules
+	/// and transposes its intermediate columns only where a batch module needs it.
+	/// </summary>
+	template<typename Output, typename... Inputs> class Batch_functor;
+
+	/// <summary>
+	/// Specialisation for batch functor with inputs.
+	/// </summary>
+	template<typename Output, typename Input, typename... Inputs>
+	class Batch_functor<Output, Input, Inputs...> :
+		public Functor<Output, Input, Inputs...>,
+		public virtual detail::Batch_functor_
+	{
+	public:
+		static_assert(std::is_object_v<Output> && std::is_default_constructible_v<Output>,
+			"Output of a batch functor must be a default constructible value");
+
+		/// <summary>
+		/// Processes a batch of items.
+		/// </summary>
+		/// <param name="outs">Output column, its size is the size of the batch.</param>
+		/// <param name="...ins">Input columns of the same size as the output one.</param>
+		virtual void process_batch(
+			utils::Span<Output> outs,
+			utils::Span<const std::decay_t<Input>> in,
+			utils::Span<const std::decay_t<Inputs>>... ins
+		) = 0;
+
+		/// <summary>
+		/// Processes a single item as a batch of one.
+		/// </summary>
+		Output operator()(Input in, Inputs... ins) override
+		{
+			Output out{};
+			process_batch({ &out, 1 }, { &in, 1 }, { &ins, 1 }...);
+			return out;
+		}
+	};
+
+	/// <summary>
+	/// Specialisation for batch functor without inputs (data source).
+	/// </summary>
+	template<typename Output>
+	class Batch_functor<Output> :
+		public Functor<Output>,
+		public virtual detail::Batch_functor_
+	{
+	public:
+		static_assert(std::is_object_v<Output> && std::is_default_constructible_v<Output>,
+			"Output of a batch functor must be a default constructible value");
+
+		/// <summary>
+		/// Produces up to outs.size() items.
+		/// </summary>
+		/// <returns>Number of produced items.</returns>
+		virtual std::size_t process_batch(utils::Span<Output> outs) = 0;
+
+		Output operator()() override
+		{
+			Output out{};
+			process_batch({ &out, 1 });
+			return out;
+		}
+	};
+
+	/// <summary>
+	/// Marks contiguous auxiliary data (std::vector, std::array etc.) in Types_with_policy
+	/// of Transforms interface. A transformer then implements transform(utils::Span&lt;Element&gt;)
+	/// and gets all elements at once, which suits span-based and SIMD kernels.
+	/// The mark is allowed but has no effect in Generates.
+	/// </summary>
+	template<typename T>
+	struct Contiguous
+	{
+		using type = T;
+	};
+
+	template<typename T>
+	struct unwrap_contiguous
+	{
+		using type = T;
+	};
+
+	template<typename T>
+	struct unwrap_contiguous<Contiguous<T>>
+	{
+		using type = T;
+	};
+
+	template<typename T>
+	using unwrap_contiguous_t = typename unwrap_contiguous<T>::type;
+
 	/// <summary>
 	/// Helper struct for passing types with updating policy to interfaces Generates and Transforms.
 	/// </summary>
@@ -72,7 +172,7 @@ namespace algorithm_assembler
 	struct Types_with_policy
 	{
 		constexpr static Updating_policy policy = UP;
-		using types = utils::Typelist<T, Ts...>;
+		using types = utils::Typelist<unwrap_contiguous_t<T>, unwrap_contiguous_t<Ts>...>;
 	};
 
 	/// <summary>
@@ -151,6 +251,67 @@ namespace algorithm_assembler
 		/// </summary>
 		virtual void set(const Settings_type& settings) = 0;
 	};
+
+
+	/// <summary>
+	/// Interface for modules allocating short-lived temporaries while processing an item.
+	/// Data_processor owns a monotonic arena, hands it to such modules once
+	/// and rewinds it before every item, so memory taken from the arena stays valid
+	/// until the next call of the processor. Sub-pipelines of combinator modules (Branch, Parallel etc.)
+	/// own arenas of their own, rewound before every run of the sub-pipeline.
+	/// </summary>
+	class Uses_arena : public detail::Uses_arena
+	{
+	public:
+		/// <summary>
+		/// Sets memory resource for per-item allocations.
+		/// </summary>
+		virtual void set_arena(std::pmr::memory_resource& arena) = 0;
+	};
+
+
+	/// <summary>
+	/// Marks modules whose output often repeats from item to item.
+	/// The output is compared by operator== with the previous one, if it and auxiliary data
+	/// passed further are unchanged, Data_processor skips the next modules and returns
+	/// its previous result. The next modules must give the same result for the same
+	/// inputs and auxiliary data. Auxiliary data passed further must be equality comparable,
+	/// a value set to Data_processor through its Demands interface drops the previous result.
+	/// </summary>
+	class Comparable_output : public virtual detail::Comparable_output_ {};
+
+	/// <summary>
+	/// Same as Comparable_output for outputs expensive to copy or compare:
+	/// the module reports a version of its last output instead.
+	/// </summary>
+	class Versioned_output : public virtual detail::Versioned_output_
+	{
+	public:
+		/// <summary>
+		/// Returns version of the last returned output, equal versions mean equal outputs.
+		/// </summary>
+		virtual std::uint64_t output_version() const = 0;
+	};
+
+	/// <summary>
+	/// Marks modules returning views of their state, valid only until the next call.
+	/// Such outputs are not kept in columns by Data_processor::process_batch,
+	/// the next modules process every item right after the module.
+	/// </summary>
+	class Transient_output : public virtual detail::Transient_output_ {};
+
+	/// <summary>
+	/// Marks modules which may be skipped for late items, their inputs are passed further.
+	/// Budgeted skips the module when an item has less time to its deadline than required.
+	/// </summary>
+	class Optional_stage : public virtual detail::Optional_stage_
+	{
+	public:
+		/// <summary>
+		/// Returns time the module usually takes for an item.
+		/// </summary>
+		virtual std::chrono::nanoseconds required_time() const = 0;
+	};
 }
 
 #endif
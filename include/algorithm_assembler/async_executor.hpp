@@ -0,0 +1,226 @@
+/*
+Copyright 2019 Ilia S. Kovalev
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef ASYNC_EXECUTOR_HPP
+#define ASYNC_EXECUTOR_HPP
+
+#include "async_functor.hpp"
+#include "data_processor.hpp"
+#include "detail/data_processor_async_funcs.hpp"
+
+#ifdef ALGORITHM_ASSEMBLER_HAS_COROUTINES
+
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <iterator>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace algorithm_assembler
+{
+	/// <summary>
+	/// Runs items through a Data_processor concurrently. Items are suspended only at
+	/// Async_functor modules, so many of them are in flight without a thread per item.
+	/// All other modules are called on the thread running process(), an item waiting
+	/// in an async module continues on that thread as well. Outputs are passed to a sink
+	/// in completion order together with indices of their items.
+	/// The per-item arena of a processor is shared by the items in flight and rewound
+	/// only when none is left, so after max_in_flight items since the last rewind
+	/// the executor lets the items in flight finish before starting new ones.
+	/// </summary>
+	template<class Processor>
+	class Async_executor
+	{
+		static_assert(detail::is_data_processor_v<Processor>, "Async_executor runs Data_processor instances");
+
+	public:
+		explicit Async_executor(Processor& processor, std::size_t max_in_flight = 64) :
+			processor_(processor), max_in_flight_(max_in_flight > 0 ? max_in_flight : 1)
+		{}
+
+		Async_executor(const Async_executor&) = delete;
+		Async_executor& operator=(const Async_executor&) = delete;
+
+		/// <summary>
+		/// Processes all inputs of a range.
+		/// </summary>
+		/// <param name="sink">Called as sink(index, output).</param>
+		template<class Range, class Sink>
+		inline void process(Range&& inputs, Sink&& sink)
+		{
+			using std::begin;
+			using std::end;
+
+			auto it = begin(inputs);
+			auto last = end(inputs);
+
+			run([&]() { return it != last; }, [&](std::size_t index) {
+				start_item(index, *it, sink);
+				++it;
+			});
+		}
+
+		/// <summary>
+		/// Processes items of a data source while it is active.
+		/// </summary>
+		/// <param name="sink">Called as sink(index, output).</param>
+		template<class Sink>
+		inline void process(Sink&& sink)
+		{
+			auto& source = processor_.template module<0>();
+
+			run([&source]() { return source.is_active(); }, [&](std::size_t index) {
+				start_item(index, std::tuple<>(), sink);
+			});
+		}
+
+		/// <summary>
+		/// Awaitable continuing a coroutine on the thread running process().
+		/// </summary>
+		inline auto schedule() noexcept
+		{
+			struct Awaiter
+			{
+				Async_executor& executor;
+
+				bool await_ready() const noexcept { return std::this_thread::get_id() == executor.thread_; }
+				void await_suspend(std::coroutine_handle<> h) const { executor.post(h); }
+				void await_resume() const noexcept {}
+			};
+			return Awaiter{ *this };
+		}
+
+		inline std::size_t max_in_flight() const noexcept { return max_in_flight_; }
+
+	private:
+		template<class Has_more, class Start>
+		inline void run(Has_more&& has_more, Start&& start)
+		{
+			thread_ = std::this_thread::get_id();
+			error_ = nullptr;
+
+			std::size_t index = 0;
+			std::vector<std::coroutine_handle<>> ready;
+
+			for (;;)
+			{
+				while (in_flight_ < max_in_flight_ && !error_ && has_more() && take_arena())
+				{
+					++in_flight_;
+					start(index++);
+				}
+
+				if (in_flight_ == 0)
+					break;
+
+				{
+					std::unique_lock<std::mutex> lock(mutex_);
+					posted_.wait(lock, [this]() { return !ready_.empty(); });
+					ready.swap(ready_);
+				}
+
+				for (auto h : ready)
+					h.resume();
+				ready.clear();
+			}
+
+			thread_ = {};
+
+			if (error_)
+				std::rethrow_exception(std::exchange(error_, nullptr));
+		}
+
+		template<typename Input, class Sink>
+		inline utils::Detached_task start_item(std::size_t index, Input input, Sink& sink)
+		{
+			try
+			{
+				auto output = co_await start_processing(std::move(input),
+					std::make_index_sequence<Processor::Modules_list::size>{});
+				sink(index, std::move(output));
+			}
+			catch (...)
+			{
+				if (!error_)
+					error_ = std::current_exception();
+			}
+
+			--in_flight_;
+		}
+
+		template<typename Input, std::size_t... Is>
+		inline auto start_processing(Input&& input, std::index_sequence<Is...>)
+		{
+			return detail::process_data_async(
+				*this,
+				std::forward<Input>(input),
+				std::tuple<>(),
+				processor_.template module<Is>()...);
+		}
+
+		/// <summary>
+		/// Per-item arena is shared by the items in flight, so it is reset only between them.
+		/// At most max_in_flight items use it between resets, which bounds its memory.
+		/// </summary>
+		/// <returns>false if the next item has to wait until the items in flight finish.</returns>
+		inline bool take_arena()
+		{
+			if constexpr (std::is_base_of_v<detail::DP_Arena<true>, Processor>)
+			{
+				if (in_flight_ == 0)
+				{
+					processor_.arena().reset();
+					arena_items_ = 0;
+				}
+
+				if (arena_items_ == max_in_flight_)
+					return false;
+
+				++arena_items_;
+			}
+
+			return true;
+		}
+
+		inline void post(std::coroutine_handle<> h)
+		{
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+				ready_.push_back(h);
+			}
+			posted_.notify_one();
+		}
+
+		Processor& processor_;
+		std::size_t max_in_flight_;
+		std::size_t in_flight_ = 0;
+		std::size_t arena_items_ = 0;
+		std::exception_ptr error_;
+		std::thread::id thread_;
+
+		std::mutex mutex_;
+		std::condition_variable posted_;
+		std::vector<std::coroutine_handle<>> ready_;
+	};
+}
+
+#endif
+
+#endif
@@ -0,0 +1,72 @@
+/*
+Copyright 2019 Ilia S. Kovalev
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef ASYNC_FUNCTOR_HPP
+#define ASYNC_FUNCTOR_HPP
+
+#include <type_traits>
+
+#include "interfaces.hpp"
+#include "utils/task.hpp"
+#include "utils/thread_pool.hpp"
+
+#ifdef ALGORITHM_ASSEMBLER_HAS_COROUTINES
+
+namespace algorithm_assembler
+{
+	/// <summary>
+	/// Interface for modules waiting on I/O. operator() returns a task, so an item waiting
+	/// in the module does not block the thread. Data_processor::operator() waits for the task,
+	/// Async_executor keeps many items in flight instead.
+	/// The module has to copy what it needs from its auxiliary data before the first suspension,
+	/// other items may update it while the task waits.
+	/// </summary>
+	template<typename Output, typename Input, typename... Inputs>
+	class Async_functor : public virtual detail::Functor_, public virtual detail::Async_functor_
+	{
+	public:
+		static_assert(std::is_object_v<Output>, "Output of an async functor must be a value");
+
+		using Output_type = Output;
+		using Input_types = utils::Typelist<Input, Inputs...>;
+
+		virtual utils::Task<Output> operator()(Input in, Inputs... ins) = 0;
+	};
+}
+
+namespace algorithm_assembler::utils
+{
+	/// <summary>
+	/// Awaitable moving the awaiting coroutine to a thread of the pool.
+	/// Blocking calls inside async modules are made after awaiting it.
+	/// </summary>
+	inline auto resume_on(Thread_pool& pool) noexcept
+	{
+		struct Awaiter
+		{
+			Thread_pool& pool;
+
+			bool await_ready() const noexcept { return false; }
+			void await_suspend(std::coroutine_handle<> h) const { pool.submit([h]() { h.resume(); }); }
+			void await_resume() const noexcept {}
+		};
+		return Awaiter{ pool };
+	}
+}
+
+#endif
+
+#endif
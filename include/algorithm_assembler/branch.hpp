@@ -0,0 +1,113 @@
+/*
+Copyright 2019 Ilia S. Kovalev
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef BRANCH_HPP
+#define BRANCH_HPP
+
+#include <type_traits>
+#include <utility>
+
+#include "data_processor.hpp"
+#include "detail/sub_pipeline.hpp"
+
+namespace algorithm_assembler
+{
+	/// <summary>
+	/// Module routing every item through one of two sub-pipelines:
+	/// Pipeline_a if Predicate returns true for the inputs, Pipeline_b otherwise.
+	/// A sub-pipeline is a module or a Data_processor, both take the same inputs
+	/// and return the same output. Predicate is a default constructible functor,
+	/// modules are called directly without virtual dispatch. Branches nest for more routes.
+	///
+	/// Branch demands auxiliary data demanded inside the sub-pipelines and passes it
+	/// to them with every item. Data generated inside are passed further with
+	/// Updating_policy::sometimes: they are new only after a branch generating them ran.
+	/// Auxiliary data transformed inside a sub-pipeline stay transformed only there.
+	/// </summary>
+	template<class Predicate, class Pipeline_a, class Pipeline_b>
+	class Branch :
+		public detail::Combinator_functor<
+			Branch<Predicate, Pipeline_a, Pipeline_b>,
+			typename detail::sub_pipeline_t<Pipeline_a>::Output_type,
+			typename detail::sub_pipeline_t<Pipeline_a>::Input_types
+		>,
+		public detail::combinator_aux_t<
+			detail::sub_pipeline_t<Pipeline_a>,
+			detail::sub_pipeline_t<Pipeline_b>
+		>
+	{
+		using A = detail::sub_pipeline_t<Pipeline_a>;
+		using B = detail::sub_pipeline_t<Pipeline_b>;
+
+		static_assert(std::is_same_v<typename A::Input_types, typename B::Input_types>,
+			"Branches must take the same inputs");
+		static_assert(std::is_same_v<typename A::Output_type, typename B::Output_type>,
+			"Branches must return the same output");
+
+	public:
+		template<typename... Ins>
+		inline typename A::Output_type process(Ins&&... ins)
+		{
+			is_a_taken_ = predicate_(std::as_const(ins)...);
+			if (is_a_taken_)
+				return a_.process(this->demanded_aux(), std::forward<Ins>(ins)...);
+			else
+				return b_.process(this->demanded_aux(), std::forward<Ins>(ins)...);
+		}
+
+		template<typename T, class F>
+		static inline T get(F& f)
+		{
+			constexpr bool is_in_a = utils::contains_v<typename A::Generated_types, T>;
+			constexpr bool is_in_b = utils::contains_v<typename B::Generated_types, T>;
+
+			if constexpr (is_in_a && is_in_b)
+				return f.is_a_taken_ ? f.a_.template get<T>() : f.b_.template get<T>();
+			else if constexpr (is_in_a)
+				return f.a_.template get<T>();
+			else
+				return f.b_.template get<T>();
+		}
+
+		template<typename T>
+		inline bool has_new_data() const
+		{
+			return is_a_taken_ ? a_.template has_new_data<T>() : b_.template has_new_data<T>();
+		}
+
+		/// <summary>
+		/// Gives access to a module of a sub-pipeline, Index 0 is Pipeline_a.
+		/// </summary>
+		template<std::size_t Index, std::size_t I>
+		inline auto& module() noexcept
+		{
+			if constexpr (Index == 0)
+				return a_.template module<I>();
+			else
+				return b_.template module<I>();
+		}
+
+		inline Predicate& predicate() noexcept { return predicate_; }
+
+	private:
+		Predicate predicate_;
+		A a_;
+		B b_;
+		bool is_a_taken_ = false;
+	};
+}
+
+#endif
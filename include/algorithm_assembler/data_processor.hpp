@@ -21,21 +21,32 @@ Copyright 2019 Ilia S. Kovalev
 
 namespace algorithm_assembler
 {
+	/// <summary>
+	/// Selects layout of modules when given as the first Data_processor argument,
+	/// e.g. Data_processor<Module_storage<Storage_policy::cache_aligned>, A, B>.
+	/// Cache aligned modules do not share cache lines, so modules used by different
+	/// threads do not slow each other down by false sharing. Modules are compact by default.
+	/// Modules of nested Data_processor instances are stored by the outer policy.
+	/// </summary>
+	template<Storage_policy SP>
+	struct Module_storage {};
+
+	/// <summary>
+	/// Chain of modules processing data one by one.
+	/// Nested Data_processor instances are spliced into the outer chain at compile time,
+	/// so composing sub-pipelines adds neither virtual calls nor extra forwarding
+	/// and auxiliary data flows across their boundaries.
+	/// </summary>
 	template<class Module, class... Modules>
-	class Data_processor : 
-		public detail::DP_Functor<
-			typename Module::Input_types,
-			typename utils::Typelist<Module, Modules...>::back::Output_type,
-			utils::Typelist<Module, Modules...>
+	class Data_processor :
+		public detail::Data_processor_impl<
+			detail::flatten_modules_t<Module, Modules...>,
+			detail::get_storage_policy_v<Module>
 		>
-		, public detail::DP_Demandant<
-			utils::Typelist<Module, Modules...>,
-			utils::substraction_t<
-				detail::get_demanded_types_t<Module, Modules...>,
-				detail::get_generated_types_t<Module, Modules...>
-			>
-		>
-	{};
+	{
+		static_assert(!(detail::is_module_storage_v<Modules> || ...),
+			"Module_storage may be given only as the first argument of Data_processor");
+	};
 
 
 
@@ -0,0 +1,410 @@
+/*
+Copyright 2019 Ilia S. Kovalev
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef DEADLINE_HPP
+#define DEADLINE_HPP
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "data_processor.hpp"
+#include "detail/sub_pipeline.hpp"
+
+namespace algorithm_assembler
+{
+	/// <summary>
+	/// Time by which an item has to be processed. It is auxiliary data:
+	/// set it to a Data_processor per call or generate it per item by Item_budget.
+	/// A default constructed deadline is never missed.
+	/// </summary>
+	struct Deadline
+	{
+		using Clock = std::chrono::steady_clock;
+
+		Clock::time_point time = Clock::time_point::max();
+
+		static inline Deadline after(Clock::duration budget) noexcept
+		{
+			return { Clock::now() + budget };
+		}
+
+		inline Clock::duration remaining(Clock::time_point now = Clock::now()) const noexcept
+		{
+			return time - now;
+		}
+
+		inline bool is_missed(Clock::time_point now = Clock::now()) const noexcept
+		{
+			return now > time;
+		}
+
+		inline bool operator==(const Deadline& other) const noexcept { return time == other.time; }
+		inline bool operator!=(const Deadline& other) const noexcept { return time != other.time; }
+	};
+
+
+	/// <summary>
+	/// First module of a pipeline giving every item a deadline after the budget.
+	/// </summary>
+	template<typename T>
+	class Item_budget :
+		public Functor<const T&, const T&>,
+		public Generates<Types_with_policy<Updating_policy::always, Deadline>>
+	{
+	public:
+		template<typename U, class F>
+		static inline U get(F& f)
+		{
+			return f.deadline_;
+		}
+
+		/// <summary>
+		/// Sets the budget of an item, it is unlimited by default.
+		/// </summary>
+		inline void set_budget(Deadline::Clock::duration budget) noexcept { budget_ = budget; }
+
+		inline Deadline::Clock::duration budget() const noexcept { return budget_; }
+
+		inline const T& operator()(const T& in) override
+		{
+			deadline_ = budget_ == Deadline::Clock::duration::max() ? Deadline{} : Deadline::after(budget_);
+			return in;
+		}
+
+	private:
+		Deadline::Clock::duration budget_ = Deadline::Clock::duration::max();
+		Deadline deadline_;
+	};
+
+
+	struct Stage_stats
+	{
+		std::size_t calls = 0;		/// Items processed by the stage.
+		std::size_t skipped = 0;	/// Items skipped by an optional stage.
+		std::size_t misses = 0;		/// Items which left the stage after their deadlines.
+		std::size_t overruns = 0;	/// Items which took the stage longer than its budget.
+
+		std::chrono::nanoseconds total_time{ 0 };
+		std::chrono::nanoseconds max_time{ 0 };
+	};
+}
+
+namespace algorithm_assembler::detail
+{
+	template<typename Modules_list>
+	struct are_optional_stages;
+
+	template<class... Modules>
+	struct are_optional_stages<utils::Typelist<Modules...>> :
+		std::bool_constant<(std::is_base_of_v<Optional_stage, Modules> && ...)>
+	{};
+
+	template<typename Output, typename Input_types>
+	struct returns_input : std::false_type {};
+
+	template<typename Output, typename Input>
+	struct returns_input<Output, utils::Typelist<Input>> : std::is_constructible<Output, Input> {};
+
+	/// <summary>
+	/// Running state of a stage read by Watchdog. The sequence number is odd
+	/// while the stage runs, the start time is valid if it did not change around reading.
+	/// </summary>
+	class Stage_monitor
+	{
+	public:
+		using Clock = Deadline::Clock;
+
+		Stage_monitor() = default;
+
+		// Running state belongs to the instance, only the budget is copied.
+		Stage_monitor(const Stage_monitor& other) noexcept : budget_(other.budget_.load()) {}
+
+		Stage_monitor& operator=(const Stage_monitor& other) noexcept
+		{
+			budget_.store(other.budget_.load());
+			return *this;
+		}
+
+		inline void start(Clock::time_point now) noexcept
+		{
+			started_.store(now.time_since_epoch().count(), std::memory_order_relaxed);
+			sequence_.fetch_add(1, std::memory_order_release);
+		}
+
+		inline void stop() noexcept
+		{
+			sequence_.fetch_add(1, std::memory_order_release);
+		}
+
+		inline void set_budget(Clock::duration budget) noexcept { budget_.store(budget.count()); }
+
+		inline Clock::duration budget() const noexcept { return Clock::duration(budget_.load()); }
+
+		/// <summary>
+		/// Returns the sequence number of a running call and its start time, or an even number.
+		/// </summary>
+		inline std::pair<std::uint64_t, Clock::time_point> running() const noexcept
+		{
+			auto sequence = sequence_.load(std::memory_order_acquire);
+			auto started = Clock::time_point(Clock::duration(started_.load(std::memory_order_relaxed)));
+			std::atomic_thread_fence(std::memory_order_acquire);
+
+			if (sequence % 2 == 0 || sequence != sequence_.load(std::memory_order_relaxed))
+				return { 0, {} };
+			return { sequence, started };
+		}
+
+	private:
+		std::atomic<std::uint64_t> sequence_{ 0 };
+		std::atomic<Clock::rep> started_{ 0 };
+		std::atomic<Clock::rep> budget_{ Clock::duration::max().count() };
+	};
+}
+
+namespace algorithm_assembler
+{
+	/// <summary>
+	/// Module running a sub-pipeline under the deadline of an item and recording its latency.
+	/// A sub-pipeline is a module or a Data_processor. The module demands Deadline and passes it
+	/// inside with the other demanded auxiliary data. If all modules of the sub-pipeline are
+	/// Optional_stage, it is skipped for items having less time left than they require together,
+	/// the input is returned then and generated data are not updated.
+	/// Items leaving the stage after their deadlines are counted as misses,
+	/// ones taking longer than the budget of the stage are counted as overruns.
+	/// </summary>
+	template<class Pipeline>
+	class Budgeted :
+		public detail::Combinator_functor<
+			Budgeted<Pipeline>,
+			typename detail::sub_pipeline_t<Pipeline>::Output_type,
+			typename detail::sub_pipeline_t<Pipeline>::Input_types
+		>,
+		public detail::Combinator_aux<
+			utils::unique_t<utils::concatenation_t<
+				utils::Typelist<Deadline>,
+				typename detail::sub_pipeline_t<Pipeline>::Demanded_types
+			>>,
+			typename detail::sub_pipeline_t<Pipeline>::Generated_types
+		>
+	{
+		using P = detail::sub_pipeline_t<Pipeline>;
+		using Modules = detail::flatten_modules_t<Pipeline>;
+		using Clock = Deadline::Clock;
+
+	public:
+		using Output = typename P::Output_type;
+
+		constexpr static bool is_optional = detail::are_optional_stages<Modules>::value;
+
+		static_assert(!is_optional || detail::returns_input<Output, typename P::Input_types>::value,
+			"Skipped optional stage must return its input");
+
+		template<typename... Ins>
+		inline Output process(Ins&&... ins)
+		{
+			const auto& deadline = static_cast<const detail::Demanded_value<Deadline>&>(*this).value();
+			auto start = Clock::now();
+
+			if constexpr (is_optional)
+			{
+				has_run_ = !deadline || deadline->remaining(start) >= required_time();
+				if (!has_run_)
+				{
+					++stats_.skipped;
+					return Output(std::forward<Ins>(ins)...);
+				}
+			}
+
+			monitor_.start(start);
+			struct Stop
+			{
+				detail::Stage_monitor& monitor;
+				~Stop() { monitor.stop(); }
+			} stop{ monitor_ };
+
+			Output out = pipeline_.process(this->demanded_aux(), std::forward<Ins>(ins)...);
+
+			auto end = Clock::now();
+			auto time = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+			++stats_.calls;
+			stats_.total_time += time;
+			if (time > stats_.max_time)
+				stats_.max_time = time;
+			if (deadline && deadline->is_missed(end))
+				++stats_.misses;
+			if (end - start > monitor_.budget())
+				++stats_.overruns;
+
+			return out;
+		}
+
+		template<typename T, class F>
+		static inline T get(F& f)
+		{
+			return f.pipeline_.template get<T>();
+		}
+
+		/// <summary>
+		/// Generated data are new only if the sub-pipeline ran for the last item.
+		/// </summary>
+		template<typename T>
+		inline bool has_new_data() const
+		{
+			return has_run_ && pipeline_.template has_new_data<T>();
+		}
+
+		/// <summary>
+		/// Sum of time required by optional modules of the sub-pipeline.
+		/// </summary>
+		inline std::chrono::nanoseconds required_time() const
+		{
+			return required_time(std::make_index_sequence<Modules::size>{});
+		}
+
+		/// <summary>
+		/// Sets time an item may take the stage, it is unlimited by default.
+		/// </summary>
+		inline void set_budget(Clock::duration budget) noexcept { monitor_.set_budget(budget); }
+
+		inline Clock::duration budget() const noexcept { return monitor_.budget(); }
+
+		/// <summary>
+		/// Indicates if the sub-pipeline ran for the last item.
+		/// </summary>
+		inline bool has_run() const noexcept { return has_run_; }
+
+		inline const Stage_stats& stats() const noexcept { return stats_; }
+
+		inline void reset_stats() noexcept { stats_ = {}; }
+
+		inline const detail::Stage_monitor& monitor() const noexcept { return monitor_; }
+
+		template<std::size_t I>
+		inline auto& module() noexcept { return pipeline_.template module<I>(); }
+
+	private:
+		template<std::size_t... Is>
+		inline std::chrono::nanoseconds required_time(std::index_sequence<Is...>) const
+		{
+			if constexpr (is_optional)
+				return (std::chrono::nanoseconds(0) + ... + pipeline_.template module<Is>().required_time());
+			else
+				return std::chrono::nanoseconds(0);
+		}
+
+		P pipeline_;
+		detail::Stage_monitor monitor_;
+		Stage_stats stats_;
+		bool has_run_ = true;
+	};
+
+
+	/// <summary>
+	/// Thread reporting Budgeted stages running longer than their budgets,
+	/// so a stuck stage is noticed before its item leaves it. Every call is reported once.
+	/// </summary>
+	class Watchdog
+	{
+	public:
+		using Report = std::function<void(const std::string& stage, std::chrono::nanoseconds elapsed)>;
+
+		/// <param name="report">Called on the watchdog thread.</param>
+		/// <param name="period">Interval of checks.</param>
+		explicit Watchdog(Report report, std::chrono::nanoseconds period = std::chrono::milliseconds(10)) :
+			report_(std::move(report)),
+			period_(period),
+			thread_([this]() { watch(); })
+		{}
+
+		Watchdog(const Watchdog&) = delete;
+		Watchdog& operator=(const Watchdog&) = delete;
+
+		~Watchdog()
+		{
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+				is_stopping_ = true;
+			}
+			cv_.notify_all();
+			thread_.join();
+		}
+
+		/// <summary>
+		/// Starts watching a stage, it must outlive the watchdog.
+		/// </summary>
+		template<class Pipeline>
+		inline void add(const Budgeted<Pipeline>& stage, std::string name)
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			stages_.push_back({ &stage.monitor(), std::move(name), 0 });
+		}
+
+		/// <summary>
+		/// Number of reported overruns.
+		/// </summary>
+		inline std::size_t reports() const noexcept { return reports_.load(); }
+
+	private:
+		struct Watched
+		{
+			const detail::Stage_monitor* monitor;
+			std::string name;
+			std::uint64_t reported;
+		};
+
+		inline void watch()
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			while (!cv_.wait_for(lock, period_, [this]() { return is_stopping_; }))
+			{
+				auto now = Deadline::Clock::now();
+				for (auto& s : stages_)
+				{
+					auto [sequence, started] = s.monitor->running();
+					if (sequence == 0 || sequence == s.reported || now - started <= s.monitor->budget())
+						continue;
+
+					s.reported = sequence;
+					++reports_;
+					report_(s.name, std::chrono::duration_cast<std::chrono::nanoseconds>(now - started));
+				}
+			}
+		}
+
+		Report report_;
+		std::chrono::nanoseconds period_;
+
+		std::mutex mutex_;
+		std::condition_variable cv_;
+		bool is_stopping_ = false;
+		std::vector<Watched> stages_;
+		std::atomic<std::size_t> reports_{ 0 };
+
+		std::thread thread_;
+	};
+}
+
+#endif
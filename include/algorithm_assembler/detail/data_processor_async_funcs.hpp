@@ -0,0 +1,138 @@
+/*
+Copyright 2019 Ilia S. Kovalev
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef DATA_PROCESSOR_ASYNC_FUNCS
+#define DATA_PROCESSOR_ASYNC_FUNCS
+
+#include "../utils/task.hpp"
+
+#ifdef ALGORITHM_ASSEMBLER_HAS_COROUTINES
+
+#include <exception>
+#include <optional>
+
+#include "data_processor_funcs.hpp"
+
+namespace algorithm_assembler::detail
+{
+	template<typename T>
+	using async_value_t = std::remove_cv_t<std::remove_reference_t<T>>;
+
+	template<class... Fs>
+	using async_output_t = async_value_t<typename utils::Typelist<Fs...>::back::Output_type>;
+
+	template<typename T>
+	inline utils::Task<T> ready_task(T value)
+	{
+		co_return std::move(value);
+	}
+
+	template<class F, typename Input, typename _ = utils::Typelist<>,
+		typename = std::enable_if_t<!utils::is_tuple_v<Input>>
+	>
+	inline auto start_async_functor(F& f, Input&& in, _ = _{})
+	{
+		return f.F::operator()(std::forward<Input>(in));
+	}
+
+	template<class F, typename Tuple, typename... F_ins,
+		typename = std::enable_if_t<utils::is_tuple_v<Tuple>>
+	>
+	inline auto start_async_functor(F& f, Tuple&& in_tuple, utils::Typelist<F_ins...>&&)
+	{
+		if constexpr (is_whole_tuple_input<Tuple, F_ins...>::value)
+			return f.F::operator()(std::forward<Tuple>(in_tuple));
+		else
+			return f.F::operator()(tuple_get_wrapper<F_ins>(std::forward<Tuple>(in_tuple))...);
+	}
+
+	template<class Scheduler, typename Input, class F, class... Fs, typename... Ts>
+	inline utils::Task<async_output_t<F, Fs...>> process_data_async(
+		Scheduler& scheduler, Input&& in, std::tuple<Ts...>&& aux, F& f, Fs&... tail);
+
+	/// <summary>
+	/// Awaits an async module and continues on the scheduler thread.
+	/// Input and auxiliary data are owned by the coroutine frame while the module waits.
+	/// An exception of the module is rethrown on the scheduler thread as well.
+	/// </summary>
+	template<class Scheduler, typename Input, class F, class... Fs, typename... Ts>
+	inline utils::Task<async_output_t<F, Fs...>> process_async_stage(
+		Scheduler& scheduler, Input in, std::tuple<Ts...> aux, F& f, Fs&... tail)
+	{
+		set_to_demandant(f, aux);
+
+		std::optional<async_value_t<typename F::Output_type>> output;
+		std::exception_ptr error;
+
+		try
+		{
+			output.emplace(co_await start_async_functor(f, std::move(in), typename F::Input_types{}));
+		}
+		catch (...)
+		{
+			error = std::current_exception();
+		}
+
+		co_await scheduler.schedule();
+
+		if (error)
+			std::rethrow_exception(error);
+
+		if constexpr (sizeof...(Fs) > 0)
+			co_return co_await process_data_async(
+				scheduler,
+				std::move(*output),
+				pass_aux_data(std::move(aux), f, tail...),
+				tail...);
+		else
+			co_return std::move(*output);
+	}
+
+	/// <summary>
+	/// Coroutine counterpart of process_data. Modules before the first async one are called
+	/// immediately, the returned task suspends only at async modules.
+	/// </summary>
+	template<class Scheduler, typename Input, class F, class... Fs, typename... Ts>
+	inline utils::Task<async_output_t<F, Fs...>> process_data_async(
+		Scheduler& scheduler, Input&& in, std::tuple<Ts...>&& aux, F& f, Fs&... tail)
+	{
+		if constexpr (is_async_functor_v<F>)
+			return process_async_stage<Scheduler, std::decay_t<Input>>(
+				scheduler, std::forward<Input>(in), std::move(aux), f, tail...);
+		else
+		{
+			set_to_demandant(f, aux);
+
+			if constexpr (sizeof...(Fs) > 0)
+			{
+				auto&& output = process_through_functor(f, std::forward<Input>(in), typename F::Input_types{});
+
+				return process_data_async(
+					scheduler,
+					std::forward<typename F::Output_type>(output),
+					pass_aux_data(std::move(aux), f, tail...),
+					tail...);
+			}
+			else
+				return ready_task<async_output_t<F>>(
+					process_through_functor(f, std::forward<Input>(in), typename F::Input_types{}));
+		}
+	}
+}
+
+#endif
+
+#endif
@@ -0,0 +1,333 @@
+/*
+Copyright 2019 Ilia S. Kovalev
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef DATA_PROCESSOR_BATCH_FUNCS
+#define DATA_PROCESSOR_BATCH_FUNCS
+
+#include <memory_resource>
+#include <vector>
+
+#include "../utils/span.hpp"
+#include "data_processor_funcs.hpp"
+
+namespace algorithm_assembler::detail
+{
+	template<class T>
+	struct is_batch_functor : public std::is_base_of<Batch_functor_, T> {};
+
+	template<class T>
+	constexpr bool is_batch_functor_v = is_batch_functor<T>::value;
+
+	template<class T>
+	struct is_transient_output : public std::is_base_of<Transient_output_, T> {};
+
+	template<class T>
+	constexpr bool is_transient_output_v = is_transient_output<T>::value;
+
+
+	template<typename T>
+	struct is_batch_storable :
+		public std::bool_constant<std::is_object_v<T> && std::is_default_constructible_v<T>> {};
+
+	template<typename... Ts>
+	struct is_batch_storable<std::tuple<Ts...>> :
+		public std::bool_constant<(std::is_object_v<Ts> && ...)> {};
+
+	/// <summary>
+	/// Intermediate outputs are kept in columns during batch processing,
+	/// so they have to be values, not references to module states.
+	/// </summary>
+	template<typename T>
+	constexpr bool is_batch_storable_v = is_batch_storable<T>::value;
+
+
+	/// <summary>
+	/// Checks if a module generates auxiliary data changing from item to item
+	/// (Updating_policy always or sometimes) demanded by the next modules.
+	/// Such data can not be passed once per batch.
+	/// </summary>
+	template<class F, class... Fs>
+	struct generates_per_item_aux : public std::bool_constant<(utils::intersection_t<
+		utils::concatenation_t<
+			get_generated_types_by_policy_t<Updating_policy::always, F>,
+			get_generated_types_by_policy_t<Updating_policy::sometimes, F>
+		>,
+		get_demanded_types_t<Fs...>
+	>::size > 0)> {};
+
+	template<class F, class... Fs>
+	constexpr bool generates_per_item_aux_v = generates_per_item_aux<F, Fs...>::value;
+
+	/// <summary>
+	/// Modules after a Transient_output module or a module generating per-item auxiliary data
+	/// demanded later process a batch item by item.
+	/// </summary>
+	template<class F, class... Fs>
+	constexpr bool is_per_item_stage_v = sizeof...(Fs) > 0 &&
+		(is_transient_output_v<F> || generates_per_item_aux_v<F, Fs...>);
+
+
+	/// <summary>
+	/// Passes element of a caller-owned column to a per-item module without copying it
+	/// unless the module takes the input by value or by rvalue reference:
+	/// the caller keeps its data, so the module gets a copy to consume.
+	/// </summary>
+	template<typename Input, typename T>
+	inline decltype(auto) pass_column_element(T& element)
+	{
+		if constexpr (std::is_rvalue_reference_v<Input>)
+			return std::decay_t<T>(element);
+		else
+			return static_cast<T&>(element);
+	}
+
+	template<class F, typename... Columns, typename... F_ins, std::size_t... Is>
+	inline auto process_through_functor_by_columns(
+		F& f,
+		std::tuple<utils::Span<Columns>...>& columns,
+		std::size_t i,
+		utils::Typelist<F_ins...>&&,
+		std::index_sequence<Is...>
+	) -> typename F::Output_type
+	{
+		return call_functor(f, pass_column_element<F_ins>(std::get<Is>(columns)[i])...);
+	}
+
+	/// <summary>
+	/// Splits a column of tuples into separate columns of the functor inputs.
+	/// </summary>
+	template<typename T, typename... F_ins>
+	inline auto transpose(
+		utils::Span<T> in,
+		std::pmr::memory_resource& arena,
+		utils::Typelist<F_ins...>&&
+	)
+	{
+		std::tuple<std::pmr::vector<std::decay_t<F_ins>>...> columns{
+			std::pmr::vector<std::decay_t<F_ins>>(&arena)...
+		};
+
+		std::apply([&in](auto&... cs) { (cs.reserve(in.size()), ...); }, columns);
+
+		for (auto& element : in)
+			std::apply([&element](auto&... cs) {
+				(cs.push_back(tuple_get_wrapper<F_ins>(std::move(element))), ...);
+			}, columns);
+
+		return columns;
+	}
+
+	template<typename... Ts>
+	inline auto to_spans(std::tuple<std::pmr::vector<Ts>...>& columns)
+	{
+		return std::apply([](auto&... cs) { return std::make_tuple(utils::Span<Ts>(cs)...); }, columns);
+	}
+
+	/// <summary>
+	/// Runs a module for element i of input columns (one column per input).
+	/// </summary>
+	template<class F, typename... Columns>
+	inline auto process_column_element(F& f, std::tuple<utils::Span<Columns>...>& in, std::size_t i)
+		-> typename F::Output_type
+	{
+		return process_through_functor_by_columns(
+			f, in, i, typename F::Input_types{}, std::index_sequence_for<Columns...>{}
+		);
+	}
+
+	/// <summary>
+	/// Runs a module for element i of output column of the previous module.
+	/// </summary>
+	template<class F, typename T>
+	inline auto process_column_element(F& f, utils::Span<T> in, std::size_t i)
+		-> typename F::Output_type
+	{
+		return process_through_functor(f, std::move(in[i]), typename F::Input_types{});
+	}
+
+	/// <summary>
+	/// Runs a module over input columns (one column per input).
+	/// </summary>
+	template<class F, typename Out, typename... Columns>
+	inline void process_stage(
+		F& f,
+		std::tuple<utils::Span<Columns>...>& in,
+		utils::Span<Out> out,
+		std::pmr::memory_resource&
+	)
+	{
+		if constexpr (is_batch_functor_v<F>)
+			std::apply([&f, &out](auto&... columns) {
+				f.F::process_batch(out, columns...);
+			}, in);
+		else
+			for (std::size_t i = 0; i < out.size(); ++i)
+				out[i] = process_through_functor_by_columns(
+					f, in, i, F::Input_types{}, std::index_sequence_for<Columns...>{}
+				);
+	}
+
+	/// <summary>
+	/// Runs a module over output column of the previous module.
+	/// </summary>
+	template<class F, typename Out, typename T>
+	inline void process_stage(
+		F& f,
+		utils::Span<T> in,
+		utils::Span<Out> out,
+		std::pmr::memory_resource& arena
+	)
+	{
+		if constexpr (is_batch_functor_v<F>)
+		{
+			using F_ins = typename F::Input_types;
+
+			if constexpr (F_ins::size == 1 && std::is_same_v<std::decay_t<typename F_ins::head>, T>)
+				f.F::process_batch(out, utils::Span<const T>(in));
+			else
+			{
+				auto columns = transpose(in, arena, F_ins{});
+				auto spans = to_spans(columns);
+				process_stage(f, spans, out, arena);
+			}
+		}
+		else
+			for (std::size_t i = 0; i < out.size(); ++i)
+				out[i] = process_through_functor(f, std::move(in[i]), F::Input_types{});
+	}
+
+	/// <summary>
+	/// Batch counterpart of process_data. Every module processes the whole batch before
+	/// the next one starts, auxiliary data is passed once per batch.
+	/// Intermediate columns are allocated from the arena.
+	/// A Transient_output module and a module generating per-item auxiliary data
+	/// demanded later process the rest of the batch item by item with the next modules,
+	/// so the next modules get the same data as without batching.
+	/// </summary>
+	template<typename Out, typename Input, class F, class... Fs, typename... Ts>
+	inline void process_batch_data(
+		utils::Span<Out> outs,
+		Input&& in,
+		std::tuple<Ts...>&& aux,
+		std::pmr::memory_resource& arena,
+		F& f, Fs&... tail)
+	{
+		set_to_demandant(f, aux);
+
+		static_assert(sizeof...(Fs) > 0 || !is_transient_output_v<F>,
+			"Output of the last module is overwritten by the next item of a batch");
+
+		if constexpr (is_per_item_stage_v<F, Fs...>)
+		{
+			for (std::size_t i = 0; i < outs.size(); ++i)
+			{
+				auto&& output = process_column_element(f, in, i);
+
+				outs[i] = process_data(
+					std::forward<typename F::Output_type>(output),
+					pass_aux_data(std::tuple<Ts...>(aux), f, tail...),
+					tail...);
+			}
+		}
+		else if constexpr (sizeof...(Fs) > 0)
+		{
+			using Output = typename F::Output_type;
+
+			static_assert(is_batch_storable_v<Output>,
+				"Intermediate outputs must be default constructible values to be processed in batches");
+
+			std::pmr::vector<Output> column(outs.size(), &arena);
+
+			process_stage(f, in, utils::Span<Output>(column), arena);
+
+			process_batch_data(
+				outs,
+				utils::Span<Output>(column),
+				pass_aux_data(std::forward<std::tuple<Ts...>>(aux), f, tail...),
+				arena,
+				tail...);
+		}
+		else
+			process_stage(f, in, outs, arena);
+	}
+
+	/// <summary>
+	/// Pulls up to out.size() items from a data source.
+	/// </summary>
+	/// <returns>Number of pulled items.</returns>
+	template<class F, typename Out>
+	inline std::size_t pull_from_source(F& f, utils::Span<Out> out)
+	{
+		if constexpr (is_batch_functor_v<F>)
+			return f.F::process_batch(out);
+		else
+		{
+			std::size_t n = 0;
+			while (n < out.size() && f.is_active())
+				out[n++] = call_functor(f);
+			return n;
+		}
+	}
+
+	template<typename Out, class F, class... Fs>
+	inline std::size_t process_batch_from_source(
+		utils::Span<Out> outs,
+		std::pmr::memory_resource& arena,
+		F& f, Fs&... tail)
+	{
+		static_assert(sizeof...(Fs) > 0 || !is_transient_output_v<F>,
+			"Output of the last module is overwritten by the next item of a batch");
+
+		if constexpr (is_per_item_stage_v<F, Fs...>)
+		{
+			std::size_t n = 0;
+			while (n < outs.size() && f.is_active())
+			{
+				auto&& output = call_functor(f);
+
+				outs[n++] = process_data(
+					std::forward<typename F::Output_type>(output),
+					pass_aux_data(std::tuple<>(), f, tail...),
+					tail...);
+			}
+			return n;
+		}
+		else if constexpr (sizeof...(Fs) > 0)
+		{
+			using Output = typename F::Output_type;
+
+			static_assert(is_batch_storable_v<Output>,
+				"Intermediate outputs must be default constructible values to be processed in batches");
+
+			std::pmr::vector<Output> column(outs.size(), &arena);
+
+			auto n = pull_from_source(f, utils::Span<Output>(column));
+
+			process_batch_data(
+				outs.first(n),
+				utils::Span<Output>(column).first(n),
+				pass_aux_data(std::tuple<>(), f, tail...),
+				arena,
+				tail...);
+
+			return n;
+		}
+		else
+			return pull_from_source(f, outs);
+	}
+}
+
+#endif
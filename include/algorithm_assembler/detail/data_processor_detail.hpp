@@ -18,59 +18,404 @@ Copyright 2019 Ilia S. Kovalev
 #define DATA_PROCESSOR_DETAIL_HPP
 
 
+#include <cassert>
+#include <optional>
 #include <tuple>
+#include <utility>
 
+#include "../utils/arena.hpp"
+#include "../utils/misc.hpp"
 #include "../utils/typelist.hpp"
 #include "../interfaces.hpp"
 #include "data_processor_funcs.hpp"
+#include "data_processor_batch_funcs.hpp"
+#include "data_processor_incremental_funcs.hpp"
+
+namespace algorithm_assembler
+{
+	template<Storage_policy> struct Module_storage;
+}
 
 namespace algorithm_assembler::detail
 {
+	template<class T>
+	struct is_arena_user : public std::is_base_of<Uses_arena, T> {};
+
+	template<class T>
+	constexpr bool is_arena_user_v = is_arena_user<T>::value;
+
+	template<bool Has_arena>
+	class DP_Arena
+	{
+	protected:
+		inline void reset_arena() noexcept {}
+	};
+
+	template<>
+	class DP_Arena<true>
+	{
+	public:
+		inline utils::Monotonic_arena& arena() noexcept { return arena_; }
+
+	protected:
+		inline void reset_arena() noexcept { arena_.reset(); }
+
+		utils::Monotonic_arena arena_;
+	};
+
+	/// <summary>
+	/// Arena for intermediate columns of batches, kept between calls,
+	/// so batches of a steady size allocate nothing. Processors with arena users
+	/// take their per-item arena instead.
+	/// </summary>
+	template<bool Has_arena>
+	class DP_Batch_arena
+	{
+	public:
+		DP_Batch_arena() = default;
+
+		// Intermediate columns are not shared between copies.
+		DP_Batch_arena(const DP_Batch_arena&) noexcept {}
+		DP_Batch_arena& operator=(const DP_Batch_arena&) noexcept { return *this; }
+
+		/// <summary>
+		/// Returns the arena emptied for the next batch.
+		/// </summary>
+		inline utils::Monotonic_arena& rewind(DP_Arena<false>&) noexcept
+		{
+			arena_.reset();
+			return arena_;
+		}
+
+	private:
+		utils::Monotonic_arena arena_;
+	};
+
+	template<>
+	class DP_Batch_arena<true>
+	{
+	public:
+		inline utils::Monotonic_arena& rewind(DP_Arena<true>& arena) noexcept
+		{
+			arena.arena().reset();
+			return arena.arena();
+		}
+	};
+
+	/// <summary>
+	/// Module padded to whole cache lines.
+	/// </summary>
+	template<class Module>
+	struct alignas(utils::cache_line_size) Cache_aligned_module
+	{
+		Module module;
+	};
+
+	template<Storage_policy SP, class... Modules>
+	struct modules_storage
+	{
+		using type = std::tuple<Modules...>;
+	};
+
 	template<class... Modules>
-	class DP_Modules
+	struct modules_storage<Storage_policy::cache_aligned, Modules...>
+	{
+		using type = std::tuple<Cache_aligned_module<Modules>...>;
+	};
+
+	template<Storage_policy SP, class... Modules>
+	class DP_Modules : public DP_Arena<(is_arena_user_v<Modules> || ...)>
 	{
+	public:
+		DP_Modules()
+		{
+			if constexpr ((is_arena_user_v<Modules> || ...))
+				for_each_module([this](auto& module) { set_arena(module); });
+		}
+
+		/// <summary>
+		/// Gives access to a module by its position in the flattened modules list.
+		/// </summary>
+		template<std::size_t I>
+		inline auto& module()
+		{
+			if constexpr (SP == Storage_policy::cache_aligned)
+				return std::get<I>(modules_).module;
+			else
+				return std::get<I>(modules_);
+		}
+
+		template<std::size_t I>
+		inline const auto& module() const
+		{
+			if constexpr (SP == Storage_policy::cache_aligned)
+				return std::get<I>(modules_).module;
+			else
+				return std::get<I>(modules_);
+		}
+
 	protected:
-		std::tuple<Modules...> modules_;
+		template<class F>
+		inline void for_each_module(F&& f)
+		{
+			for_each_module(std::forward<F>(f), std::index_sequence_for<Modules...>{});
+		}
+
+	private:
+		template<class F, std::size_t... Is>
+		inline void for_each_module(F&& f, std::index_sequence<Is...>)
+		{
+			(f(module<Is>()), ...);
+		}
+
+		typename modules_storage<SP, Modules...>::type modules_;
+
+		template<class F>
+		inline void set_arena(F& f)
+		{
+			if constexpr (is_arena_user_v<F>)
+				f.set_arena(this->arena_);
+		}
 	};
 
-	template<typename In_typelist, typename Out_type, typename Modules_list> class DP_Functor;
+	template<bool Is_incremental, typename Out_type, class... Modules>
+	class DP_Incremental
+	{
+	protected:
+		template<typename Input>
+		inline Out_type process_item(Input&& in, Modules&... modules)
+		{
+			return process_data(std::forward<Input>(in), std::tuple<>(), modules...);
+		}
+	};
 
-	template<typename In_type, typename... In_types, typename Out_type, class... Modules>
-	class DP_Functor<utils::Typelist<In_type, In_types...>, Out_type, utils::Typelist<Modules...>> :
+	/// <summary>
+	/// Keeps the last result and per-stage outputs for skipping modules
+	/// after an unchanged output of a Comparable_output or Versioned_output module.
+	/// </summary>
+	template<typename Out_type, class... Modules>
+	class DP_Incremental<true, Out_type, Modules...>
+	{
+		static_assert(std::is_object_v<Out_type> && std::is_copy_constructible_v<Out_type>,
+			"Data_processor skipping unchanged outputs must return a copyable value");
+
+	public:
+		/// <summary>
+		/// Forgets the last result, the next item is processed by all modules.
+		/// </summary>
+		inline void reset_last_result() noexcept { last_result_.reset(); }
+
+	protected:
+		template<typename Input>
+		inline Out_type process_item(Input&& in, Modules&... modules)
+		{
+			// The result is kept only if processing succeeds.
+			auto last_result = std::exchange(last_result_, std::nullopt);
+
+			last_result_ = process_data_incremental(
+				cache_,
+				last_result,
+				std::forward<Input>(in),
+				std::tuple<>(),
+				modules...);
+
+			return *last_result_;
+		}
+
+	private:
+		std::optional<Out_type> last_result_;
+		Incremental_cache<std::tuple<>, Modules...> cache_;
+	};
+
+	/// <summary>
+	/// Virtual base shared by DP_Functor and DP_Demandant_impl, so demanded values set
+	/// from outside can drop the last result.
+	/// </summary>
+	template<class... Modules>
+	using dp_incremental_t = DP_Incremental<
+		(is_incremental_stage_v<Modules> || ...),
+		typename utils::Typelist<Modules...>::back::Output_type,
+		Modules...
+	>;
+
+	template<typename In_typelist, typename Out_type, typename Modules_list, Storage_policy SP> class DP_Functor;
+
+	template<typename In_type, typename... In_types, typename Out_type, class... Modules, Storage_policy SP>
+	class DP_Functor<utils::Typelist<In_type, In_types...>, Out_type, utils::Typelist<Modules...>, SP> :
 		public algorithm_assembler::Functor<Out_type, In_type, In_types...>,
-		public virtual DP_Modules<Modules...>
+		public virtual dp_incremental_t<Modules...>,
+		public virtual DP_Modules<SP, Modules...>
 	{
 	public:
 		inline Out_type operator()(In_type in, In_types... ins) override
 		{
-			return process_data(
+			this->reset_arena();
+
+			return process(
 				std::forward_as_tuple(std::forward<In_type>(in), std::forward<In_types>(ins)...),
+				std::index_sequence_for<Modules...>{}
+			);
+		}
+
+		/// <summary>
+		/// Processes a batch of items given as input columns (struct of arrays).
+		/// Every module processes the whole batch before the next one starts
+		/// and auxiliary data is passed once per batch. After a module generating
+		/// per-item auxiliary data demanded later, items are processed one by one.
+		/// All columns must have the same size.
+		/// </summary>
+		inline void process_batch(
+			utils::Span<std::remove_reference_t<Out_type>> outs,
+			utils::Span<std::decay_t<In_type>> in,
+			utils::Span<std::decay_t<In_types>>... ins)
+		{
+			assert(((in.size() == outs.size()) && ... && (ins.size() == outs.size())));
+
+			auto columns = std::make_tuple(in, ins...);
+			process_batch(outs, columns, batch_arena_.rewind(*this), std::index_sequence_for<Modules...>{});
+		}
+
+	private:
+		template<typename Input, std::size_t... Is>
+		inline Out_type process(Input&& in, std::index_sequence<Is...>)
+		{
+			return this->process_item(
+				std::forward<Input>(in),
+				this->template module<Is>()...
+			);
+		}
+
+		template<typename Out, typename Columns, std::size_t... Is>
+		inline void process_batch(
+			utils::Span<Out> outs,
+			Columns& columns,
+			std::pmr::memory_resource& arena,
+			std::index_sequence<Is...>)
+		{
+			process_batch_data(
+				outs,
+				columns,
 				std::tuple<>(),
-				std::get<Modules>(modules_)...
+				arena,
+				this->template module<Is>()...
 			);
 		}
+
+		DP_Batch_arena<(is_arena_user_v<Modules> || ...)> batch_arena_;
 	};
 
-	template<typename Out_type, class... Modules>
-	class DP_Functor<utils::Typelist<>, Out_type, utils::Typelist<Modules...>> :
+	template<typename Out_type, class... Modules, Storage_policy SP>
+	class DP_Functor<utils::Typelist<>, Out_type, utils::Typelist<Modules...>, SP> :
 		public algorithm_assembler::Functor<Out_type>,
-		public virtual DP_Modules<Modules...>
+		public virtual dp_incremental_t<Modules...>,
+		public virtual DP_Modules<SP, Modules...>
 	{
 	public:
 		inline Out_type operator()() override
 		{
-			return process_data(
-				std::tuple<>(),
-				std::tuple<>(),
-				std::get<Modules>(modules_)...);
+			this->reset_arena();
+
+			return process(std::index_sequence_for<Modules...>{});
 		}
 
 		inline bool is_active() const override
 		{
-			return std::get<0>(modules_).is_active();
+			return this->template module<0>().is_active();
+		}
+
+		/// <summary>
+		/// Pulls up to outs.size() items from the source and processes them as a batch.
+		/// </summary>
+		/// <returns>Number of processed items.</returns>
+		inline std::size_t process_batch(utils::Span<std::remove_reference_t<Out_type>> outs)
+		{
+			return process_batch(outs, batch_arena_.rewind(*this), std::index_sequence_for<Modules...>{});
 		}
+
+	private:
+		template<std::size_t... Is>
+		inline Out_type process(std::index_sequence<Is...>)
+		{
+			return this->process_item(
+				std::tuple<>(),
+				this->template module<Is>()...);
+		}
+
+		template<typename Out, std::size_t... Is>
+		inline std::size_t process_batch(
+			utils::Span<Out> outs,
+			std::pmr::memory_resource& arena,
+			std::index_sequence<Is...>)
+		{
+			return process_batch_from_source(outs, arena, this->template module<Is>()...);
+		}
+
+		DP_Batch_arena<(is_arena_user_v<Modules> || ...)> batch_arena_;
 	};
 
+	/// <summary>
+	/// Tag for detecting Data_processor instances used as modules.
+	/// </summary>
+	class Data_processor_ {};
+
+	template<class T>
+	struct is_data_processor : public std::is_base_of<Data_processor_, T> {};
+
+	template<class T>
+	constexpr bool is_data_processor_v = is_data_processor<T>::value;
+
+	template<class Module, typename = void>
+	struct get_modules_list
+	{
+		using type = utils::Typelist<Module>;
+	};
+
+	template<class Module>
+	struct get_modules_list<Module, std::enable_if_t<is_data_processor_v<Module>>>
+	{
+		using type = typename Module::Modules_list;
+	};
+
+	template<Storage_policy SP>
+	struct get_modules_list<Module_storage<SP>>
+	{
+		using type = utils::Typelist<>;
+	};
+
+	template<class Module>
+	struct get_storage_policy
+	{
+		static constexpr Storage_policy value = Storage_policy::compact;
+	};
+
+	template<Storage_policy SP>
+	struct get_storage_policy<Module_storage<SP>>
+	{
+		static constexpr Storage_policy value = SP;
+	};
+
+	template<class Module>
+	constexpr Storage_policy get_storage_policy_v = get_storage_policy<Module>::value;
+
+	template<class Module>
+	struct is_module_storage : public std::false_type {};
+
+	template<Storage_policy SP>
+	struct is_module_storage<Module_storage<SP>> : public std::true_type {};
+
+	template<class Module>
+	constexpr bool is_module_storage_v = is_module_storage<Module>::value;
+
+	/// <summary>
+	/// Replaces nested Data_processor instances by their (already flat) modules lists,
+	/// so a composed pipeline is processed as one chain.
+	/// </summary>
+	template<class... Modules>
+	using flatten_modules_t = utils::concatenation_t<
+		utils::Typelist<>,
+		typename get_modules_list<Modules>::type...
+	>;
+
 	template<Updating_policy UP>
 	struct is_types_with_policy
 	{
@@ -327,37 +672,74 @@ namespace algorithm_assembler::detail
 		typename is_module_demands_type<Demanded_type>::template predicate<void>
 	>;
 
-	template<typename Modules_list, typename Demanded_type>
+	template<typename Modules_list, Storage_policy SP, typename Demanded_type>
 	class DP_Demandant_impl;
 
-	template<class... Modules, typename Demanded_type>
-	class DP_Demandant_impl<utils::Typelist<Modules...>, Demanded_type>
-		: public virtual DP_Modules<Modules...>
+	template<class... Modules, Storage_policy SP, typename Demanded_type>
+	class DP_Demandant_impl<utils::Typelist<Modules...>, SP, Demanded_type>
+		: public Demands_type<Demanded_type>,
+		public virtual DP_Modules<SP, Modules...>,
+		public virtual dp_incremental_t<Modules...>
 	{
 	public:
+		/// <summary>
+		/// Passes the value to all modules demanding it.
+		/// The last result is dropped, as it may depend on the previous value.
+		/// </summary>
 		inline void set(const Demanded_type& in) override
 		{
+			this->for_each_module([&in](auto& module) { set_type_to_demandant(module, in); });
 
+			if constexpr ((is_incremental_stage_v<Modules> || ...))
+				this->reset_last_result();
 		}
 	};
 
 
-	template <typename Modules_list, typename Types_list>
+	template <typename Modules_list, Storage_policy SP, typename Types_list>
 	class DP_Demandant;
 
-	template<typename... _>
-	class DP_Demandant<utils::Typelist<_...>, utils::Typelist<>> {};
+	template<typename Modules_list, Storage_policy SP>
+	class DP_Demandant<Modules_list, SP, utils::Typelist<>> {};
 
-	template<typename Modules_list, typename Demanded_type, typename... Demanded_types_>
-	class DP_Demandant<Modules_list, utils::Typelist<Demanded_type, Demanded_types_...>> :
-		public DP_Demandant_impl<Modules_list, Demanded_type>,
-		public DP_Demandant_impl<Modules_list, Demanded_types_>...
+	template<typename Modules_list, Storage_policy SP, typename Demanded_type, typename... Demanded_types_>
+	class DP_Demandant<Modules_list, SP, utils::Typelist<Demanded_type, Demanded_types_...>> :
+		public DP_Demandant_impl<Modules_list, SP, Demanded_type>,
+		public DP_Demandant_impl<Modules_list, SP, Demanded_types_>...
 	{
 	public:
+		using DP_Demandant_impl<Modules_list, SP, Demanded_type>::set;
+		using DP_Demandant_impl<Modules_list, SP, Demanded_types_>::set...;
+
 		using Demands_types = utils::Typelist<Demanded_type, Demanded_types_...>;
 	};
 
 
+	template<typename Modules_list, Storage_policy SP> class Data_processor_impl;
+
+	template<class Module, class... Modules, Storage_policy SP>
+	class Data_processor_impl<utils::Typelist<Module, Modules...>, SP> :
+		public Data_processor_,
+		public DP_Functor<
+			typename Module::Input_types,
+			typename utils::Typelist<Module, Modules...>::back::Output_type,
+			utils::Typelist<Module, Modules...>,
+			SP
+		>
+		, public DP_Demandant<
+			utils::Typelist<Module, Modules...>,
+			SP,
+			utils::substraction_t<
+				get_demanded_types_t<Module, Modules...>,
+				get_generated_types_t<Module, Modules...>
+			>
+		>
+	{
+	public:
+		using Modules_list = utils::Typelist<Module, Modules...>;
+	};
+
+
 
 
 
@@ -17,6 +17,7 @@ Copyright 2019 Ilia S. Kovalev
 #ifndef DATA_PROCESSOR_FUNCS
 #define DATA_PROCESSOR_FUNCS
 
+#include "../utils/task.hpp"
 #include "../utils/tuple.hpp"
 
 namespace algorithm_assembler::detail
@@ -182,6 +183,9 @@ namespace algorithm_assembler::detail
 
 		if constexpr (utils::contains_v<Tuple, std::add_lvalue_reference_t<T>>)
 			return std::get<std::add_lvalue_reference_t<T>>(std::forward<Tuple>(t));
+
+		if constexpr (utils::contains_v<Tuple, std::add_rvalue_reference_t<std::remove_const_t<std::remove_reference_t<T>>>>)
+			return std::get<std::add_rvalue_reference_t<std::remove_const_t<std::remove_reference_t<T>>>>(std::forward<Tuple>(t));
 	}
 
 	template<typename Tuple, typename... Ts>
@@ -190,14 +194,45 @@ namespace algorithm_assembler::detail
 		return std::make_tuple(std::get<Ts>(std::forward<Tuple>(t))...);
 	}
 
+	template<class T>
+	struct is_async_functor : public std::is_base_of<Async_functor_, T> {};
+
+	template<class T>
+	constexpr bool is_async_functor_v = is_async_functor<T>::value;
+
+	/// <summary>
+	/// Calls a module. Result of an async module is waited for.
+	/// </summary>
+	template<class F, typename... Args>
+	inline auto call_functor(F& f, Args&&... args) -> typename F::Output_type
+	{
+		// Qualified call: the dynamic type of a stored module is always F, so virtual dispatch is skipped.
+#ifdef ALGORITHM_ASSEMBLER_HAS_COROUTINES
+		if constexpr (is_async_functor_v<F>)
+			return utils::sync_wait(f.F::operator()(std::forward<Args>(args)...));
+		else
+#endif
+			return f.F::operator()(std::forward<Args>(args)...);
+	}
+
 	template<class F, typename Input, typename _ = utils::Typelist<>,
 		typename = std::enable_if_t<!utils::is_tuple_v<Input>>
 	>
 		inline auto process_through_functor(F& f, Input&& in, _ = _{}) -> typename F::Output_type
 	{
-		return f(std::forward<Input>(in));
+		return call_functor(f, std::forward<Input>(in));
 	}
 
+	/// <summary>
+	/// Checks if a module takes a tuple as its only input, then a tuple output
+	/// of the previous module is passed as a whole instead of element by element.
+	/// </summary>
+	template<typename Tuple, typename... F_ins>
+	struct is_whole_tuple_input : public std::false_type {};
+
+	template<typename Tuple, typename F_in>
+	struct is_whole_tuple_input<Tuple, F_in> : public std::is_same<std::decay_t<Tuple>, std::decay_t<F_in>> {};
+
 	template<class F, typename Tuple, typename... F_ins,
 		typename = std::enable_if_t<utils::is_tuple_v<Tuple>>
 	>
@@ -207,96 +242,106 @@ namespace algorithm_assembler::detail
 			utils::Typelist<F_ins...>&&
 		) -> typename F::Output_type
 	{
-		return f(
-			tuple_get_wrapper<F_ins>(std::forward<Tuple>(in_tuple)
-				)...);
+		if constexpr (is_whole_tuple_input<Tuple, F_ins...>::value)
+			return call_functor(f, std::forward<Tuple>(in_tuple));
+		else
+			return call_functor(f,
+				tuple_get_wrapper<F_ins>(std::forward<Tuple>(in_tuple)
+					)...);
 	}
 
-	template<typename Input, class F, class... Fs, typename... Ts>
-	inline auto process_data(Input&& in, std::tuple<Ts...>&& aux, F& f, Fs&... tail)
-		-> typename utils::Typelist<F, Fs...>::back::Output_type
+	/// <summary>
+	/// Transforms auxiliary data by module and collects auxiliary data for the next modules:
+	/// remaining demanded values and values generated by the module.
+	/// </summary>
+	template<class F, class... Fs, typename... Ts>
+	inline auto pass_aux_data(std::tuple<Ts...>&& aux, F& f, Fs&... tail)
 	{
-		using Available_aux_types = utils::map_t<utils::Typelist<Ts...>, unpack_optional<void>>;
-		
+		transform(f, aux);
 
-		set_to_demandant(f, aux);
+		using Generated_now_const_types =
+			get_generated_types_by_policy_t<Updating_policy::never, F>;
 
-		if constexpr (sizeof...(Fs) > 0)
-		{
-			auto&& output = process_through_functor(f,
-				std::forward<Input>(in),
-				F::Input_types{}
-			);
+		using Transforming_later_non_const_types =
+			utils::unique_t<utils::concatenation_t<
+				get_transformed_types_by_policy_t<Updating_policy::always, Fs...>,
+				get_transformed_types_by_policy_t<Updating_policy::sometimes, Fs...>
+			>>;
 
-			transform(f, aux);
+		using Const_generated_types_transformed_later =
+			utils::intersection_t<
+				Generated_now_const_types,
+				Transforming_later_non_const_types
+			>;
 
-			using Generated_now_const_types =
-				get_generated_types_by_policy_t<Updating_policy::never, F>;
+		using Generated_now = utils::concatenation_t<
+			get_generated_types_by_policy_t<Updating_policy::always, F>,
+			get_generated_types_by_policy_t<Updating_policy::sometimes, F>,
+			Const_generated_types_transformed_later
+		>;
 
-			using Transforming_later_non_const_types =
-				utils::unique_t<utils::concatenation_t<
-					get_transformed_types_by_policy_t<Updating_policy::always, Fs...>,
-					get_transformed_types_by_policy_t<Updating_policy::sometimes, Fs...>
-				>>;
+		using Demanded_generated_now = utils::intersection_t<
+			Generated_now,
+			get_demanded_types_t<Fs...>
+		>;
 
-			using Const_generated_types_transformed_later =
+		using Optional = utils::concatenation_t<
+			utils::substraction_t<
 				utils::intersection_t<
-					Generated_now_const_types,
-					Transforming_later_non_const_types
-				>;
+					Demanded_generated_now,
+					get_generated_types_of_module_by_policy_t<F, Updating_policy::sometimes>
+				>,
+				get_generated_types_by_policy_t<Updating_policy::always, F>
+			>,
+			utils::intersection_t<
+				Demanded_generated_now,
+				get_generated_types_of_module_by_policy_t<F, Updating_policy::never>,
+				get_transformed_types_by_policy_t<Updating_policy::sometimes, Fs...>
+			>
+		>;
 
-			using Generated_now = utils::concatenation_t<
-				get_generated_types_by_policy_t<Updating_policy::always, F>,
-				get_generated_types_by_policy_t<Updating_policy::sometimes, F>,
-				Const_generated_types_transformed_later
-			>;
+		using Non_optional = utils::substraction_t<
+			Demanded_generated_now,
+			Optional
+		>;
 
-			using Demanded_generated_now = utils::intersection_t<
-				Generated_now,
+		using Remaining_types = utils::concatenation_t<
+			utils::intersection_t<
+				utils::Typelist<Ts...>,
 				get_demanded_types_t<Fs...>
-			>;
-
-			using Optional = utils::concatenation_t<
-				utils::substraction_t<
-					utils::intersection_t<
-						Demanded_generated_now,
-						get_generated_types_of_module_by_policy_t<F, Updating_policy::sometimes>
-					>,
-					get_generated_types_by_policy_t<Updating_policy::always, F>
-				>,
-				utils::intersection_t<
-					Demanded_generated_now,
-					get_generated_types_of_module_by_policy_t<F, Updating_policy::never>,
-					get_transformed_types_by_policy_t<Updating_policy::sometimes, Fs...>
-				>
-			>;
+			>,
+			utils::intersection_t<
+				utils::Typelist<Ts...>,
+				utils::map_t<get_demanded_types_t<Fs...>, to_optional<void>>
+			>
+		>;
+
+		return std::tuple_cat(
+			filter_listed_types(
+				std::forward<std::tuple<Ts...>>(aux),
+				Remaining_types{}
+			),
+			get_generated(f, Non_optional{}),
+			get_optional_generated(f, Optional{}, tail...)
+		);
+	}
 
-			using Non_optional = utils::substraction_t<
-				Demanded_generated_now,
-				Optional
-			>;
+	template<typename Input, class F, class... Fs, typename... Ts>
+	inline auto process_data(Input&& in, std::tuple<Ts...>&& aux, F& f, Fs&... tail)
+		-> typename utils::Typelist<F, Fs...>::back::Output_type
+	{
+		set_to_demandant(f, aux);
 
-			using Remaining_types = utils::concatenation_t<
-				utils::intersection_t<
-					utils::Typelist<Ts...>,
-					get_demanded_types_t<Fs...>
-				>,
-				utils::intersection_t<
-					utils::Typelist<Ts...>,
-					utils::map_t<get_demanded_types_t<Fs...>, to_optional<void>>
-				>
-			>;
+		if constexpr (sizeof...(Fs) > 0)
+		{
+			auto&& output = process_through_functor(f,
+				std::forward<Input>(in),
+				F::Input_types{}
+			);
 
 			return process_data(
 				std::forward<F::Output_type>(output),
-				std::tuple_cat(
-					filter_listed_types(
-						std::forward<std::tuple<Ts...>>(aux),
-						Remaining_types{}
-					),
-					get_generated(f, Non_optional{}),
-					get_optional_generated(f, Optional{}, tail...)
-				),
+				pass_aux_data(std::forward<std::tuple<Ts...>>(aux), f, tail...),
 				tail...);
 		}
 		else
@@ -0,0 +1,177 @@
+/*
+Copyright 2019 Ilia S. Kovalev
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef DATA_PROCESSOR_INCREMENTAL_FUNCS
+#define DATA_PROCESSOR_INCREMENTAL_FUNCS
+
+#include <cstdint>
+#include <optional>
+
+#include "../utils/misc.hpp"
+#include "data_processor_funcs.hpp"
+
+namespace algorithm_assembler::detail
+{
+	template<class T>
+	struct is_comparable_output : public std::is_base_of<Comparable_output_, T> {};
+
+	template<class T>
+	constexpr bool is_comparable_output_v = is_comparable_output<T>::value;
+
+	template<class T>
+	struct is_versioned_output : public std::is_base_of<Versioned_output_, T> {};
+
+	template<class T>
+	constexpr bool is_versioned_output_v = is_versioned_output<T>::value;
+
+	template<class T>
+	constexpr bool is_incremental_stage_v = is_comparable_output_v<T> || is_versioned_output_v<T>;
+
+
+	template<typename Tuple>
+	struct is_aux_comparable;
+
+	template<typename... Ts>
+	struct is_aux_comparable<std::tuple<Ts...>> :
+		public std::bool_constant<(utils::is_equality_comparable_v<Ts> && ...)>
+	{};
+
+	/// <summary>
+	/// Type of auxiliary data passed by module F to the next ones.
+	/// </summary>
+	template<typename Aux, class F, class... Fs>
+	using passed_aux_t = decltype(pass_aux_data(std::declval<Aux>(), std::declval<F&>(), std::declval<Fs&>()...));
+
+
+	/// <summary>
+	/// Output and passed auxiliary data of a module for the previous item.
+	/// </summary>
+	template<class F, typename Passed_aux, bool = is_incremental_stage_v<F>>
+	class Stage_output_cache
+	{
+	public:
+		template<typename Output>
+		inline bool update(const Output&, const F&, const Passed_aux&) noexcept { return false; }
+	};
+
+	template<class F, typename Passed_aux>
+	class Stage_output_cache<F, Passed_aux, true>
+	{
+		static_assert(is_aux_comparable<Passed_aux>::value,
+			"Auxiliary data passed by a Comparable_output or Versioned_output module must be equality comparable");
+
+	public:
+		/// <summary>
+		/// Compares output and passed auxiliary data with the previous ones and keeps the new ones.
+		/// </summary>
+		/// <returns>true if nothing changed.</returns>
+		template<typename Output>
+		inline bool update(const Output& output, const F& f, const Passed_aux& aux)
+		{
+			bool is_output_same;
+			if constexpr (is_versioned_output_v<F>)
+				is_output_same = check_and_keep(last_output_, f.output_version());
+			else
+				is_output_same = check_and_keep(last_output_, output);
+
+			bool is_aux_same = check_and_keep(last_aux_, aux);
+
+			return is_output_same && is_aux_same;
+		}
+
+	private:
+		template<typename T, typename U>
+		static inline bool check_and_keep(std::optional<T>& last, const U& value)
+		{
+			if (last.has_value() && *last == value)
+				return true;
+
+			last = value;
+			return false;
+		}
+
+		using Stored_output = std::conditional_t<
+			is_versioned_output_v<F>,
+			std::uint64_t,
+			std::decay_t<typename F::Output_type>
+		>;
+
+		std::optional<Stored_output> last_output_;
+		std::optional<Passed_aux> last_aux_;
+	};
+
+
+	/// <summary>
+	/// Per-stage caches of a modules chain, the last module needs none.
+	/// </summary>
+	template<typename Aux, class... Fs>
+	struct Incremental_cache;
+
+	template<typename Aux, class F>
+	struct Incremental_cache<Aux, F> {};
+
+	template<typename Aux, class F, class F_next, class... Fs>
+	struct Incremental_cache<Aux, F, F_next, Fs...>
+	{
+		using Passed_aux = passed_aux_t<Aux, F, F_next, Fs...>;
+
+		Stage_output_cache<F, Passed_aux> stage;
+		Incremental_cache<Passed_aux, F_next, Fs...> next;
+	};
+
+
+	/// <summary>
+	/// Same as process_data, but returns the previous result once output of a module
+	/// with Comparable_output or Versioned_output and auxiliary data passed by it are unchanged.
+	/// </summary>
+	/// <param name="last_result">Result of the previous item, empty if unknown.</param>
+	template<typename Result, typename Cache, typename Input, class F, class... Fs, typename... Ts>
+	inline auto process_data_incremental(
+		Cache& cache,
+		std::optional<Result>& last_result,
+		Input&& in,
+		std::tuple<Ts...>&& aux,
+		F& f,
+		Fs&... tail
+	) -> typename utils::Typelist<F, Fs...>::back::Output_type
+	{
+		set_to_demandant(f, aux);
+
+		if constexpr (sizeof...(Fs) > 0)
+		{
+			auto&& output = process_through_functor(f,
+				std::forward<Input>(in),
+				typename F::Input_types{}
+			);
+
+			auto passed_aux = pass_aux_data(std::forward<std::tuple<Ts...>>(aux), f, tail...);
+
+			if (cache.stage.update(output, f, passed_aux) && last_result.has_value())
+				return std::move(*last_result);
+
+			return process_data_incremental(
+				cache.next,
+				last_result,
+				std::forward<typename F::Output_type>(output),
+				std::move(passed_aux),
+				tail...);
+		}
+		else
+			return process_through_functor(f, std::forward<Input>(in), typename F::Input_types{});
+	}
+}
+
+#endif
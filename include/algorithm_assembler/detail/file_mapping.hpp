@@ -0,0 +1,190 @@
+/*
+Copyright 2019 Ilia S. Kovalev
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef FILE_MAPPING_HPP
+#define FILE_MAPPING_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <system_error>
+
+#ifdef _WIN32
+	#ifndef WIN32_LEAN_AND_MEAN
+		#define WIN32_LEAN_AND_MEAN
+	#endif
+	#ifndef NOMINMAX
+		#define NOMINMAX
+	#endif
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+namespace algorithm_assembler::detail
+{
+	/// <summary>
+	/// Read-only file mapped into memory by windows.
+	/// At most one window is mapped at a time.
+	/// </summary>
+	class File_mapping
+	{
+	public:
+		File_mapping() = default;
+
+		File_mapping(const File_mapping&) = delete;
+		File_mapping& operator=(const File_mapping&) = delete;
+
+		~File_mapping() { close(); }
+
+		inline void open(const std::string& path)
+		{
+			close();
+
+#ifdef _WIN32
+			file_ = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+				OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+			if (file_ == INVALID_HANDLE_VALUE)
+				throw_last_error("Cannot open " + path);
+
+			LARGE_INTEGER size;
+			if (!GetFileSizeEx(file_, &size))
+				throw_last_error("Cannot get size of " + path);
+			size_ = static_cast<std::uint64_t>(size.QuadPart);
+
+			if (size_ > 0)
+			{
+				mapping_ = CreateFileMappingA(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+				if (mapping_ == nullptr)
+					throw_last_error("Cannot map " + path);
+			}
+#else
+			fd_ = ::open(path.c_str(), O_RDONLY);
+			if (fd_ < 0)
+				throw_last_error("Cannot open " + path);
+
+			struct stat st;
+			if (fstat(fd_, &st) != 0)
+				throw_last_error("Cannot get size of " + path);
+			size_ = static_cast<std::uint64_t>(st.st_size);
+#endif
+		}
+
+		inline void close() noexcept
+		{
+			unmap();
+
+#ifdef _WIN32
+			if (mapping_ != nullptr)
+				CloseHandle(mapping_);
+			if (file_ != INVALID_HANDLE_VALUE)
+				CloseHandle(file_);
+			mapping_ = nullptr;
+			file_ = INVALID_HANDLE_VALUE;
+#else
+			if (fd_ >= 0)
+				::close(fd_);
+			fd_ = -1;
+#endif
+			size_ = 0;
+		}
+
+		/// <summary>
+		/// Maps a window of the file, previous window is unmapped.
+		/// Offset must be a multiple of granularity().
+		/// </summary>
+		/// <returns>Pointer to the first byte of the window.</returns>
+		inline const std::byte* map(std::uint64_t offset, std::size_t length)
+		{
+			unmap();
+
+#ifdef _WIN32
+			view_ = MapViewOfFile(mapping_, FILE_MAP_READ,
+				static_cast<DWORD>(offset >> 32), static_cast<DWORD>(offset & 0xFFFFFFFF), length);
+			if (view_ == nullptr)
+				throw_last_error("Cannot map view of file");
+#else
+			view_ = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd_, static_cast<off_t>(offset));
+			if (view_ == MAP_FAILED)
+			{
+				view_ = nullptr;
+				throw_last_error("Cannot map view of file");
+			}
+
+			// Hints only, failures are harmless.
+			madvise(view_, length, MADV_SEQUENTIAL);
+			madvise(view_, length, MADV_WILLNEED);
+#endif
+			view_length_ = length;
+			return static_cast<const std::byte*>(view_);
+		}
+
+		inline void unmap() noexcept
+		{
+			if (view_ == nullptr)
+				return;
+
+#ifdef _WIN32
+			UnmapViewOfFile(view_);
+#else
+			munmap(view_, view_length_);
+#endif
+			view_ = nullptr;
+			view_length_ = 0;
+		}
+
+		inline std::uint64_t size() const noexcept { return size_; }
+
+		/// <summary>
+		/// Alignment of window offsets.
+		/// </summary>
+		static inline std::size_t granularity() noexcept
+		{
+#ifdef _WIN32
+			SYSTEM_INFO info;
+			GetSystemInfo(&info);
+			return info.dwAllocationGranularity;
+#else
+			return static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+#endif
+		}
+
+	private:
+		[[noreturn]] static void throw_last_error(const std::string& what)
+		{
+#ifdef _WIN32
+			throw std::system_error(static_cast<int>(GetLastError()), std::system_category(), what);
+#else
+			throw std::system_error(errno, std::generic_category(), what);
+#endif
+		}
+
+#ifdef _WIN32
+		HANDLE file_ = INVALID_HANDLE_VALUE;
+		HANDLE mapping_ = nullptr;
+#else
+		int fd_ = -1;
+#endif
+		std::uint64_t size_ = 0;
+		void* view_ = nullptr;
+		std::size_t view_length_ = 0;
+	};
+}
+
+#endif
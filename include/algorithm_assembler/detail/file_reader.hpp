@@ -0,0 +1,325 @@
+/*
+Copyright 2019 Ilia S. Kovalev
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef FILE_READER_HPP
+#define FILE_READER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include "../utils/span.hpp"
+#include "../utils/thread_pool.hpp"
+#include "io_uring.hpp"
+
+#ifdef _WIN32
+	#ifndef WIN32_LEAN_AND_MEAN
+		#define WIN32_LEAN_AND_MEAN
+	#endif
+	#ifndef NOMINMAX
+		#define NOMINMAX
+	#endif
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
+
+namespace algorithm_assembler::detail
+{
+	/// <summary>
+	/// Read-only file with positional reads, safe to use from several threads.
+	/// </summary>
+	class File_reader
+	{
+	public:
+		explicit File_reader(const std::string& path)
+		{
+#ifdef _WIN32
+			file_ = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+				OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+			if (file_ == INVALID_HANDLE_VALUE)
+				throw std::system_error(static_cast<int>(GetLastError()), std::system_category(), "Cannot open " + path);
+#else
+			fd_ = ::open(path.c_str(), O_RDONLY);
+			if (fd_ < 0)
+				throw std::system_error(errno, std::generic_category(), "Cannot open " + path);
+#endif
+		}
+
+		File_reader(const File_reader&) = delete;
+		File_reader& operator=(const File_reader&) = delete;
+
+		~File_reader()
+		{
+#ifdef _WIN32
+			CloseHandle(file_);
+#else
+			::close(fd_);
+#endif
+		}
+
+		/// <summary>
+		/// Reads until the buffer is full or end of file is reached.
+		/// </summary>
+		/// <returns>Number of read bytes.</returns>
+		inline std::size_t read_at(std::byte* data, std::size_t size, std::uint64_t offset) const
+		{
+			std::size_t total = 0;
+
+			while (total < size)
+			{
+#ifdef _WIN32
+				OVERLAPPED overlapped{};
+				overlapped.Offset = static_cast<DWORD>(offset & 0xFFFFFFFF);
+				overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+
+				DWORD read = 0;
+				auto chunk = static_cast<DWORD>(size - total < 0x40000000 ? size - total : 0x40000000);
+				if (!ReadFile(file_, data + total, chunk, &read, &overlapped))
+				{
+					if (GetLastError() == ERROR_HANDLE_EOF)
+						break;
+					throw std::system_error(static_cast<int>(GetLastError()), std::system_category(), "Cannot read file");
+				}
+#else
+				auto read = pread(fd_, data + total, size - total, static_cast<off_t>(offset));
+				if (read < 0)
+				{
+					if (errno == EINTR)
+						continue;
+					throw std::system_error(errno, std::generic_category(), "Cannot read file");
+				}
+#endif
+				if (read == 0)
+					break;
+
+				total += static_cast<std::size_t>(read);
+				offset += static_cast<std::uint64_t>(read);
+			}
+
+			return total;
+		}
+
+#ifndef _WIN32
+		inline int native_handle() const noexcept { return fd_; }
+#endif
+
+	private:
+#ifdef _WIN32
+		HANDLE file_ = INVALID_HANDLE_VALUE;
+#else
+		int fd_ = -1;
+#endif
+	};
+
+
+	/// <summary>
+	/// Read request occupying one slot of a read queue.
+	/// </summary>
+	struct Read_request
+	{
+		std::shared_ptr<const File_reader> file;
+		std::uint64_t offset = 0;
+		std::size_t size = 0;
+	};
+
+	/// <summary>
+	/// Executes reads into fixed slot buffers by a thread pool.
+	/// </summary>
+	class Pool_read_queue
+	{
+	public:
+		inline void init(std::size_t threads, utils::Span<utils::Span<std::byte>> buffers)
+		{
+			pool_ = std::make_unique<utils::Thread_pool>(threads);
+			buffers_.assign(buffers.begin(), buffers.end());
+			results_.clear();
+			results_.resize(buffers.size());
+		}
+
+		inline void submit(std::size_t slot, const Read_request& request)
+		{
+			results_[slot] = pool_->submit([request, buffer = buffers_[slot]]() {
+				return request.file->read_at(buffer.data(), request.size, request.offset);
+			});
+		}
+
+		/// <returns>Number of read bytes.</returns>
+		inline std::size_t wait(std::size_t slot, const Read_request&)
+		{
+			return results_[slot].get();
+		}
+
+		/// <summary>
+		/// Waits for all submitted reads, so buffers may be released.
+		/// </summary>
+		inline void drain() noexcept
+		{
+			for (auto& r : results_)
+				if (r.valid())
+					r.wait();
+		}
+
+	private:
+		std::unique_ptr<utils::Thread_pool> pool_;
+		std::vector<utils::Span<std::byte>> buffers_;
+		std::vector<std::future<std::size_t>> results_;
+	};
+
+#ifdef ALGORITHM_ASSEMBLER_HAS_IO_URING
+	/// <summary>
+	/// Executes reads into fixed slot buffers by io_uring.
+	/// Buffers are registered if the system allows it, so they are not mapped on every read.
+	/// Reads are prepared by submit() and handed to the kernel together on the next wait(),
+	/// the ones the kernel does not accept are read synchronously.
+	/// </summary>
+	class Uring_read_queue
+	{
+	public:
+		/// <returns>False if io_uring is not available.</returns>
+		inline bool init(utils::Span<utils::Span<std::byte>> buffers)
+		{
+			if (!ring_.init(static_cast<unsigned>(buffers.size())))
+				return false;
+
+			buffers_.assign(buffers.begin(), buffers.end());
+			results_.assign(buffers.size(), 0);
+			done_.assign(buffers.size(), false);
+			pending_.clear();
+			in_flight_ = 0;
+
+			std::vector<iovec> iovecs;
+			for (auto& b : buffers_)
+				iovecs.push_back({ b.data(), b.size() });
+			registered_ = ring_.register_buffers(iovecs.data(), static_cast<unsigned>(iovecs.size()));
+
+			return true;
+		}
+
+		inline void submit(std::size_t slot, const Read_request& request)
+		{
+			auto fd = request.file->native_handle();
+			auto data = buffers_[slot].data();
+			auto size = static_cast<unsigned>(request.size);
+
+			done_[slot] = false;
+
+			bool is_prepared = registered_
+				? ring_.prepare_read_fixed(fd, data, size, request.offset, static_cast<unsigned>(slot), slot)
+				: ring_.prepare_read(fd, data, size, request.offset, slot);
+
+			if (is_prepared)
+				pending_.push_back({ slot, request });
+			else
+				read_now(slot, request);
+		}
+
+		/// <returns>Number of read bytes.</returns>
+		inline std::size_t wait(std::size_t slot, const Read_request& request)
+		{
+			flush();
+
+			while (!done_[slot])
+				complete_one();
+
+			auto result = results_[slot];
+			if (result < 0)
+				throw std::system_error(static_cast<int>(-result), std::generic_category(), "Cannot read file");
+
+			// Rest of a short read is read synchronously.
+			auto read = static_cast<std::size_t>(result);
+			if (read > 0 && read < request.size)
+				read += request.file->read_at(buffers_[slot].data() + read, request.size - read, request.offset + read);
+
+			return read;
+		}
+
+		inline void drain() noexcept
+		{
+			ring_.drop_unsubmitted();
+			pending_.clear();
+
+			while (in_flight_ > 0)
+				if (!complete_one_noexcept())
+					break;
+		}
+
+		inline bool uses_registered_buffers() const noexcept { return registered_; }
+
+	private:
+		/// <summary>
+		/// Submits prepared reads at once. Reads are accepted in order, the ones the kernel
+		/// did not take are dropped from the ring and read synchronously.
+		/// </summary>
+		inline void flush()
+		{
+			if (pending_.empty())
+				return;
+
+			int result = ring_.submit();
+			auto submitted = static_cast<std::size_t>(result > 0 ? result : 0);
+			ring_.drop_unsubmitted();
+			in_flight_ += submitted;
+
+			auto pending = std::move(pending_);
+			pending_.clear();
+			for (auto p = pending.begin() + submitted; p != pending.end(); ++p)
+				read_now(p->first, p->second);
+		}
+
+		inline void read_now(std::size_t slot, const Read_request& request)
+		{
+			results_[slot] = static_cast<std::int64_t>(
+				request.file->read_at(buffers_[slot].data(), request.size, request.offset));
+			done_[slot] = true;
+		}
+
+		inline void complete_one()
+		{
+			if (!complete_one_noexcept())
+				throw std::system_error(errno, std::generic_category(), "Cannot wait for read");
+		}
+
+		inline bool complete_one_noexcept() noexcept
+		{
+			Io_uring::Completion completion;
+			if (!ring_.wait(completion))
+				return false;
+
+			results_[completion.user_data] = completion.result;
+			done_[completion.user_data] = true;
+			--in_flight_;
+			return true;
+		}
+
+		Io_uring ring_;
+		bool registered_ = false;
+		std::vector<utils::Span<std::byte>> buffers_;
+		std::vector<std::int64_t> results_;
+		std::vector<bool> done_;
+		std::vector<std::pair<std::size_t, Read_request>> pending_;
+		std::size_t in_flight_ = 0;
+	};
+#endif
+}
+
+#endif
@@ -0,0 +1,291 @@
+/*
+Copyright 2019 Ilia S. Kovalev
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef FILE_WRITER_HPP
+#define FILE_WRITER_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <string>
+#include <system_error>
+#include <thread>
+
+#include "../utils/span.hpp"
+#include "io_uring.hpp"
+
+#ifdef _WIN32
+	#ifndef WIN32_LEAN_AND_MEAN
+		#define WIN32_LEAN_AND_MEAN
+	#endif
+	#ifndef NOMINMAX
+		#define NOMINMAX
+	#endif
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+namespace algorithm_assembler::detail
+{
+	/// <summary>
+	/// Writes batches of buffers to a file at sequential offsets.
+	/// A batch is submitted to io_uring at once when it is available, otherwise buffers are written by pwrite.
+	/// </summary>
+	class File_writer
+	{
+	public:
+		File_writer() = default;
+
+		File_writer(const File_writer&) = delete;
+		File_writer& operator=(const File_writer&) = delete;
+
+		~File_writer() { close(); }
+
+		inline void open(const std::string& path, bool append, unsigned queue_depth = 32)
+		{
+			close();
+
+#ifdef _WIN32
+			file_ = CreateFileA(path.c_str(), GENERIC_WRITE, FILE_SHARE_READ, nullptr,
+				append ? OPEN_ALWAYS : CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+			if (file_ == INVALID_HANDLE_VALUE)
+				throw_last_error("Cannot open " + path);
+
+			LARGE_INTEGER size;
+			if (!GetFileSizeEx(file_, &size))
+				throw_last_error("Cannot get size of " + path);
+			offset_ = static_cast<std::uint64_t>(size.QuadPart);
+#else
+			fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | (append ? 0 : O_TRUNC), 0644);
+			if (fd_ < 0)
+				throw_last_error("Cannot open " + path);
+
+			struct stat st;
+			if (fstat(fd_, &st) != 0)
+				throw_last_error("Cannot get size of " + path);
+			offset_ = static_cast<std::uint64_t>(st.st_size);
+#endif
+
+#ifdef ALGORITHM_ASSEMBLER_HAS_IO_URING
+			ring_.init(queue_depth);
+#else
+			(void)queue_depth;
+#endif
+		}
+
+		inline void close() noexcept
+		{
+#ifdef ALGORITHM_ASSEMBLER_HAS_IO_URING
+			ring_.release();
+#endif
+
+#ifdef _WIN32
+			if (file_ != INVALID_HANDLE_VALUE)
+				CloseHandle(file_);
+			file_ = INVALID_HANDLE_VALUE;
+#else
+			if (fd_ >= 0)
+				::close(fd_);
+			fd_ = -1;
+#endif
+			offset_ = 0;
+		}
+
+		/// <summary>
+		/// Appends buffers to the file in the given order.
+		/// </summary>
+		template<class Buffer>
+		inline void write(utils::Span<Buffer> buffers)
+		{
+#ifdef ALGORITHM_ASSEMBLER_HAS_IO_URING
+			if (ring_.is_initialized())
+			{
+				write_by_ring(buffers);
+				return;
+			}
+#endif
+			for (auto& b : buffers)
+			{
+				write_at(b->data(), b->size(), offset_);
+				offset_ += b->size();
+			}
+		}
+
+		/// <summary>
+		/// Number of bytes in the file.
+		/// </summary>
+		inline std::uint64_t size() const noexcept { return offset_; }
+
+		inline bool uses_io_uring() const noexcept
+		{
+#ifdef ALGORITHM_ASSEMBLER_HAS_IO_URING
+			return ring_.is_initialized();
+#else
+			return false;
+#endif
+		}
+
+	private:
+		inline void write_at(const std::byte* data, std::size_t size, std::uint64_t offset)
+		{
+			while (size > 0)
+			{
+#ifdef _WIN32
+				OVERLAPPED overlapped{};
+				overlapped.Offset = static_cast<DWORD>(offset & 0xFFFFFFFF);
+				overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+
+				DWORD written = 0;
+				auto chunk = static_cast<DWORD>(size < 0x40000000 ? size : 0x40000000);
+				if (!WriteFile(file_, data, chunk, &written, &overlapped))
+					throw_last_error("Cannot write to file");
+#else
+				auto written = pwrite(fd_, data, size, static_cast<off_t>(offset));
+				if (written < 0)
+				{
+					if (errno == EINTR)
+						continue;
+					throw_last_error("Cannot write to file");
+				}
+#endif
+				data += written;
+				size -= static_cast<std::size_t>(written);
+				offset += static_cast<std::uint64_t>(written);
+			}
+		}
+
+#ifdef ALGORITHM_ASSEMBLER_HAS_IO_URING
+		/// <summary>
+		/// Requests are limited to this size, the rest of a greater buffer is written as after a short write.
+		/// </summary>
+		static constexpr std::size_t max_request_size = std::size_t{ 1 } << 30;
+
+		template<class Buffer>
+		inline void write_by_ring(utils::Span<Buffer> buffers)
+		{
+			std::size_t i = 0;
+			while (i < buffers.size())
+			{
+				auto first = i;
+				auto offset = offset_;
+
+				for (; i < buffers.size() && i - first < ring_.entries(); ++i)
+				{
+					auto size = std::min(buffers[i]->size(), max_request_size);
+					if (!ring_.prepare_write(fd_, buffers[i]->data(), static_cast<unsigned>(size), offset, i))
+						break;
+					offset += buffers[i]->size();
+				}
+
+				if (i == first)
+				{
+					write_at(buffers[i]->data(), buffers[i]->size(), offset_);
+					offset_ += buffers[i++]->size();
+					continue;
+				}
+
+				// Requests are accepted in order, the ones the kernel did not take
+				// are dropped from the ring and written synchronously.
+				int result = ring_.submit();
+				auto submitted = static_cast<std::size_t>(result > 0 ? result : 0);
+				ring_.drop_unsubmitted();
+
+				// The kernel reads the buffers until their completions arrive,
+				// so all of them are reaped before an error is thrown.
+				std::exception_ptr error;
+				for (std::size_t c = 0; c < submitted; ++c)
+				{
+					Io_uring::Completion completion;
+					if (!ring_.wait(completion))
+					{
+						if (!error)
+							error = std::make_exception_ptr(
+								std::system_error(errno, std::generic_category(), "Cannot wait for writes"));
+						while (!ring_.peek(completion))
+							std::this_thread::yield();
+					}
+
+					if (completion.result < 0 && !error)
+						error = std::make_exception_ptr(
+							std::system_error(-completion.result, std::generic_category(), "Cannot write to file"));
+
+					if (error)
+						continue;
+
+					// Rest of a short write is written synchronously.
+					auto& b = buffers[completion.user_data];
+					auto written = static_cast<std::size_t>(completion.result);
+					if (written < b->size())
+					{
+						try
+						{
+							write_at(b->data() + written, b->size() - written,
+								buffer_offset(buffers, first, completion.user_data) + written);
+						}
+						catch (...)
+						{
+							error = std::current_exception();
+						}
+					}
+				}
+
+				if (error)
+					std::rethrow_exception(error);
+
+				for (auto j = first + submitted; j < i; ++j)
+					write_at(buffers[j]->data(), buffers[j]->size(), buffer_offset(buffers, first, j));
+
+				offset_ = offset;
+			}
+		}
+
+		template<class Buffer>
+		inline std::uint64_t buffer_offset(utils::Span<Buffer> buffers, std::size_t first, std::uint64_t index) const noexcept
+		{
+			auto offset = offset_;
+			for (auto j = first; j < index; ++j)
+				offset += buffers[j]->size();
+			return offset;
+		}
+#endif
+
+		[[noreturn]] static void throw_last_error(const std::string& what)
+		{
+#ifdef _WIN32
+			throw std::system_error(static_cast<int>(GetLastError()), std::system_category(), what);
+#else
+			throw std::system_error(errno, std::generic_category(), what);
+#endif
+		}
+
+#ifdef _WIN32
+		HANDLE file_ = INVALID_HANDLE_VALUE;
+#else
+		int fd_ = -1;
+#endif
+
+#ifdef ALGORITHM_ASSEMBLER_HAS_IO_URING
+		Io_uring ring_;
+#endif
+		std::uint64_t offset_ = 0;
+	};
+}
+
+#endif
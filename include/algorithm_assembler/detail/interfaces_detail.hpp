@@ -21,16 +21,33 @@ Copyright 2019 Ilia S. Kovalev
 
 #include "../interfaces.hpp"
 #include "../enums.hpp"
+#include "../utils/span.hpp"
 
 namespace algorithm_assembler
 {
 	template<Updating_policy, typename, typename...> struct Types_with_policy;
+
+	template<typename> struct Contiguous;
+
+	template<typename> struct unwrap_contiguous;
 }
 
 namespace algorithm_assembler::detail
 {
 	class Functor_ {};
 
+	class Batch_functor_ {};
+
+	class Async_functor_ {};
+
+	class Comparable_output_ {};
+
+	class Versioned_output_ {};
+
+	class Transient_output_ {};
+
+	class Optional_stage_ {};
+
 
 	class Generator {};
 
@@ -70,8 +87,8 @@ namespace algorithm_assembler::detail
 
 	template<Updating_policy UP, typename T, typename... Ts>
 	class Generates_types_with_policy<Types_with_policy<UP, T, Ts... >> :
-		public Generates_type_with_policy<UP, T>,
-		public Generates_type_with_policy<UP, Ts>...
+		public Generates_type_with_policy<UP, typename unwrap_contiguous<T>::type>,
+		public Generates_type_with_policy<UP, typename unwrap_contiguous<Ts>::type>...
 	{};
 
 
@@ -115,13 +132,46 @@ namespace algorithm_assembler::detail
 		template<> virtual bool is_transformation_changed<T>() const;
 	};
 
+	template<Updating_policy UP, typename T>
+	class Transforms_contiguous_type_with_policy :
+		public Transforms_type_with_policy<UP, T>
+	{
+	public:
+		using Element_type = std::remove_pointer_t<decltype(std::declval<T&>().data())>;
+
+		/// <summary>
+		/// Transforms all elements of referenced value at once.
+		/// </summary>
+		virtual void transform(utils::Span<Element_type> data) = 0;
+
+		void transform(T& data) override
+		{
+			transform(utils::Span<Element_type>(data.data(), data.size()));
+		}
+	};
+
+	template<Updating_policy UP, typename T>
+	struct get_transforms_type_with_policy
+	{
+		using type = Transforms_type_with_policy<UP, T>;
+	};
+
+	template<Updating_policy UP, typename T>
+	struct get_transforms_type_with_policy<UP, Contiguous<T>>
+	{
+		using type = Transforms_contiguous_type_with_policy<UP, T>;
+	};
+
+	template<Updating_policy UP, typename T>
+	using get_transforms_type_with_policy_t = typename get_transforms_type_with_policy<UP, T>::type;
+
 	template<typename Types_with_policy>
 	class Transforms_types_with_policy;
 
 	template<Updating_policy UP, typename T, typename... Ts>
 	class Transforms_types_with_policy<Types_with_policy<UP, T, Ts...>> :
-		public Transforms_type_with_policy<UP, T>,
-		public Transforms_type_with_policy<UP, Ts>...
+		public get_transforms_type_with_policy_t<UP, T>,
+		public get_transforms_type_with_policy_t<UP, Ts>...
 	{};
 
 
@@ -142,6 +192,9 @@ namespace algorithm_assembler::detail
 	class Uses_settings {};
 
 
+	class Uses_arena {};
+
+
 }
 
 #endif
\ No newline at end of file
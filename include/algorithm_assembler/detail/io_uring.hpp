@@ -0,0 +1,290 @@
+/*
+Copyright 2019 Ilia S. Kovalev
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef IO_URING_HPP
+#define IO_URING_HPP
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+
+#define ALGORITHM_ASSEMBLER_HAS_IO_URING 1
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace algorithm_assembler::detail
+{
+	/// <summary>
+	/// Minimal io_uring wrapper built directly on system calls, so liburing is not required.
+	/// Not thread-safe, a ring is used by a single thread.
+	/// </summary>
+	class Io_uring
+	{
+	public:
+		struct Completion
+		{
+			std::uint64_t user_data;
+			std::int32_t result;
+		};
+
+		Io_uring() = default;
+
+		Io_uring(const Io_uring&) = delete;
+		Io_uring& operator=(const Io_uring&) = delete;
+
+		~Io_uring() { release(); }
+
+		/// <summary>
+		/// Creates ring of the given number of entries.
+		/// </summary>
+		/// <returns>False if io_uring is not supported or not permitted by the system.</returns>
+		inline bool init(unsigned entries) noexcept
+		{
+			release();
+
+			io_uring_params params;
+			std::memset(&params, 0, sizeof(params));
+
+			fd_ = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+			if (fd_ < 0)
+				return false;
+
+			sq_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+			cq_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+
+			if (params.features & IORING_FEAT_SINGLE_MMAP)
+				sq_size_ = cq_size_ = sq_size_ > cq_size_ ? sq_size_ : cq_size_;
+
+			sq_ring_ = mmap(nullptr, sq_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+				fd_, IORING_OFF_SQ_RING);
+			if (sq_ring_ == MAP_FAILED)
+			{
+				sq_ring_ = nullptr;
+				release();
+				return false;
+			}
+
+			if (params.features & IORING_FEAT_SINGLE_MMAP)
+				cq_ring_ = sq_ring_;
+			else
+			{
+				cq_ring_ = mmap(nullptr, cq_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+					fd_, IORING_OFF_CQ_RING);
+				if (cq_ring_ == MAP_FAILED)
+				{
+					cq_ring_ = nullptr;
+					release();
+					return false;
+				}
+			}
+
+			sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+			auto sqes = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+				fd_, IORING_OFF_SQES);
+			if (sqes == MAP_FAILED)
+			{
+				release();
+				return false;
+			}
+			sqes_ = static_cast<io_uring_sqe*>(sqes);
+
+			auto sq = static_cast<char*>(sq_ring_);
+			sq_head_ = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+			sq_tail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+			sq_mask_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+			sq_array_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+			sq_entries_ = params.sq_entries;
+
+			auto cq = static_cast<char*>(cq_ring_);
+			cq_head_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+			cq_tail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+			cq_mask_ = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+			cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+			sqe_tail_ = *sq_tail_;
+			submitted_tail_ = sqe_tail_;
+
+			return true;
+		}
+
+		inline bool is_initialized() const noexcept { return fd_ >= 0; }
+
+		inline unsigned entries() const noexcept { return sq_entries_; }
+
+		/// <summary>
+		/// Registers buffers for fixed reads and writes.
+		/// </summary>
+		inline bool register_buffers(const iovec* buffers, unsigned count) noexcept
+		{
+			return syscall(__NR_io_uring_register, fd_, IORING_REGISTER_BUFFERS, buffers, count) == 0;
+		}
+
+		inline bool prepare_read(int fd, void* data, unsigned size, std::uint64_t offset, std::uint64_t user_data) noexcept
+		{
+			return prepare(IORING_OP_READ, fd, data, size, offset, user_data);
+		}
+
+		inline bool prepare_read_fixed(int fd, void* data, unsigned size, std::uint64_t offset,
+			unsigned buffer_index, std::uint64_t user_data) noexcept
+		{
+			if (!prepare(IORING_OP_READ_FIXED, fd, data, size, offset, user_data))
+				return false;
+			sqes_[(sqe_tail_ - 1) & sq_mask_].buf_index = static_cast<std::uint16_t>(buffer_index);
+			return true;
+		}
+
+		inline bool prepare_write(int fd, const void* data, unsigned size, std::uint64_t offset, std::uint64_t user_data) noexcept
+		{
+			return prepare(IORING_OP_WRITE, fd, const_cast<void*>(data), size, offset, user_data);
+		}
+
+		/// <summary>
+		/// Submits prepared requests and waits for the given number of completions.
+		/// </summary>
+		/// <returns>Number of submitted requests or negated error code.</returns>
+		inline int submit(unsigned wait_count = 0) noexcept
+		{
+			unsigned count = sqe_tail_ - submitted_tail_;
+			__atomic_store_n(sq_tail_, sqe_tail_, __ATOMIC_RELEASE);
+			submitted_tail_ = sqe_tail_;
+
+			int result;
+			do
+				result = static_cast<int>(syscall(__NR_io_uring_enter, fd_, count, wait_count,
+					wait_count > 0 ? IORING_ENTER_GETEVENTS : 0u, nullptr, 0));
+			while (result < 0 && errno == EINTR);
+
+			return result < 0 ? -errno : result;
+		}
+
+		/// <summary>
+		/// Takes back prepared requests the kernel did not accept on the last submit(),
+		/// so they are never submitted later.
+		/// </summary>
+		/// <returns>Number of dropped requests, the last ones prepared.</returns>
+		inline unsigned drop_unsubmitted() noexcept
+		{
+			unsigned head = __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+			unsigned count = sqe_tail_ - head;
+
+			sqe_tail_ = submitted_tail_ = head;
+			__atomic_store_n(sq_tail_, head, __ATOMIC_RELEASE);
+			return count;
+		}
+
+		/// <summary>
+		/// Takes one completion if it is ready.
+		/// </summary>
+		inline bool peek(Completion& completion) noexcept
+		{
+			unsigned head = *cq_head_;
+			if (head == __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE))
+				return false;
+
+			auto& cqe = cqes_[head & cq_mask_];
+			completion = { cqe.user_data, cqe.res };
+			__atomic_store_n(cq_head_, head + 1, __ATOMIC_RELEASE);
+			return true;
+		}
+
+		/// <summary>
+		/// Waits for one completion.
+		/// </summary>
+		/// <returns>False on a system error.</returns>
+		inline bool wait(Completion& completion) noexcept
+		{
+			while (!peek(completion))
+			{
+				int result = static_cast<int>(syscall(__NR_io_uring_enter, fd_, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0));
+				if (result < 0 && errno != EINTR)
+					return false;
+			}
+			return true;
+		}
+
+		inline void release() noexcept
+		{
+			if (sqes_ != nullptr)
+				munmap(sqes_, sqes_size_);
+			if (cq_ring_ != nullptr && cq_ring_ != sq_ring_)
+				munmap(cq_ring_, cq_size_);
+			if (sq_ring_ != nullptr)
+				munmap(sq_ring_, sq_size_);
+			if (fd_ >= 0)
+				close(fd_);
+
+			fd_ = -1;
+			sq_ring_ = cq_ring_ = nullptr;
+			sqes_ = nullptr;
+			sq_entries_ = 0;
+		}
+
+	private:
+		inline bool prepare(std::uint8_t opcode, int fd, void* data, unsigned size,
+			std::uint64_t offset, std::uint64_t user_data) noexcept
+		{
+			if (sqe_tail_ - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE) >= sq_entries_)
+				return false;
+
+			unsigned index = sqe_tail_ & sq_mask_;
+			auto& sqe = sqes_[index];
+
+			std::memset(&sqe, 0, sizeof(sqe));
+			sqe.opcode = opcode;
+			sqe.fd = fd;
+			sqe.addr = reinterpret_cast<std::uint64_t>(data);
+			sqe.len = size;
+			sqe.off = offset;
+			sqe.user_data = user_data;
+
+			sq_array_[index] = index;
+			++sqe_tail_;
+			return true;
+		}
+
+		int fd_ = -1;
+
+		void* sq_ring_ = nullptr;
+		void* cq_ring_ = nullptr;
+		std::size_t sq_size_ = 0;
+		std::size_t cq_size_ = 0;
+		std::size_t sqes_size_ = 0;
+
+		io_uring_sqe* sqes_ = nullptr;
+		unsigned* sq_head_ = nullptr;
+		unsigned* sq_tail_ = nullptr;
+		unsigned* sq_array_ = nullptr;
+		unsigned sq_mask_ = 0;
+		unsigned sq_entries_ = 0;
+		unsigned sqe_tail_ = 0;
+		unsigned submitted_tail_ = 0;
+
+		unsigned* cq_head_ = nullptr;
+		unsigned* cq_tail_ = nullptr;
+		unsigned cq_mask_ = 0;
+		io_uring_cqe* cqes_ = nullptr;
+	};
+}
+
+#endif
+
+#endif
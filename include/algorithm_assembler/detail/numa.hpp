@@ -0,0 +1,253 @@
+/*
+Copyright 2019 Ilia S. Kovalev
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef NUMA_HPP
+#define NUMA_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+	#ifndef WIN32_LEAN_AND_MEAN
+		#define WIN32_LEAN_AND_MEAN
+	#endif
+	#ifndef NOMINMAX
+		#define NOMINMAX
+	#endif
+	#include <windows.h>
+#else
+	#include <cerrno>
+	#include <fstream>
+	#include <sched.h>
+	#include <sys/mman.h>
+	#include <sys/syscall.h>
+	#include <pthread.h>
+	#include <unistd.h>
+#endif
+
+namespace algorithm_assembler::detail
+{
+#ifndef _WIN32
+	/// <summary>
+	/// Parses a list like "0-3,8,10-11" of sysfs.
+	/// </summary>
+	inline std::vector<std::size_t> parse_cpu_list(const std::string& list)
+	{
+		std::vector<std::size_t> values;
+
+		std::size_t pos = 0;
+		while (pos < list.size())
+		{
+			auto end = list.find(',', pos);
+			if (end == std::string::npos)
+				end = list.size();
+
+			auto range = list.substr(pos, end - pos);
+			auto dash = range.find('-');
+			if (!range.empty() && range.find_first_not_of("0123456789-\n") == std::string::npos)
+			{
+				std::size_t first = std::stoul(range.substr(0, dash));
+				std::size_t last = dash == std::string::npos ? first : std::stoul(range.substr(dash + 1));
+				for (auto v = first; v <= last; ++v)
+					values.push_back(v);
+			}
+
+			pos = end + 1;
+		}
+
+		return values;
+	}
+
+	inline std::string read_sysfs_line(const std::string& path)
+	{
+		std::ifstream file(path);
+		std::string line;
+		std::getline(file, line);
+		return line;
+	}
+#endif
+
+	/// <summary>
+	/// Numbers of online NUMA nodes in ascending order, only node 0 if the system does not report them.
+	/// Nodes which are possible but offline have no CPUs and memory, so they are not listed.
+	/// </summary>
+	inline std::vector<std::size_t> numa_nodes()
+	{
+		std::vector<std::size_t> nodes;
+
+#ifdef _WIN32
+		ULONG highest = 0;
+		if (GetNumaHighestNodeNumber(&highest))
+			for (ULONG node = 0; node <= highest; ++node)
+				nodes.push_back(node);
+#else
+		nodes = parse_cpu_list(read_sysfs_line("/sys/devices/system/node/online"));
+#endif
+
+		if (nodes.empty())
+			nodes.push_back(0);
+
+		return nodes;
+	}
+
+	/// <summary>
+	/// Highest online NUMA node plus one, 1 if the system does not report nodes.
+	/// Node numbers may have gaps, numa_nodes() lists the online ones.
+	/// </summary>
+	inline std::size_t numa_node_count()
+	{
+		return numa_nodes().back() + 1;
+	}
+
+	/// <summary>
+	/// CPUs of a NUMA node, all CPUs if the system does not report nodes.
+	/// </summary>
+	inline std::vector<std::size_t> numa_node_cpus(std::size_t node)
+	{
+		auto nodes = numa_nodes();
+		if (std::find(nodes.begin(), nodes.end(), node) == nodes.end())
+			throw std::invalid_argument("No NUMA node " + std::to_string(node));
+
+		std::vector<std::size_t> cpus;
+
+#ifdef _WIN32
+		GROUP_AFFINITY affinity{};
+		if (GetNumaNodeProcessorMaskEx(static_cast<USHORT>(node), &affinity))
+			for (std::size_t i = 0; i < sizeof(KAFFINITY) * 8; ++i)
+				if (affinity.Mask & (KAFFINITY{ 1 } << i))
+					cpus.push_back(static_cast<std::size_t>(affinity.Group) * sizeof(KAFFINITY) * 8 + i);
+#else
+		cpus = parse_cpu_list(read_sysfs_line("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist"));
+#endif
+
+		if (cpus.empty())
+			for (std::size_t i = 0, n = std::thread::hardware_concurrency(); i < n; ++i)
+				cpus.push_back(i);
+
+		return cpus;
+	}
+
+	/// <summary>
+	/// Restricts a thread to the given CPUs.
+	/// On Windows the CPUs must belong to one processor group.
+	/// </summary>
+	inline void pin_thread(std::thread::native_handle_type thread, const std::vector<std::size_t>& cpus)
+	{
+		if (cpus.empty())
+			return;
+
+#ifdef _WIN32
+		constexpr std::size_t group_size = sizeof(KAFFINITY) * 8;
+
+		GROUP_AFFINITY affinity{};
+		affinity.Group = static_cast<WORD>(cpus.front() / group_size);
+		for (auto cpu : cpus)
+		{
+			if (cpu / group_size != affinity.Group)
+				throw std::invalid_argument("Pinned CPUs must belong to one processor group");
+			affinity.Mask |= KAFFINITY{ 1 } << (cpu % group_size);
+		}
+
+		if (!SetThreadGroupAffinity(static_cast<HANDLE>(thread), &affinity, nullptr))
+			throw std::system_error(static_cast<int>(GetLastError()), std::system_category(), "Cannot pin thread");
+#else
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		for (auto cpu : cpus)
+		{
+			if (cpu >= CPU_SETSIZE)
+				throw std::invalid_argument("No CPU " + std::to_string(cpu));
+			CPU_SET(cpu, &set);
+		}
+
+		if (auto error = pthread_setaffinity_np(thread, sizeof(set), &set); error != 0)
+			throw std::system_error(error, std::generic_category(), "Cannot pin thread");
+#endif
+	}
+
+	/// <summary>
+	/// CPU running the calling thread.
+	/// </summary>
+	inline std::size_t current_cpu() noexcept
+	{
+#ifdef _WIN32
+		PROCESSOR_NUMBER number;
+		GetCurrentProcessorNumberEx(&number);
+		return static_cast<std::size_t>(number.Group) * sizeof(KAFFINITY) * 8 + number.Number;
+#else
+		auto cpu = sched_getcpu();
+		return cpu < 0 ? 0 : static_cast<std::size_t>(cpu);
+#endif
+	}
+
+	/// <summary>
+	/// Allocates pages preferably placed on a NUMA node. If the system does not support
+	/// placement, pages are placed on the node of the thread touching them first.
+	/// </summary>
+	inline void* allocate_on_node(std::size_t size, std::size_t node)
+	{
+		if (size == 0)
+			size = 1;
+
+#ifdef _WIN32
+		auto p = VirtualAllocExNuma(GetCurrentProcess(), nullptr, size, MEM_RESERVE | MEM_COMMIT,
+			PAGE_READWRITE, static_cast<DWORD>(node));
+		if (p == nullptr)
+			throw std::bad_alloc();
+		return p;
+#else
+		auto p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (p == MAP_FAILED)
+			throw std::bad_alloc();
+
+#ifdef SYS_mbind
+		constexpr int preferred_policy = 1;		// MPOL_PREFERRED of linux/mempolicy.h
+
+		constexpr std::size_t word_bits = sizeof(unsigned long) * 8;
+		unsigned long mask[16] = {};
+		if (node < sizeof(mask) * 8)
+		{
+			mask[node / word_bits] = 1ul << (node % word_bits);
+			// Failure leaves the default first touch placement.
+			syscall(SYS_mbind, p, size, preferred_policy, mask, sizeof(mask) * 8, 0);
+		}
+#endif
+
+		return p;
+#endif
+	}
+
+	inline void deallocate_on_node(void* p, std::size_t size) noexcept
+	{
+		if (p == nullptr)
+			return;
+
+#ifdef _WIN32
+		(void)size;
+		VirtualFree(p, 0, MEM_RELEASE);
+#else
+		munmap(p, size == 0 ? 1 : size);
+#endif
+	}
+}
+
+#endif
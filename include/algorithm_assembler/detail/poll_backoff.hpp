@@ -0,0 +1,50 @@
+/*
+Copyright 2019 Ilia S. Kovalev
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef POLL_BACKOFF_HPP
+#define POLL_BACKOFF_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <thread>
+
+namespace algorithm_assembler::detail
+{
+	/// <summary>
+	/// Waiting for another thread or process: yields first, then sleeps for the poll interval.
+	/// </summary>
+	class Poll_backoff
+	{
+		static constexpr std::size_t yields = 64;
+
+	public:
+		explicit Poll_backoff(std::chrono::microseconds interval) noexcept : interval_(interval) {}
+
+		inline void wait()
+		{
+			if (count_++ < yields)
+				std::this_thread::yield();
+			else
+				std::this_thread::sleep_for(interval_);
+		}
+
+	private:
+		std::chrono::microseconds interval_;
+		std::size_t count_ = 0;
+	};
+}
+
+#endif
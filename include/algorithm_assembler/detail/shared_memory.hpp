@@ -0,0 +1,454 @@
+/*
+Copyright 2019 Ilia S. Kovalev
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef SHARED_MEMORY_HPP
+#define SHARED_MEMORY_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+
+#include "../utils/misc.hpp"
+#include "poll_backoff.hpp"
+
+#ifdef _WIN32
+	#ifndef WIN32_LEAN_AND_MEAN
+		#define WIN32_LEAN_AND_MEAN
+	#endif
+	#ifndef NOMINMAX
+		#define NOMINMAX
+	#endif
+	#include <windows.h>
+#else
+	#include <cerrno>
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+namespace algorithm_assembler::detail
+{
+	/// <summary>
+	/// Memory mapped by several processes: a named shm_open or file mapping object,
+	/// or an anonymous memfd shared by inheriting its descriptor.
+	/// </summary>
+	class Shared_memory
+	{
+	public:
+		Shared_memory() = default;
+
+		Shared_memory(const Shared_memory&) = delete;
+		Shared_memory& operator=(const Shared_memory&) = delete;
+
+		~Shared_memory() { close(); }
+
+		/// <summary>
+		/// Creates memory of the given size, an existing object with the same name is replaced.
+		/// An empty name creates a memfd where it is supported.
+		/// </summary>
+		inline void create(const std::string& name, std::size_t size)
+		{
+			close();
+
+#ifdef _WIN32
+			if (name.empty())
+				throw std::invalid_argument("Shared memory must be named");
+
+			auto size64 = static_cast<std::uint64_t>(size);
+			mapping_ = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+				static_cast<DWORD>(size64 >> 32), static_cast<DWORD>(size64 & 0xFFFFFFFF), name.c_str());
+			if (mapping_ == nullptr)
+				throw_last_error("Cannot create shared memory " + name);
+#else
+			if (name.empty())
+			{
+#ifdef MFD_CLOEXEC
+				// The descriptor is inherited by child processes.
+				fd_ = memfd_create("algorithm_assembler", 0);
+				if (fd_ < 0)
+					throw_last_error("Cannot create memfd");
+#else
+				throw std::invalid_argument("Shared memory must be named");
+#endif
+			}
+			else
+			{
+				name_ = object_name(name);
+				shm_unlink(name_.c_str());
+				fd_ = shm_open(name_.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+				if (fd_ < 0)
+					throw_last_error("Cannot create shared memory " + name);
+			}
+
+			if (ftruncate(fd_, static_cast<off_t>(size)) != 0)
+				throw_last_error("Cannot resize shared memory");
+#endif
+			map(size);
+		}
+
+		/// <summary>
+		/// Maps memory created by another process.
+		/// </summary>
+		inline void open(const std::string& name)
+		{
+			close();
+
+			if (name.empty())
+				throw std::invalid_argument("Shared memory must be named");
+
+#ifdef _WIN32
+			mapping_ = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, name.c_str());
+			if (mapping_ == nullptr)
+				throw_last_error("Cannot open shared memory " + name);
+			map(0);
+#else
+			fd_ = shm_open(object_name(name).c_str(), O_RDWR, 0600);
+			if (fd_ < 0)
+				throw_last_error("Cannot open shared memory " + name);
+			map_descriptor();
+#endif
+		}
+
+#ifndef _WIN32
+		/// <summary>
+		/// Maps memory of an inherited or received descriptor, the descriptor is duplicated.
+		/// </summary>
+		inline void open(int fd)
+		{
+			close();
+
+			fd_ = dup(fd);
+			if (fd_ < 0)
+				throw_last_error("Cannot duplicate shared memory descriptor");
+			map_descriptor();
+		}
+
+		/// <summary>
+		/// Descriptor to pass to another process.
+		/// </summary>
+		inline int descriptor() const noexcept { return fd_; }
+#endif
+
+		/// <summary>
+		/// Unmaps memory, the creator also removes its name.
+		/// </summary>
+		inline void close() noexcept
+		{
+#ifdef _WIN32
+			if (data_ != nullptr)
+				UnmapViewOfFile(data_);
+			if (mapping_ != nullptr)
+				CloseHandle(mapping_);
+			mapping_ = nullptr;
+#else
+			if (data_ != nullptr)
+				munmap(data_, size_);
+			if (fd_ >= 0)
+				::close(fd_);
+			if (!name_.empty())
+				shm_unlink(name_.c_str());
+			fd_ = -1;
+			name_.clear();
+#endif
+			data_ = nullptr;
+			size_ = 0;
+		}
+
+		inline std::byte* data() const noexcept { return static_cast<std::byte*>(data_); }
+
+		inline std::size_t size() const noexcept { return size_; }
+
+	private:
+#ifndef _WIN32
+		static inline std::string object_name(const std::string& name)
+		{
+			return name.front() == '/' ? name : '/' + name;
+		}
+
+		inline void map_descriptor()
+		{
+			struct stat st;
+			if (fstat(fd_, &st) != 0)
+				throw_last_error("Cannot get size of shared memory");
+			map(static_cast<std::size_t>(st.st_size));
+		}
+#endif
+
+		/// <summary>
+		/// Maps the whole memory, size 0 is the size of the mapping object on Windows.
+		/// </summary>
+		inline void map(std::size_t size)
+		{
+#ifdef _WIN32
+			data_ = MapViewOfFile(mapping_, FILE_MAP_ALL_ACCESS, 0, 0, size);
+			if (data_ == nullptr)
+				throw_last_error("Cannot map shared memory");
+
+			MEMORY_BASIC_INFORMATION info;
+			size_ = VirtualQuery(data_, &info, sizeof(info)) != 0 ? info.RegionSize : size;
+#else
+			data_ = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+			if (data_ == MAP_FAILED)
+			{
+				data_ = nullptr;
+				throw_last_error("Cannot map shared memory");
+			}
+			size_ = size;
+#endif
+		}
+
+		[[noreturn]] static void throw_last_error(const std::string& what)
+		{
+#ifdef _WIN32
+			throw std::system_error(static_cast<int>(GetLastError()), std::system_category(), what);
+#else
+			throw std::system_error(errno, std::generic_category(), what);
+#endif
+		}
+
+#ifdef _WIN32
+		HANDLE mapping_ = nullptr;
+#else
+		int fd_ = -1;
+		std::string name_;
+#endif
+		void* data_ = nullptr;
+		std::size_t size_ = 0;
+	};
+
+
+	/// <summary>
+	/// Control block at the beginning of a shared ring. Positions grow monotonically,
+	/// only the producer writes head and only the consumer writes tail.
+	/// </summary>
+	struct Shared_ring_header
+	{
+		static constexpr std::uint64_t valid_magic = 0x4141'5348'5249'4E47;	// "AASHRING"
+
+		std::atomic<std::uint64_t> magic;
+		std::uint64_t capacity;
+
+		alignas(utils::cache_line_size) std::atomic<std::uint64_t> head;
+		alignas(utils::cache_line_size) std::atomic<std::uint64_t> tail;
+		alignas(utils::cache_line_size) std::atomic<std::uint32_t> is_closed;
+	};
+
+	static_assert(std::atomic<std::uint64_t>::is_always_lock_free && std::atomic<std::uint32_t>::is_always_lock_free,
+		"Shared ring requires address-free atomics");
+
+	/// <summary>
+	/// Single producer single consumer ring of variable-size records in shared memory.
+	/// A record is a size word followed by the payload, records are aligned,
+	/// so trivially copyable payloads are read in place. A record does not wrap around:
+	/// if it does not fit before the end, the rest is skipped by a marker.
+	/// </summary>
+	class Shared_ring
+	{
+		static constexpr std::uint64_t wrap_marker = ~std::uint64_t{ 0 };
+
+	public:
+		/// <summary>
+		/// Alignment of records and payloads.
+		/// </summary>
+		static constexpr std::size_t alignment = 16;
+
+		/// <summary>
+		/// Creates the ring, the producer side does it.
+		/// </summary>
+		inline void create(const std::string& name, std::size_t capacity)
+		{
+			capacity = align(capacity > 0 ? capacity : 1);
+			memory_.create(name, data_offset + capacity);
+
+			header_ = new (memory_.data()) Shared_ring_header{};
+			header_->capacity = capacity;
+			header_->head.store(0, std::memory_order_relaxed);
+			header_->tail.store(0, std::memory_order_relaxed);
+			header_->is_closed.store(0, std::memory_order_relaxed);
+			header_->magic.store(Shared_ring_header::valid_magic, std::memory_order_release);
+
+			attach();
+		}
+
+		/// <summary>
+		/// Opens the ring created by the producer.
+		/// </summary>
+		inline void open(const std::string& name)
+		{
+			memory_.open(name);
+			attach();
+		}
+
+#ifndef _WIN32
+		inline void open(int fd)
+		{
+			memory_.open(fd);
+			attach();
+		}
+
+		inline int descriptor() const noexcept { return memory_.descriptor(); }
+#endif
+
+		inline bool is_open() const noexcept { return header_ != nullptr; }
+
+		/// <summary>
+		/// Finds space for a payload, it is published by commit().
+		/// </summary>
+		/// <returns>Pointer to the payload or nullptr if the ring is full.</returns>
+		inline std::byte* try_reserve(std::size_t size)
+		{
+			auto length = record_length(size);
+			if (length > capacity_)
+				throw std::length_error("Record does not fit shared ring");
+
+			auto tail = header_->tail.load(std::memory_order_acquire);
+			auto offset = head_ % capacity_;
+
+			if (offset + length > capacity_)
+			{
+				auto rest = capacity_ - offset;
+				if (head_ + rest + length - tail > capacity_)
+					return nullptr;
+
+				write_size(offset, wrap_marker);
+				head_ += rest;
+				header_->head.store(head_, std::memory_order_release);
+				offset = 0;
+			}
+			else if (head_ + length - tail > capacity_)
+				return nullptr;
+
+			write_size(offset, size);
+			reserved_ = length;
+			return data_ + offset + alignment;
+		}
+
+		inline void commit() noexcept
+		{
+			head_ += reserved_;
+			reserved_ = 0;
+			header_->head.store(head_, std::memory_order_release);
+		}
+
+		/// <summary>
+		/// Oldest record, it stays in the ring until pop().
+		/// </summary>
+		/// <returns>Pointer to the payload or nullptr if the ring is empty.</returns>
+		inline const std::byte* front(std::size_t& size)
+		{
+			for (;;)
+			{
+				if (tail_ == header_->head.load(std::memory_order_acquire))
+					return nullptr;
+
+				auto offset = tail_ % capacity_;
+				auto s = read_size(offset);
+				if (s != wrap_marker)
+				{
+					size = static_cast<std::size_t>(s);
+					return data_ + offset + alignment;
+				}
+
+				tail_ += capacity_ - offset;
+				header_->tail.store(tail_, std::memory_order_release);
+			}
+		}
+
+		inline void pop(std::size_t size) noexcept
+		{
+			tail_ += record_length(size);
+			header_->tail.store(tail_, std::memory_order_release);
+		}
+
+		/// <summary>
+		/// Ends the stream, records already in the ring may still be read.
+		/// </summary>
+		inline void close() noexcept
+		{
+			if (header_ != nullptr)
+				header_->is_closed.store(1, std::memory_order_release);
+		}
+
+		inline bool is_closed() const noexcept
+		{
+			return header_->is_closed.load(std::memory_order_acquire) != 0;
+		}
+
+		inline std::size_t capacity() const noexcept { return capacity_; }
+
+	private:
+		static constexpr std::size_t align(std::size_t size) noexcept
+		{
+			return (size + alignment - 1) / alignment * alignment;
+		}
+
+		static constexpr std::size_t data_offset = (sizeof(Shared_ring_header) + alignment - 1) / alignment * alignment;
+
+		static constexpr std::size_t record_length(std::size_t size) noexcept
+		{
+			return alignment + align(size);
+		}
+
+		inline void attach()
+		{
+			header_ = std::launder(reinterpret_cast<Shared_ring_header*>(memory_.data()));
+			if (memory_.size() < data_offset
+				|| header_->magic.load(std::memory_order_acquire) != Shared_ring_header::valid_magic
+				|| memory_.size() < data_offset + header_->capacity)
+			{
+				header_ = nullptr;
+				memory_.close();
+				throw std::runtime_error("Shared memory does not contain a ring");
+			}
+
+			capacity_ = static_cast<std::size_t>(header_->capacity);
+			data_ = memory_.data() + data_offset;
+			head_ = header_->head.load(std::memory_order_acquire);
+			tail_ = header_->tail.load(std::memory_order_acquire);
+		}
+
+		inline void write_size(std::size_t offset, std::uint64_t size) noexcept
+		{
+			std::memcpy(data_ + offset, &size, sizeof(size));
+		}
+
+		inline std::uint64_t read_size(std::size_t offset) const noexcept
+		{
+			std::uint64_t size;
+			std::memcpy(&size, data_ + offset, sizeof(size));
+			return size;
+		}
+
+		Shared_memory memory_;
+		Shared_ring_header* header_ = nullptr;
+		std::byte* data_ = nullptr;
+		std::size_t capacity_ = 0;
+
+		std::uint64_t head_ = 0;
+		std::uint64_t tail_ = 0;
+		std::size_t reserved_ = 0;
+	};
+}
+
+#endif
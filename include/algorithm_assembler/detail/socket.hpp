@@ -0,0 +1,399 @@
+/*
+Copyright 2019 Ilia S. Kovalev
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef SOCKET_HPP
+#define SOCKET_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <utility>
+
+#include "../enums.hpp"
+
+#ifdef _WIN32
+	#ifndef WIN32_LEAN_AND_MEAN
+		#define WIN32_LEAN_AND_MEAN
+	#endif
+	#ifndef NOMINMAX
+		#define NOMINMAX
+	#endif
+	#include <winsock2.h>
+	#include <ws2tcpip.h>
+	#include <afunix.h>
+	#pragma comment(lib, "Ws2_32.lib")
+#else
+	#include <cerrno>
+	#include <netdb.h>
+	#include <netinet/in.h>
+	#include <netinet/tcp.h>
+	#include <sys/socket.h>
+	#include <sys/uio.h>
+	#include <sys/un.h>
+	#include <unistd.h>
+#endif
+
+namespace algorithm_assembler::detail
+{
+	/// <summary>
+	/// Piece of data for a vectored write.
+	/// </summary>
+	struct Io_slice
+	{
+		const std::byte* data;
+		std::size_t size;
+	};
+
+	/// <summary>
+	/// Blocking stream socket, TCP or Unix domain.
+	/// </summary>
+	class Socket
+	{
+#ifdef _WIN32
+		using Handle = SOCKET;
+		static constexpr Handle invalid_handle = INVALID_SOCKET;
+#else
+		using Handle = int;
+		static constexpr Handle invalid_handle = -1;
+#endif
+
+		/// <summary>
+		/// Slices passed to one system call.
+		/// </summary>
+		static constexpr std::size_t max_slices = 16;
+
+	public:
+		Socket() = default;
+
+		Socket(Socket&& other) noexcept : handle_(std::exchange(other.handle_, invalid_handle)) {}
+
+		Socket& operator=(Socket&& other) noexcept
+		{
+			if (this != &other)
+			{
+				close();
+				handle_ = std::exchange(other.handle_, invalid_handle);
+			}
+			return *this;
+		}
+
+		~Socket() { close(); }
+
+		/// <summary>
+		/// Creates a listening socket. An empty TCP address listens on all interfaces,
+		/// port 0 takes a free one. An existing Unix socket file is replaced.
+		/// </summary>
+		static inline Socket listen(Transport_protocol protocol, const std::string& address, std::uint16_t port)
+		{
+			startup();
+
+			Socket s;
+			if (protocol == Transport_protocol::unix_socket)
+			{
+				auto a = unix_address(address);
+				remove_path(address);
+				s.open(AF_UNIX);
+				if (::bind(s.handle_, reinterpret_cast<const sockaddr*>(&a), sizeof(a)) != 0)
+					throw_last_error("Cannot bind " + address);
+			}
+			else
+			{
+				auto info = resolve(address, port, true);
+				s.open(info->ai_family);
+
+				int yes = 1;
+				setsockopt(s.handle_, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&yes), sizeof(yes));
+
+				auto error = ::bind(s.handle_, info->ai_addr, static_cast<int>(info->ai_addrlen));
+				freeaddrinfo(info);
+				if (error != 0)
+					throw_last_error("Cannot bind port " + std::to_string(port));
+			}
+
+			if (::listen(s.handle_, SOMAXCONN) != 0)
+				throw_last_error("Cannot listen");
+
+			return s;
+		}
+
+		/// <summary>
+		/// Connects to a listening socket.
+		/// </summary>
+		static inline Socket connect(Transport_protocol protocol, const std::string& address, std::uint16_t port)
+		{
+			startup();
+
+			Socket s;
+			if (protocol == Transport_protocol::unix_socket)
+			{
+				auto a = unix_address(address);
+				s.open(AF_UNIX);
+				if (::connect(s.handle_, reinterpret_cast<const sockaddr*>(&a), sizeof(a)) != 0)
+					throw_last_error("Cannot connect to " + address);
+			}
+			else
+			{
+				auto info = resolve(address.empty() ? "localhost" : address, port, false);
+
+				// A host may resolve to several addresses, e.g. of IPv6 and IPv4.
+				for (auto i = info; i != nullptr && !s.is_open(); i = i->ai_next)
+				{
+					s.open(i->ai_family);
+					if (::connect(s.handle_, i->ai_addr, static_cast<int>(i->ai_addrlen)) != 0)
+						s.close();
+				}
+				freeaddrinfo(info);
+
+				if (!s.is_open())
+					throw_last_error("Cannot connect to " + address + ":" + std::to_string(port));
+
+				// Writes are batched by the caller.
+				int yes = 1;
+				setsockopt(s.handle_, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&yes), sizeof(yes));
+			}
+
+			return s;
+		}
+
+		/// <summary>
+		/// Waits for a connection to the listening socket.
+		/// </summary>
+		inline Socket accept() const
+		{
+			Socket s;
+			s.handle_ = ::accept(handle_, nullptr, nullptr);
+			if (s.handle_ == invalid_handle)
+				throw_last_error("Cannot accept connection");
+			return s;
+		}
+
+		/// <summary>
+		/// Port of a TCP socket.
+		/// </summary>
+		inline std::uint16_t local_port() const
+		{
+			sockaddr_storage a{};
+			socklen_t length = sizeof(a);
+			if (getsockname(handle_, reinterpret_cast<sockaddr*>(&a), &length) != 0)
+				throw_last_error("Cannot get socket address");
+
+			if (a.ss_family == AF_INET)
+				return ntohs(reinterpret_cast<const sockaddr_in&>(a).sin_port);
+			if (a.ss_family == AF_INET6)
+				return ntohs(reinterpret_cast<const sockaddr_in6&>(a).sin6_port);
+			return 0;
+		}
+
+		/// <summary>
+		/// Writes all slices by vectored writes.
+		/// </summary>
+		inline void send(Io_slice* slices, std::size_t count)
+		{
+			while (count > 0)
+			{
+				auto n = std::min(count, max_slices);
+				auto sent = send_some(slices, n);
+
+				// Skip written slices and the written part of the next one.
+				while (count > 0 && sent >= slices->size)
+				{
+					sent -= slices->size;
+					++slices;
+					--count;
+				}
+				if (count > 0)
+				{
+					slices->data += sent;
+					slices->size -= sent;
+				}
+			}
+		}
+
+		/// <summary>
+		/// Reads exactly size bytes.
+		/// </summary>
+		/// <returns>false if the peer closed or reset the connection before.</returns>
+		inline bool receive(std::byte* data, std::size_t size)
+		{
+			while (size > 0)
+			{
+				auto chunk = static_cast<int>(std::min<std::size_t>(size, 1 << 30));
+#ifdef _WIN32
+				auto n = ::recv(handle_, reinterpret_cast<char*>(data), chunk, 0);
+#else
+				auto n = ::recv(handle_, data, static_cast<std::size_t>(chunk), 0);
+				if (n < 0 && errno == EINTR)
+					continue;
+#endif
+				if (n <= 0)
+					return false;
+
+				data += n;
+				size -= static_cast<std::size_t>(n);
+			}
+			return true;
+		}
+
+		/// <summary>
+		/// Ends writing, the peer reads the rest and then the end of the stream.
+		/// </summary>
+		inline void shutdown() noexcept
+		{
+			if (handle_ == invalid_handle)
+				return;
+#ifdef _WIN32
+			::shutdown(handle_, SD_SEND);
+#else
+			::shutdown(handle_, SHUT_WR);
+#endif
+		}
+
+		inline void close() noexcept
+		{
+			if (handle_ == invalid_handle)
+				return;
+#ifdef _WIN32
+			closesocket(handle_);
+#else
+			::close(handle_);
+#endif
+			handle_ = invalid_handle;
+		}
+
+		inline bool is_open() const noexcept { return handle_ != invalid_handle; }
+
+		/// <summary>
+		/// Removes the file of a Unix socket.
+		/// </summary>
+		static inline void remove_path(const std::string& path) noexcept
+		{
+#ifdef _WIN32
+			DeleteFileA(path.c_str());
+#else
+			::unlink(path.c_str());
+#endif
+		}
+
+	private:
+		static inline void startup()
+		{
+#ifdef _WIN32
+			struct Winsock
+			{
+				Winsock()
+				{
+					WSADATA data;
+					if (auto error = WSAStartup(MAKEWORD(2, 2), &data); error != 0)
+						throw std::system_error(error, std::system_category(), "Cannot start Winsock");
+				}
+				~Winsock() { WSACleanup(); }
+			};
+			static Winsock winsock;
+#endif
+		}
+
+		inline void open(int family)
+		{
+			handle_ = ::socket(family, SOCK_STREAM, 0);
+			if (handle_ == invalid_handle)
+				throw_last_error("Cannot create socket");
+		}
+
+		static inline sockaddr_un unix_address(const std::string& path)
+		{
+			sockaddr_un a{};
+			if (path.empty() || path.size() >= sizeof(a.sun_path))
+				throw std::invalid_argument("Bad Unix socket path " + path);
+
+			a.sun_family = AF_UNIX;
+			std::memcpy(a.sun_path, path.c_str(), path.size());
+			return a;
+		}
+
+		static inline addrinfo* resolve(const std::string& address, std::uint16_t port, bool passive)
+		{
+			addrinfo hints{};
+			hints.ai_family = AF_UNSPEC;
+			hints.ai_socktype = SOCK_STREAM;
+			hints.ai_flags = passive ? AI_PASSIVE : 0;
+
+			addrinfo* info = nullptr;
+			auto service = std::to_string(port);
+			if (auto error = getaddrinfo(address.empty() ? nullptr : address.c_str(), service.c_str(), &hints, &info); error != 0)
+				throw std::invalid_argument("Cannot resolve " + address + ": " + gai_strerror(error));
+			return info;
+		}
+
+		inline std::size_t send_some(const Io_slice* slices, std::size_t count)
+		{
+#ifdef _WIN32
+			WSABUF buffers[max_slices];
+			for (std::size_t i = 0; i < count; ++i)
+			{
+				buffers[i].buf = const_cast<char*>(reinterpret_cast<const char*>(slices[i].data));
+				buffers[i].len = static_cast<ULONG>(slices[i].size);
+			}
+
+			DWORD sent = 0;
+			if (WSASend(handle_, buffers, static_cast<DWORD>(count), &sent, 0, nullptr, nullptr) != 0)
+				throw_last_error("Cannot send");
+			return sent;
+#else
+			iovec vectors[max_slices];
+			for (std::size_t i = 0; i < count; ++i)
+			{
+				vectors[i].iov_base = const_cast<std::byte*>(slices[i].data);
+				vectors[i].iov_len = slices[i].size;
+			}
+
+			msghdr message{};
+			message.msg_iov = vectors;
+			message.msg_iovlen = count;
+
+#ifdef MSG_NOSIGNAL
+			constexpr int flags = MSG_NOSIGNAL;		// A closed peer is reported by the error, not by SIGPIPE.
+#else
+			constexpr int flags = 0;
+#endif
+			for (;;)
+			{
+				auto sent = ::sendmsg(handle_, &message, flags);
+				if (sent >= 0)
+					return static_cast<std::size_t>(sent);
+				if (errno != EINTR)
+					throw_last_error("Cannot send");
+			}
+#endif
+		}
+
+		[[noreturn]] static void throw_last_error(const std::string& what)
+		{
+#ifdef _WIN32
+			throw std::system_error(WSAGetLastError(), std::system_category(), what);
+#else
+			throw std::system_error(errno, std::generic_category(), what);
+#endif
+		}
+
+		Handle handle_ = invalid_handle;
+	};
+}
+
+#endif
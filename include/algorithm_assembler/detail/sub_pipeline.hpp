@@ -0,0 +1,254 @@
+/*
+Copyright 2019 Ilia S. Kovalev
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef SUB_PIPELINE_HPP
+#define SUB_PIPELINE_HPP
+
+#include <cstddef>
+#include <optional>
+#include <tuple>
+#include <utility>
+
+#include "data_processor_detail.hpp"
+
+namespace algorithm_assembler::detail
+{
+	/// <summary>
+	/// Position of the last module generating T, size of the list if there is none.
+	/// </summary>
+	template<typename T, class... Modules>
+	constexpr std::size_t last_generator_index() noexcept
+	{
+		std::size_t index = sizeof...(Modules);
+		std::size_t i = 0;
+		((std::is_base_of_v<Generates_type<T>, Modules> ? index = i++ : i++), ...);
+		return index;
+	}
+
+	template<typename Modules_list>
+	class Sub_pipeline;
+
+	/// <summary>
+	/// Modules chain owned by a combinator module. Auxiliary data demanded
+	/// from outside are passed to process() with every item, data generated inside
+	/// are read by has_new_data() and get() after it. Modules using an arena get
+	/// one of the sub-pipeline, it is rewound on every call.
+	/// </summary>
+	template<class Module, class... Modules>
+	class Sub_pipeline<utils::Typelist<Module, Modules...>> :
+		public DP_Arena<(is_arena_user_v<Module> || ... || is_arena_user_v<Modules>)>
+	{
+	public:
+		using Input_types = typename Module::Input_types;
+		using Output_type = typename utils::Typelist<Module, Modules...>::back::Output_type;
+
+		using Demanded_types = utils::substraction_t<
+			get_demanded_types_t<Module, Modules...>,
+			get_generated_types_t<Module, Modules...>
+		>;
+
+		using Generated_types = get_generated_types_t<Module, Modules...>;
+
+		Sub_pipeline()
+		{
+			if constexpr ((is_arena_user_v<Module> || ... || is_arena_user_v<Modules>))
+				std::apply([this](auto&... modules) { (set_arena(modules), ...); }, modules_);
+		}
+
+		/// <summary>
+		/// Processes an item.
+		/// </summary>
+		/// <param name="aux">References to demanded values, as returned by Combinator_aux::demanded_aux().
+		/// Only values transformed inside are copied, the others are set to modules directly.</param>
+		template<typename Aux, typename... Ins>
+		inline Output_type process(const Aux& aux, Ins&&... ins)
+		{
+			this->reset_arena();
+
+			set_demanded(aux, utils::substraction_t<Demanded_types, Transformed_demanded_types>{});
+
+			return process_modules(
+				std::forward_as_tuple(std::forward<Ins>(ins)...),
+				copy_demanded(aux, Transformed_demanded_types{}),
+				std::index_sequence_for<Module, Modules...>{});
+		}
+
+		/// <summary>
+		/// Indicates if the last call changed generated value of type T.
+		/// </summary>
+		template<typename T>
+		inline bool has_new_data() const
+		{
+			constexpr auto I = last_generator_index<T, Module, Modules...>();
+			if constexpr (I == sizeof...(Modules) + 1)
+				return false;
+			else
+			{
+				auto& m = std::get<I>(modules_);
+				if constexpr (std::is_base_of_v<Generates_type_with_policy<Updating_policy::sometimes, T>, std::decay_t<decltype(m)>>)
+					return m.template has_new_data<T>();
+				else
+					return true;
+			}
+		}
+
+		template<typename T>
+		inline T get()
+		{
+			constexpr auto I = last_generator_index<T, Module, Modules...>();
+			using M = utils::type_at_t<utils::Typelist<Module, Modules...>, I>;
+			return M::template get<T>(std::get<I>(modules_));
+		}
+
+		template<std::size_t I>
+		inline auto& module() noexcept { return std::get<I>(modules_); }
+
+		template<std::size_t I>
+		inline const auto& module() const noexcept { return std::get<I>(modules_); }
+
+	private:
+		/// <summary>
+		/// Demanded values transformed inside, they are passed along the chain as copies.
+		/// </summary>
+		using Transformed_demanded_types = utils::intersection_t<
+			Demanded_types,
+			get_transformed_types_t<Module, Modules...>
+		>;
+
+		template<typename Input, typename Aux, std::size_t... Is>
+		inline Output_type process_modules(Input&& in, Aux&& aux, std::index_sequence<Is...>)
+		{
+			return process_data(std::forward<Input>(in), std::forward<Aux>(aux), std::get<Is>(modules_)...);
+		}
+
+		template<typename Aux, typename... Ts>
+		inline void set_demanded(const Aux& aux, utils::Typelist<Ts...>&&)
+		{
+			(set_demanded(std::get<const std::optional<Ts>&>(aux)), ...);
+		}
+
+		template<typename T>
+		inline void set_demanded(const std::optional<T>& value)
+		{
+			std::apply([&value](auto&... modules) { (set_type_to_demandant(modules, value), ...); }, modules_);
+		}
+
+		template<typename Aux, typename... Ts>
+		static inline std::tuple<std::optional<Ts>...> copy_demanded(const Aux& aux, utils::Typelist<Ts...>&&)
+		{
+			return std::tuple<std::optional<Ts>...>(std::get<const std::optional<Ts>&>(aux)...);
+		}
+
+		template<class F>
+		inline void set_arena(F& f)
+		{
+			if constexpr (is_arena_user_v<F>)
+				f.set_arena(this->arena_);
+		}
+
+		std::tuple<Module, Modules...> modules_;
+	};
+
+	/// <summary>
+	/// Sub-pipeline given as a module or as a Data_processor.
+	/// </summary>
+	template<class Pipeline>
+	using sub_pipeline_t = Sub_pipeline<flatten_modules_t<Pipeline>>;
+
+
+	/// <summary>
+	/// Value of demanded type kept by a combinator until the next set().
+	/// </summary>
+	template<typename T>
+	class Demanded_value : public Demands_type<T>
+	{
+	public:
+		void set(const T& value) override { value_ = value; }
+
+		inline const std::optional<T>& value() const noexcept { return value_; }
+
+	private:
+		std::optional<T> value_;
+	};
+
+	class No_generated_types {};
+
+	template<typename... Ts>
+	struct generates_sometimes
+	{
+		using type = Generates<Types_with_policy<Updating_policy::sometimes, Ts...>>;
+	};
+
+	template<>
+	struct generates_sometimes<>
+	{
+		using type = No_generated_types;
+	};
+
+	template<typename Demanded_types, typename Generated_types>
+	class Combinator_aux;
+
+	/// <summary>
+	/// Auxiliary data interfaces of a combinator module. Demanded values are kept
+	/// and passed to sub-pipelines with every item. Generated values are exported
+	/// with Updating_policy::sometimes, since a sub-pipeline does not run for every item.
+	/// </summary>
+	template<typename... Ds, typename... Gs>
+	class Combinator_aux<utils::Typelist<Ds...>, utils::Typelist<Gs...>> :
+		public Demanded_value<Ds>...,
+		public generates_sometimes<Gs...>::type
+	{
+	public:
+		using Demanded_value<Ds>::set...;
+
+		using Demands_types = utils::Typelist<Ds...>;
+
+	protected:
+		/// <summary>
+		/// References to kept demanded values, unset ones are empty.
+		/// </summary>
+		inline std::tuple<const std::optional<Ds>&...> demanded_aux() const noexcept
+		{
+			return { static_cast<const Demanded_value<Ds>&>(*this).value()... };
+		}
+	};
+
+	template<typename... Pipelines>
+	using combinator_aux_t = Combinator_aux<
+		utils::unique_t<utils::concatenation_t<utils::Typelist<>, typename Pipelines::Demanded_types...>>,
+		utils::unique_t<utils::concatenation_t<utils::Typelist<>, typename Pipelines::Generated_types...>>
+	>;
+
+
+	template<class Derived, typename Output, typename Input_types>
+	class Combinator_functor;
+
+	/// <summary>
+	/// Functor interface of a combinator module, calls Derived::process() without virtual dispatch.
+	/// </summary>
+	template<class Derived, typename Output, typename Input, typename... Inputs>
+	class Combinator_functor<Derived, Output, utils::Typelist<Input, Inputs...>> :
+		public Functor<Output, Input, Inputs...>
+	{
+	public:
+		inline Output operator()(Input in, Inputs... ins) override
+		{
+			return static_cast<Derived&>(*this).process(std::forward<Input>(in), std::forward<Inputs>(ins)...);
+		}
+	};
+}
+
+#endif
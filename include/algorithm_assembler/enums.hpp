@@ -28,6 +28,35 @@ namespace algorithm_assembler {
 		sometimes,	/// Auxiliary data is updated when a module indicates about changes.
 		always		/// Auxiliary data updates on every iteration.
 	};
+
+	/// <summary>
+	/// Defines layout of modules in a Data_processor.
+	/// </summary>
+	enum class Storage_policy
+	{
+		compact,		/// Modules are packed together.
+		cache_aligned	/// Every module starts a cache line and no other module shares its lines.
+	};
+
+	/// <summary>
+	/// Defines behaviour of a full channel between pipeline stages.
+	/// </summary>
+	enum class Backpressure_policy
+	{
+		block,			/// Producer waits for free space.
+		drop_oldest,	/// The oldest queued item is dropped for the new one.
+		drop_newest,	/// The new item is dropped.
+		sample			/// Every n-th new item replaces the oldest queued one, the others are dropped.
+	};
+
+	/// <summary>
+	/// Defines sockets connecting pipeline stages.
+	/// </summary>
+	enum class Transport_protocol
+	{
+		tcp,			/// TCP over IPv4 or IPv6.
+		unix_socket		/// Unix domain stream socket of the local host.
+	};
 }
 
 #endif
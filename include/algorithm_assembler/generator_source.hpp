@@ -0,0 +1,133 @@
+/*
+Copyright 2019 Ilia S. Kovalev
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef GENERATOR_SOURCE_HPP
+#define GENERATOR_SOURCE_HPP
+
+#include "interfaces.hpp"
+#include "utils/batch_generator.hpp"
+
+#ifdef ALGORITHM_ASSEMBLER_HAS_COROUTINES
+
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+namespace algorithm_assembler
+{
+	/// <summary>
+	/// Data source written as a coroutine: a derived module implements generate()
+	/// and co_yields its items, iteration state lives in the coroutine.
+	/// Items are prefetched, so is_active() is exact without a separate end check in generate().
+	/// process_batch() lets the coroutine write directly into the output column,
+	/// one resumption per batch.
+	/// </summary>
+	template<typename Output>
+	class Generator_source : public Batch_functor<Output>
+	{
+	public:
+		/// <summary>
+		/// Creates the coroutine. Called on the first pull, so settings may be applied before it.
+		/// The first pull may be is_active(), so generate() is const: iteration state
+		/// belongs to the coroutine, other state changed by it has to be mutable.
+		/// </summary>
+		virtual utils::Batch_generator<Output> generate() const = 0;
+
+		inline Output operator()() override
+		{
+			start();
+
+			if (position_ >= count_)
+				throw std::runtime_error("Generator_source is exhausted");
+
+			Output out = std::move(prefetched_[position_++]);
+			if (position_ == count_)
+				prefetch();
+
+			return out;
+		}
+
+		inline std::size_t process_batch(utils::Span<Output> outs) override
+		{
+			start();
+
+			std::size_t n = 0;
+			for (; n < outs.size() && position_ < count_; ++n)
+				outs[n] = std::move(prefetched_[position_++]);
+
+			if (n < outs.size())
+				n += generator_.fill(outs.subspan(n));
+
+			if (position_ == count_)
+				prefetch();
+
+			return n;
+		}
+
+		inline bool is_active() const override
+		{
+			start();
+			return position_ < count_;
+		}
+
+		/// <summary>
+		/// Drops the current coroutine, the next pull calls generate() again.
+		/// </summary>
+		inline void restart() noexcept
+		{
+			generator_ = {};
+			is_started_ = false;
+			position_ = count_ = 0;
+		}
+
+	protected:
+		explicit Generator_source(std::size_t prefetch_size = 64) :
+			prefetched_(prefetch_size > 0 ? prefetch_size : 1)
+		{}
+
+		Generator_source(const Generator_source& other) : prefetched_(other.prefetched_.size()) {}
+		Generator_source& operator=(const Generator_source&) { restart(); return *this; }
+
+	private:
+		inline void start() const
+		{
+			if (is_started_)
+				return;
+
+			is_started_ = true;
+			generator_ = generate();
+			prefetch();
+		}
+
+		inline void prefetch() const
+		{
+			position_ = 0;
+			count_ = generator_.fill(prefetched_);
+		}
+
+		// Starting and prefetching are not observable changes, is_active() is const.
+		mutable utils::Batch_generator<Output> generator_;
+		mutable bool is_started_ = false;
+
+		mutable std::vector<Output> prefetched_;
+		mutable std::size_t position_ = 0;
+		mutable std::size_t count_ = 0;
+	};
+}
+
+#endif
+
+#endif
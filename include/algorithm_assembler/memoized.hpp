@@ -0,0 +1,193 @@
+/*
+Copyright 2019 Ilia S. Kovalev
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef MEMOIZED_HPP
+#define MEMOIZED_HPP
+
+#include <cstddef>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+
+#include "interfaces.hpp"
+#include "utils/clock_cache.hpp"
+#include "utils/misc.hpp"
+#include "utils/typelist_functions.hpp"
+
+namespace algorithm_assembler::detail
+{
+	template<class F, typename = void>
+	struct get_module_demanded_types
+	{
+		using type = utils::Typelist<>;
+	};
+
+	template<class F>
+	struct get_module_demanded_types<F, std::void_t<typename F::Demands_types>>
+	{
+		using type = typename F::Demands_types;
+	};
+
+	template<class F, typename = void>
+	struct get_module_settings_types
+	{
+		using type = utils::Typelist<>;
+	};
+
+	template<class F>
+	struct get_module_settings_types<F, std::void_t<typename F::Settings_type>>
+	{
+		using type = utils::Typelist<typename F::Settings_type>;
+	};
+
+
+	template<class F>
+	class Memoized_state : public F
+	{
+	protected:
+		bool is_invalidated_ = false;
+	};
+
+	/// <summary>
+	/// Overrides set() of one demanded or settings type, a changed value invalidates the cache.
+	/// Values without operator== invalidate it on every set().
+	/// </summary>
+	template<class F, class Base, typename T>
+	class Memoized_invalidation : public Base
+	{
+	public:
+		using Base::set;
+
+		void set(const T& value) override
+		{
+			F::set(value);
+
+			if constexpr (utils::is_equality_comparable_v<T>)
+			{
+				if (last_.has_value() && *last_ == value)
+					return;
+				last_ = value;
+			}
+
+			this->is_invalidated_ = true;
+		}
+
+	private:
+		std::conditional_t<utils::is_equality_comparable_v<T>, std::optional<T>, bool> last_{};
+	};
+
+	template<class F, class Base, typename Types>
+	struct memoized_invalidation;
+
+	template<class F, class Base>
+	struct memoized_invalidation<F, Base, utils::Typelist<>>
+	{
+		using type = Base;
+	};
+
+	template<class F, class Base, typename T, typename... Ts>
+	struct memoized_invalidation<F, Base, utils::Typelist<T, Ts...>>
+	{
+		using type = typename memoized_invalidation<F, Memoized_invalidation<F, Base, T>, utils::Typelist<Ts...>>::type;
+	};
+
+	template<class F>
+	using memoized_invalidation_t = typename memoized_invalidation<
+		F,
+		Memoized_state<F>,
+		utils::unique_t<utils::concatenation_t<
+			typename get_module_demanded_types<F>::type,
+			typename get_module_settings_types<F>::type
+		>>
+	>::type;
+
+
+	template<class F, std::size_t Capacity, class Hash, typename Input_types>
+	class Memoized_impl;
+
+	template<class F, std::size_t Capacity, class Hash, typename... Inputs>
+	class Memoized_impl<F, Capacity, Hash, utils::Typelist<Inputs...>> : public memoized_invalidation_t<F>
+	{
+	public:
+		using Output = typename F::Output_type;
+		using Key = std::tuple<std::decay_t<Inputs>...>;
+
+		static_assert(sizeof...(Inputs) > 0, "Data sources can not be memoized");
+		static_assert(std::is_object_v<Output>, "Memoized module must return a value");
+
+		Output operator()(Inputs... ins) override
+		{
+			if (this->is_invalidated_)
+			{
+				cache_.clear();
+				this->is_invalidated_ = false;
+			}
+
+			Key key(ins...);
+			auto [output, is_found] = cache_.find_or_insert(std::move(key), [&]() -> Output {
+				return F::operator()(std::forward<Inputs>(ins)...);
+			});
+
+			++(is_found ? hits_ : misses_);
+			return output;
+		}
+
+	protected:
+		utils::Clock_cache<Key, Output, Hash> cache_{ Capacity };
+		std::size_t hits_ = 0;
+		std::size_t misses_ = 0;
+	};
+}
+
+namespace algorithm_assembler
+{
+	/// <summary>
+	/// Caches outputs of a module by its inputs. Expensive pure modules are skipped
+	/// for repeated inputs, at most Capacity outputs are kept and evicted by CLOCK algorithm.
+	/// Inputs are hashed as a tuple by Hash and compared by operator==.
+	/// Memoized derives from the module, so it demands, generates and transforms
+	/// the same auxiliary data and gets the same settings. The cache is cleared
+	/// when a demanded value or settings change, auxiliary data generated by the module
+	/// are the ones of its last actual call.
+	/// </summary>
+	template<class F, std::size_t Capacity = 1024, class Hash = utils::Tuple_hash>
+	class Memoized : public detail::Memoized_impl<F, Capacity, Hash, typename F::Input_types>
+	{
+		static_assert(!std::is_base_of_v<detail::Batch_functor_, F>, "Batch functors can not be memoized");
+		static_assert(!std::is_base_of_v<detail::Async_functor_, F>, "Async functors can not be memoized");
+
+	public:
+		/// <summary>
+		/// Forwards getting of generated data to the module.
+		/// </summary>
+		template<typename T, class M>
+		static inline T get(M& m)
+		{
+			return F::template get<T>(static_cast<F&>(m));
+		}
+
+		inline std::size_t hits() const noexcept { return this->hits_; }
+		inline std::size_t misses() const noexcept { return this->misses_; }
+
+		inline void clear_cache() noexcept
+		{
+			this->cache_.clear();
+			this->is_invalidated_ = false;
+		}
+	};
+}
+
+#endif
@@ -0,0 +1,288 @@
+/*
+Copyright 2019 Ilia S. Kovalev
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef ALIGNED_JOIN_HPP
+#define ALIGNED_JOIN_HPP
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "../interfaces.hpp"
+#include "../detail/poll_backoff.hpp"
+#include "../utils/spsc_ring.hpp"
+
+namespace algorithm_assembler::modules
+{
+	/// <summary>
+	/// Reads timestamp or sequence number of an item from its timestamp field.
+	/// </summary>
+	struct Timestamp_field
+	{
+		template<typename T>
+		inline std::int64_t operator()(const T& item) const noexcept
+		{
+			return static_cast<std::int64_t>(item.timestamp);
+		}
+	};
+
+	struct Aligned_join_settings
+	{
+		/// <summary>
+		/// Maximal difference of timestamps of joined items.
+		/// </summary>
+		std::int64_t tolerance = 0;
+
+		/// <summary>
+		/// Number of items buffered per source, a source waits while its buffer is full.
+		/// </summary>
+		std::size_t buffer_size = 1024;
+
+		/// <summary>
+		/// Sleep between checks of a full or empty buffer after a few yields.
+		/// </summary>
+		std::chrono::microseconds poll_interval{ 50 };
+	};
+
+	/// <summary>
+	/// Data source joining items of several sources by timestamps.
+	/// Every source is pulled on its own thread into a bounded lock-free ring buffer.
+	/// Timestamps of every source must not decrease. Items whose timestamps are below
+	/// the watermark, the greatest head timestamp minus tolerance, can not be matched
+	/// anymore and are dropped, so memory stays bounded and no source is waited for
+	/// longer than needed. Heads within tolerance of each other are returned as a tuple.
+	/// The join ends when a source ends and its buffer is drained.
+	/// Sources are started by the first pull, settings may be applied before it.
+	/// </summary>
+	template<class Get_timestamp, class Source, class... Sources>
+	class Aligned_join :
+		public Functor<std::tuple<typename Source::Output_type, typename Sources::Output_type...>>,
+		public Uses_settings<Aligned_join_settings>
+	{
+		static constexpr std::size_t count = sizeof...(Sources) + 1;
+
+	public:
+		using Output = std::tuple<typename Source::Output_type, typename Sources::Output_type...>;
+
+		static_assert(std::is_object_v<typename Source::Output_type> && (std::is_object_v<typename Sources::Output_type> && ...),
+			"Joined sources must return values");
+
+		Aligned_join() = default;
+
+		Aligned_join(const Aligned_join&) = delete;
+		Aligned_join& operator=(const Aligned_join&) = delete;
+
+		~Aligned_join()
+		{
+			stop();
+		}
+
+		inline void set(const Aligned_join_settings& settings) override
+		{
+			stop();
+			settings_ = settings;
+		}
+
+		inline Output operator()() override
+		{
+			if (!prepare())
+				throw std::runtime_error("Aligned_join has ended");
+
+			return pop(std::make_index_sequence<count>{});
+		}
+
+		inline bool is_active() const override
+		{
+			return prepare();
+		}
+
+		/// <summary>
+		/// Gives access to a source, e.g. to set it up before the first pull.
+		/// </summary>
+		template<std::size_t I>
+		inline auto& source() noexcept { return std::get<I>(sources_); }
+
+		/// <summary>
+		/// Number of items dropped as unmatched.
+		/// </summary>
+		inline std::size_t dropped() const noexcept { return dropped_; }
+
+	private:
+		template<typename T>
+		struct Stream
+		{
+			explicit Stream(std::size_t buffer_size) : ring(buffer_size) {}
+
+			utils::Spsc_ring<T> ring;
+			std::atomic<bool> is_finished{ false };
+			std::exception_ptr error;
+		};
+
+		template<typename T>
+		using Stream_ptr = std::unique_ptr<Stream<T>>;
+
+		/// <summary>
+		/// Starts sources and waits until heads of all buffers are aligned.
+		/// </summary>
+		/// <returns>false if the join ended.</returns>
+		inline bool prepare() const
+		{
+			if (!is_started_)
+				start(std::make_index_sequence<count>{});
+
+			for (;;)
+			{
+				std::array<std::int64_t, count> heads;
+				if (!wait_heads(heads, std::make_index_sequence<count>{}))
+					return false;
+
+				auto watermark = *std::max_element(heads.begin(), heads.end()) - settings_.tolerance;
+				if (!drop_below(watermark, heads, std::make_index_sequence<count>{}))
+					return true;
+			}
+		}
+
+		template<std::size_t... Is>
+		inline void start(std::index_sequence<Is...>) const
+		{
+			is_started_ = true;
+			is_stopping_ = false;
+
+			streams_ = std::make_tuple(std::make_unique<Stream<typename Source::Output_type>>(settings_.buffer_size),
+				std::make_unique<Stream<typename Sources::Output_type>>(settings_.buffer_size)...);
+
+			((threads_[Is] = std::thread([this]() { produce<Is>(); })), ...);
+		}
+
+		inline void stop()
+		{
+			is_stopping_ = true;
+			for (auto& t : threads_)
+				if (t.joinable())
+					t.join();
+
+			is_started_ = false;
+		}
+
+		template<std::size_t I>
+		inline void produce() const
+		{
+			auto& source = std::get<I>(sources_);
+			auto& stream = *std::get<I>(streams_);
+
+			try
+			{
+				while (!is_stopping_ && source.is_active())
+				{
+					auto item = source();
+
+					detail::Poll_backoff backoff(settings_.poll_interval);
+					while (!stream.ring.try_push(std::move(item)))
+					{
+						if (is_stopping_)
+							return;
+						backoff.wait();
+					}
+				}
+			}
+			catch (...)
+			{
+				stream.error = std::current_exception();
+			}
+
+			stream.is_finished.store(true, std::memory_order_release);
+		}
+
+		template<std::size_t... Is>
+		inline bool wait_heads(std::array<std::int64_t, count>& heads, std::index_sequence<Is...>) const
+		{
+			return (wait_head<Is>(heads[Is]) && ...);
+		}
+
+		/// <summary>
+		/// Waits for an item of a source.
+		/// </summary>
+		/// <returns>false if the source ended.</returns>
+		template<std::size_t I>
+		inline bool wait_head(std::int64_t& timestamp) const
+		{
+			auto& stream = *std::get<I>(streams_);
+			detail::Poll_backoff backoff(settings_.poll_interval);
+
+			for (;;)
+			{
+				if (auto item = stream.ring.front())
+				{
+					timestamp = get_timestamp_(*item);
+					return true;
+				}
+
+				if (stream.is_finished.load(std::memory_order_acquire))
+				{
+					// Items pushed before the flag was set are visible now.
+					if (stream.ring.front() != nullptr)
+						continue;
+
+					if (stream.error)
+						std::rethrow_exception(std::exchange(stream.error, nullptr));
+					return false;
+				}
+
+				backoff.wait();
+			}
+		}
+
+		template<std::size_t... Is>
+		inline bool drop_below(std::int64_t watermark, const std::array<std::int64_t, count>& heads, std::index_sequence<Is...>) const
+		{
+			bool is_dropped = false;
+			((heads[Is] < watermark ? (std::get<Is>(streams_)->ring.pop(), ++dropped_, is_dropped = true) : false), ...);
+			return is_dropped;
+		}
+
+		template<std::size_t... Is>
+		inline Output pop(std::index_sequence<Is...>)
+		{
+			Output out{ std::move(*std::get<Is>(streams_)->ring.front())... };
+			(std::get<Is>(streams_)->ring.pop(), ...);
+			return out;
+		}
+
+		Aligned_join_settings settings_;
+		mutable Get_timestamp get_timestamp_;
+
+		// Starting sources and looking ahead are not observable changes, is_active() is const.
+		mutable std::tuple<Source, Sources...> sources_;
+		mutable std::tuple<Stream_ptr<typename Source::Output_type>, Stream_ptr<typename Sources::Output_type>...> streams_;
+		mutable std::array<std::thread, count> threads_;
+
+		mutable std::atomic<bool> is_stopping_{ false };
+		mutable bool is_started_ = false;
+		mutable std::size_t dropped_ = 0;
+	};
+}
+
+#endif
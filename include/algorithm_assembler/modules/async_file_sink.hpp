@@ -0,0 +1,424 @@
+/*
+Copyright 2019 Ilia S. Kovalev
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef ASYNC_FILE_SINK_HPP
+#define ASYNC_FILE_SINK_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstring>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "../interfaces.hpp"
+#include "../detail/file_writer.hpp"
+#include "../utils/aligned_buffer.hpp"
+#include "../utils/buffer_pool.hpp"
+#include "../utils/span.hpp"
+
+namespace algorithm_assembler::modules
+{
+	/// <summary>
+	/// Writes object representation of trivially copyable values.
+	/// read() restores a value from what write() wrote.
+	/// </summary>
+	template<typename T>
+	struct Raw_serializer
+	{
+		static_assert(std::is_trivially_copyable_v<T>, "Raw_serializer requires trivially copyable type");
+
+		static std::size_t size(const T&) noexcept { return sizeof(T); }
+		static void write(const T& value, std::byte* out) noexcept { std::memcpy(out, &value, sizeof(T)); }
+
+		static T read(const std::byte* in, std::size_t) noexcept
+		{
+			T value;
+			std::memcpy(&value, in, sizeof(T));
+			return value;
+		}
+	};
+
+	/// <summary>
+	/// Writes elements of a span without any framing.
+	/// </summary>
+	template<typename T>
+	struct Raw_serializer<utils::Span<T>>
+	{
+		static_assert(std::is_trivially_copyable_v<std::remove_cv_t<T>>, "Raw_serializer requires trivially copyable type");
+
+		static std::size_t size(const utils::Span<T>& s) noexcept { return s.size() * sizeof(T); }
+		static void write(const utils::Span<T>& s, std::byte* out) noexcept
+		{
+			if (!s.empty())
+				std::memcpy(out, s.data(), size(s));
+		}
+	};
+
+	template<typename T, class Allocator>
+	struct Raw_serializer<std::vector<T, Allocator>>
+	{
+		static std::size_t size(const std::vector<T, Allocator>& v) noexcept { return v.size() * sizeof(T); }
+		static void write(const std::vector<T, Allocator>& v, std::byte* out) noexcept
+		{
+			Raw_serializer<utils::Span<const T>>::write(utils::Span<const T>(v), out);
+		}
+
+		static std::vector<T, Allocator> read(const std::byte* in, std::size_t size)
+		{
+			std::vector<T, Allocator> v(size / sizeof(T));
+			if (!v.empty())
+				std::memcpy(v.data(), in, v.size() * sizeof(T));
+			return v;
+		}
+	};
+
+	template<typename Char, class Traits, class Allocator>
+	struct Raw_serializer<std::basic_string<Char, Traits, Allocator>>
+	{
+		static std::size_t size(const std::basic_string<Char, Traits, Allocator>& s) noexcept { return s.size() * sizeof(Char); }
+		static void write(const std::basic_string<Char, Traits, Allocator>& s, std::byte* out) noexcept
+		{
+			std::memcpy(out, s.data(), size(s));
+		}
+
+		static std::basic_string<Char, Traits, Allocator> read(const std::byte* in, std::size_t size)
+		{
+			std::basic_string<Char, Traits, Allocator> s(size / sizeof(Char), Char{});
+			if (!s.empty())
+				std::memcpy(s.data(), in, s.size() * sizeof(Char));
+			return s;
+		}
+	};
+
+
+	struct File_sink_settings
+	{
+		std::string path;
+		bool append = false;
+
+		/// <summary>
+		/// Buffer is handed to the writer when it has at least this number of bytes.
+		/// </summary>
+		std::size_t flush_size = std::size_t{ 1 } << 20;
+
+		/// <summary>
+		/// Partially filled buffer is handed to the writer when it is older than this.
+		/// </summary>
+		std::chrono::milliseconds flush_interval{ 100 };
+
+		/// <summary>
+		/// Number of buffers being written before the sink makes the pipeline wait.
+		/// </summary>
+		std::size_t max_pending_buffers = 8;
+
+		/// <summary>
+		/// Number of requests in flight if io_uring is used, 0 disables io_uring.
+		/// </summary>
+		unsigned queue_depth = 32;
+	};
+
+	/// <summary>
+	/// Final pipeline stage writing its inputs to a file on a background thread.
+	/// Inputs are serialised into large aligned buffers; full buffers are written by a batch
+	/// through io_uring when it is available and by pwrite otherwise. The writer thread hands
+	/// over a partially filled buffer itself once it is older than the flush interval.
+	/// Returns false when writer falls behind and the call had to wait for it (backpressure).
+	/// Writer errors are rethrown by the next call or by flush().
+	/// </summary>
+	template<typename T, class Serializer = Raw_serializer<T>>
+	class Async_file_sink :
+		public Functor<bool, const T&>,
+		public Uses_settings<File_sink_settings>
+	{
+		using Buffer = utils::Pooled<utils::Aligned_buffer>;
+		using Clock = std::chrono::steady_clock;
+
+	public:
+		Async_file_sink() = default;
+
+		Async_file_sink(const Async_file_sink&) = delete;
+		Async_file_sink& operator=(const Async_file_sink&) = delete;
+
+		~Async_file_sink()
+		{
+			try { close(); }
+			catch (...) {}
+		}
+
+		/// <summary>
+		/// Opens file and starts writer thread.
+		/// </summary>
+		inline void set(const File_sink_settings& settings) override
+		{
+			close();
+
+			settings_ = settings;
+			writer_.open(settings_.path, settings_.append, settings_.queue_depth);
+
+			stop_ = false;
+			error_ = nullptr;
+			partial_started_.reset();
+			thread_ = std::thread([this]() { write_loop(); });
+		}
+
+		inline bool operator()(const T& value) override
+		{
+			rethrow_writer_error();
+
+			auto size = Serializer::size(value);
+			{
+				std::lock_guard<std::mutex> lock(current_mutex_);
+
+				if (!current_ || current_->available() < size)
+				{
+					if (current_ && !current_->empty())
+						enqueue();
+					acquire(size);
+				}
+
+				Serializer::write(value, current_->grow(size));
+
+				if (current_->size() >= settings_.flush_size)
+					enqueue();
+				else if (size > 0 && current_->size() == size)
+					start_interval();
+			}
+
+			return wait_for_writer();
+		}
+
+		/// <summary>
+		/// Hands the current buffer to the writer and waits until everything is written.
+		/// </summary>
+		inline void flush()
+		{
+			{
+				std::lock_guard<std::mutex> lock(current_mutex_);
+				if (current_ && !current_->empty())
+					enqueue();
+			}
+
+			std::unique_lock<std::mutex> lock(mutex_);
+			written_.wait(lock, [this]() { return pending_ == 0 || error_; });
+			lock.unlock();
+
+			rethrow_writer_error();
+		}
+
+		/// <summary>
+		/// Flushes data, stops writer and closes file.
+		/// </summary>
+		inline void close()
+		{
+			if (!thread_.joinable())
+				return;
+
+			std::exception_ptr error;
+			try { flush(); }
+			catch (...) { error = std::current_exception(); }
+
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+				stop_ = true;
+			}
+			queued_.notify_one();
+			thread_.join();
+
+			writer_.close();
+			current_.release();
+			partial_started_.reset();
+
+			if (error)
+				std::rethrow_exception(error);
+		}
+
+		/// <summary>
+		/// Number of buffers handed to the writer and not written yet.
+		/// </summary>
+		inline std::size_t pending_buffers() const
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			return pending_;
+		}
+
+		/// <summary>
+		/// True if the next full buffer will make the pipeline wait.
+		/// </summary>
+		inline bool is_behind() const { return pending_buffers() >= settings_.max_pending_buffers; }
+
+		inline bool uses_io_uring() const noexcept { return writer_.uses_io_uring(); }
+
+	private:
+		inline void acquire(std::size_t size)
+		{
+			current_ = pool_.acquire();
+			current_->clear();
+			current_->reserve(std::max(settings_.flush_size, size));
+		}
+
+		/// <summary>
+		/// Starts flush interval of the current buffer when it gets its first data.
+		/// </summary>
+		inline void start_interval()
+		{
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+				partial_started_ = Clock::now();
+			}
+			queued_.notify_one();
+		}
+
+		/// <summary>
+		/// Hands the current buffer to the writer, current_mutex_ has to be locked.
+		/// </summary>
+		inline void enqueue()
+		{
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+				queue_.push_back(std::move(current_));
+				partial_started_.reset();
+				++pending_;
+			}
+			queued_.notify_one();
+		}
+
+		/// <returns>False if the call had to wait for the writer.</returns>
+		inline bool wait_for_writer()
+		{
+			bool kept_up = true;
+			{
+				std::unique_lock<std::mutex> lock(mutex_);
+
+				if (pending_ > settings_.max_pending_buffers)
+				{
+					kept_up = false;
+					written_.wait(lock, [this]() { return pending_ <= settings_.max_pending_buffers || error_; });
+				}
+			}
+
+			rethrow_writer_error();
+			return kept_up;
+		}
+
+		/// <summary>
+		/// Hands the current buffer to the writer if its flush interval elapsed.
+		/// Called by the writer thread, which never waits for the pipeline while holding current_mutex_.
+		/// </summary>
+		inline void enqueue_expired()
+		{
+			std::lock_guard<std::mutex> current_lock(current_mutex_);
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+				if (!partial_started_ || Clock::now() - *partial_started_ < settings_.flush_interval)
+					return;
+			}
+			enqueue();
+		}
+
+		inline void write_loop()
+		{
+			std::vector<Buffer> batch;
+
+			for (;;)
+			{
+				{
+					std::unique_lock<std::mutex> lock(mutex_);
+					auto has_work = [this]() { return stop_ || !queue_.empty(); };
+
+					if (partial_started_)
+						queued_.wait_until(lock, *partial_started_ + settings_.flush_interval, has_work);
+					else
+						queued_.wait(lock, [&]() { return has_work() || partial_started_.has_value(); });
+
+					if (queue_.empty())
+					{
+						if (stop_)
+							return;
+
+						lock.unlock();
+						enqueue_expired();
+						continue;
+					}
+
+					batch.swap(queue_);
+				}
+
+				try
+				{
+					if (!error_)
+						writer_.write(utils::Span<Buffer>(batch));
+				}
+				catch (...)
+				{
+					std::lock_guard<std::mutex> lock(mutex_);
+					error_ = std::current_exception();
+				}
+
+				auto count = batch.size();
+				batch.clear();
+
+				{
+					std::lock_guard<std::mutex> lock(mutex_);
+					pending_ -= count;
+				}
+				written_.notify_all();
+			}
+		}
+
+		inline void rethrow_writer_error()
+		{
+			std::exception_ptr error;
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+				error = error_;
+			}
+			if (error)
+				std::rethrow_exception(error);
+		}
+
+		File_sink_settings settings_;
+
+		detail::File_writer writer_;
+		utils::Buffer_pool<utils::Aligned_buffer> pool_;
+
+		/// <summary>
+		/// Guards the current buffer, which the writer takes when its flush interval elapses.
+		/// Locked before mutex_.
+		/// </summary>
+		std::mutex current_mutex_;
+		Buffer current_;
+
+		mutable std::mutex mutex_;
+		std::condition_variable queued_;
+		std::condition_variable written_;
+		std::vector<Buffer> queue_;
+		std::size_t pending_ = 0;
+		std::optional<Clock::time_point> partial_started_;
+		bool stop_ = false;
+		std::exception_ptr error_;
+
+		std::thread thread_;
+	};
+}
+
+#endif
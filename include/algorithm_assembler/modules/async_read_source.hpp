@@ -0,0 +1,269 @@
+/*
+Copyright 2019 Ilia S. Kovalev
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef ASYNC_READ_SOURCE_HPP
+#define ASYNC_READ_SOURCE_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "../interfaces.hpp"
+#include "../detail/file_reader.hpp"
+#include "../utils/aligned_buffer.hpp"
+#include "../utils/serialization.hpp"
+#include "../utils/span.hpp"
+
+namespace algorithm_assembler::modules
+{
+	/// <summary>
+	/// Part of a file read by Async_read_source. Data is valid until the next call of the source.
+	/// </summary>
+	struct File_chunk
+	{
+		std::size_t file = 0;			/// Index of the file in Async_read_settings::paths.
+		std::uint64_t offset = 0;		/// Offset of the chunk in the file.
+		utils::Span<const std::byte> data;
+	};
+}
+
+namespace algorithm_assembler::utils
+{
+	/// <summary>
+	/// File_chunk refers to a buffer of the source, it is not serialized.
+	/// </summary>
+	template<>
+	struct is_unrestorable<modules::File_chunk> : std::true_type {};
+}
+
+namespace algorithm_assembler::modules
+{
+
+	struct Async_read_settings
+	{
+		std::vector<std::string> paths;
+
+		/// <summary>
+		/// Files are read by chunks of this size, smaller files are read by a single chunk.
+		/// It must not exceed UINT32_MAX.
+		/// </summary>
+		std::size_t chunk_size = std::size_t{ 64 } << 10;
+
+		/// <summary>
+		/// Number of reads in flight.
+		/// </summary>
+		std::size_t queue_depth = 16;
+
+		bool use_io_uring = true;
+
+		/// <summary>
+		/// Number of reading threads if io_uring is not used.
+		/// </summary>
+		std::size_t fallback_threads = 4;
+	};
+
+	/// <summary>
+	/// Data source reading a list of files by chunks with many reads in flight.
+	/// Reads are executed by io_uring into registered buffers when it is available,
+	/// otherwise by a thread pool. Chunks are returned in file and offset order.
+	/// </summary>
+	class Async_read_source :
+		public Functor<File_chunk>,
+		public Uses_settings<Async_read_settings>,
+		public Transient_output
+	{
+	public:
+		Async_read_source() = default;
+
+		Async_read_source(const Async_read_source&) = delete;
+		Async_read_source& operator=(const Async_read_source&) = delete;
+
+		~Async_read_source() { close(); }
+
+		/// <summary>
+		/// Checks files and starts reading.
+		/// </summary>
+		inline void set(const Async_read_settings& settings) override
+		{
+			if (settings.chunk_size == 0 || settings.queue_depth == 0)
+				throw std::invalid_argument("Chunk size and queue depth must be positive");
+
+			// Length of an io_uring request is a 32-bit word.
+			if (settings.chunk_size > std::numeric_limits<std::uint32_t>::max())
+				throw std::invalid_argument("Chunk size must fit in 32 bits");
+
+			close();
+			settings_ = settings;
+
+			sizes_.clear();
+			total_chunks_ = 0;
+			for (auto& p : settings_.paths)
+			{
+				sizes_.push_back(std::filesystem::file_size(p));
+				total_chunks_ += (sizes_.back() + settings_.chunk_size - 1) / settings_.chunk_size;
+			}
+
+			storage_ = utils::Aligned_buffer(settings_.chunk_size * settings_.queue_depth);
+			buffers_.clear();
+			for (std::size_t i = 0; i < settings_.queue_depth; ++i)
+				buffers_.emplace_back(storage_.data() + i * settings_.chunk_size, settings_.chunk_size);
+			requests_.assign(settings_.queue_depth, {});
+			request_file_.assign(settings_.queue_depth, 0);
+
+			uses_io_uring_ = false;
+#ifdef ALGORITHM_ASSEMBLER_HAS_IO_URING
+			if (settings_.use_io_uring)
+				uses_io_uring_ = uring_.init(buffers_);
+#endif
+			if (!uses_io_uring_)
+				pool_.init(settings_.fallback_threads, buffers_);
+
+			for (std::size_t i = 0; i < settings_.queue_depth; ++i)
+				schedule(i);
+		}
+
+		inline File_chunk operator()() override
+		{
+			if (handed_out_)
+			{
+				auto slot = head_;
+				requests_[slot].file.reset();
+				head_ = (head_ + 1) % requests_.size();
+				--in_flight_;
+				handed_out_ = false;
+				schedule(slot);
+			}
+
+			if (!is_active())
+				return {};
+
+			auto& request = requests_[head_];
+			auto read = wait(head_, request);
+
+			handed_out_ = true;
+			++delivered_;
+
+			return { request_file_[head_], request.offset, { buffers_[head_].data(), read } };
+		}
+
+		inline bool is_active() const override { return delivered_ < total_chunks_; }
+
+		inline bool uses_io_uring() const noexcept { return uses_io_uring_; }
+
+		/// <summary>
+		/// Waits for reads in flight and closes files.
+		/// </summary>
+		inline void close() noexcept
+		{
+#ifdef ALGORITHM_ASSEMBLER_HAS_IO_URING
+			if (uses_io_uring_)
+				uring_.drain();
+			else
+#endif
+				pool_.drain();
+
+			requests_.clear();
+			request_file_.clear();
+			current_file_.reset();
+			next_file_ = 0;
+			next_offset_ = 0;
+			head_ = 0;
+			in_flight_ = 0;
+			handed_out_ = false;
+			delivered_ = 0;
+			total_chunks_ = 0;
+		}
+
+	private:
+		/// <summary>
+		/// Submits read of the next chunk into the slot.
+		/// </summary>
+		inline void schedule(std::size_t slot)
+		{
+			while (next_file_ < sizes_.size() && next_offset_ >= sizes_[next_file_])
+			{
+				++next_file_;
+				next_offset_ = 0;
+				current_file_.reset();
+			}
+
+			if (next_file_ == sizes_.size())
+				return;
+
+			if (!current_file_)
+				current_file_ = std::make_shared<detail::File_reader>(settings_.paths[next_file_]);
+
+			auto size = static_cast<std::size_t>(
+				std::min<std::uint64_t>(settings_.chunk_size, sizes_[next_file_] - next_offset_));
+
+			requests_[slot] = { current_file_, next_offset_, size };
+			request_file_[slot] = next_file_;
+			next_offset_ += size;
+			++in_flight_;
+
+#ifdef ALGORITHM_ASSEMBLER_HAS_IO_URING
+			if (uses_io_uring_)
+			{
+				uring_.submit(slot, requests_[slot]);
+				return;
+			}
+#endif
+			pool_.submit(slot, requests_[slot]);
+		}
+
+		inline std::size_t wait(std::size_t slot, const detail::Read_request& request)
+		{
+#ifdef ALGORITHM_ASSEMBLER_HAS_IO_URING
+			if (uses_io_uring_)
+				return uring_.wait(slot, request);
+#endif
+			return pool_.wait(slot, request);
+		}
+
+		Async_read_settings settings_;
+		std::vector<std::uint64_t> sizes_;
+		std::uint64_t total_chunks_ = 0;
+		std::uint64_t delivered_ = 0;
+
+		utils::Aligned_buffer storage_;
+		std::vector<utils::Span<std::byte>> buffers_;
+		std::vector<detail::Read_request> requests_;
+		std::vector<std::size_t> request_file_;
+
+		std::shared_ptr<const detail::File_reader> current_file_;
+		std::size_t next_file_ = 0;
+		std::uint64_t next_offset_ = 0;
+
+		std::size_t head_ = 0;
+		std::size_t in_flight_ = 0;
+		bool handed_out_ = false;
+
+		bool uses_io_uring_ = false;
+#ifdef ALGORITHM_ASSEMBLER_HAS_IO_URING
+		detail::Uring_read_queue uring_;
+#endif
+		detail::Pool_read_queue pool_;
+	};
+}
+
+#endif
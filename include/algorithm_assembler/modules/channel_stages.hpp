@@ -0,0 +1,118 @@
+/*
+Copyright 2019 Ilia S. Kovalev
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef CHANNEL_STAGES_HPP
+#define CHANNEL_STAGES_HPP
+
+#include <stdexcept>
+
+#include "../interfaces.hpp"
+#include "../utils/channel.hpp"
+
+namespace algorithm_assembler::modules
+{
+	/// <summary>
+	/// Final stage of a pipeline pushing its inputs to a channel read by another pipeline.
+	/// Returns false when the channel made it wait or dropped an item.
+	/// </summary>
+	template<typename T>
+	class Channel_sink : public Functor<bool, const T&>
+	{
+	public:
+		/// <summary>
+		/// The channel must outlive processing.
+		/// </summary>
+		inline void connect(utils::Channel<T>& channel) noexcept { channel_ = &channel; }
+
+		inline bool operator()(const T& value) override
+		{
+			if (channel_ == nullptr)
+				throw std::logic_error("Channel_sink is not connected");
+
+			return channel_->push(value);
+		}
+
+	private:
+		utils::Channel<T>* channel_ = nullptr;
+	};
+
+	/// <summary>
+	/// Data source popping items of a channel filled by another pipeline.
+	/// is_active() waits for an item and is false when the channel is closed and empty.
+	/// </summary>
+	template<typename T>
+	class Channel_source : public Functor<T>
+	{
+	public:
+		/// <summary>
+		/// The channel must outlive processing.
+		/// </summary>
+		inline void connect(utils::Channel<T>& channel) noexcept { channel_ = &channel; }
+
+		inline T operator()() override
+		{
+			auto value = connected().pop();
+			if (!value)
+				throw std::runtime_error("Channel is closed");
+
+			return std::move(*value);
+		}
+
+		inline bool is_active() const override
+		{
+			return connected().wait_for_item();
+		}
+
+	private:
+		inline utils::Channel<T>& connected() const
+		{
+			if (channel_ == nullptr)
+				throw std::logic_error("Channel_source is not connected");
+
+			return *channel_;
+		}
+
+		utils::Channel<T>* channel_ = nullptr;
+	};
+
+	/// <summary>
+	/// Data source slowing down while a consumer is congested: is_active() waits
+	/// for Backpressure of a channel before asking the source. Items are not produced
+	/// faster than they are consumed and are not dropped by the channel policy.
+	/// </summary>
+	template<class Source>
+	class Paced : public Source
+	{
+	public:
+		/// <summary>
+		/// The channel must outlive processing.
+		/// </summary>
+		inline void pace_by(const utils::Backpressure& backpressure) noexcept { backpressure_ = &backpressure; }
+
+		inline bool is_active() const override
+		{
+			if (backpressure_ != nullptr)
+				backpressure_->wait_until_relieved();
+
+			return Source::is_active();
+		}
+
+	private:
+		const utils::Backpressure* backpressure_ = nullptr;
+	};
+}
+
+#endif
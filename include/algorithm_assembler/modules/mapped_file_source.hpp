@@ -0,0 +1,210 @@
+/*
+Copyright 2019 Ilia S. Kovalev
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef MAPPED_FILE_SOURCE_HPP
+#define MAPPED_FILE_SOURCE_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include "../interfaces.hpp"
+#include "../detail/file_mapping.hpp"
+#include "../utils/span.hpp"
+
+namespace algorithm_assembler::modules
+{
+	/// <summary>
+	/// Zero-copy view of a record. Valid until the next call of the source.
+	/// </summary>
+	using Record_view = utils::Span<const std::byte>;
+
+	/// <summary>
+	/// Layout of records in a file.
+	/// </summary>
+	enum class Record_format
+	{
+		fixed_size,		/// All records have Mapped_file_settings::record_size bytes.
+		length_prefixed	/// Every record is preceded by its size as uint32 in native byte order.
+	};
+
+	struct Mapped_file_settings
+	{
+		std::string path;
+		Record_format format = Record_format::fixed_size;
+		std::size_t record_size = 0;
+
+		/// <summary>
+		/// Maximal size of a mapped window. Greater files are remapped by windows while they are read.
+		/// </summary>
+		std::size_t window_size = std::size_t{ 256 } << 20;
+	};
+
+	/// <summary>
+	/// Data source yielding records of a memory-mapped file.
+	/// Truncated record at the end of a file is ignored.
+	/// </summary>
+	class Mapped_file_source :
+		public Functor<Record_view>,
+		public Uses_settings<Mapped_file_settings>,
+		public Transient_output
+	{
+	public:
+		using Length_prefix = std::uint32_t;
+
+		Mapped_file_source() = default;
+
+		Mapped_file_source(const Mapped_file_source&) = delete;
+		Mapped_file_source& operator=(const Mapped_file_source&) = delete;
+
+		/// <summary>
+		/// Opens file and maps its first window.
+		/// </summary>
+		inline void set(const Mapped_file_settings& settings) override
+		{
+			if (settings.format == Record_format::fixed_size && settings.record_size == 0)
+				throw std::invalid_argument("Record size of fixed size records is not set");
+
+			close();
+			settings_ = settings;
+			file_.open(settings_.path);
+
+			if (file_.size() > 0)
+				ensure_mapped(0, std::min<std::uint64_t>(file_.size(), header_size()));
+		}
+
+		inline Record_view operator()() override
+		{
+			std::size_t size = settings_.record_size;
+			std::uint64_t begin = position_;
+
+			if (settings_.format == Record_format::length_prefixed)
+			{
+				if (file_.size() - position_ < sizeof(Length_prefix))
+				{
+					position_ = file_.size();
+					return {};
+				}
+
+				ensure_mapped(position_, sizeof(Length_prefix));
+				size = read_prefix();
+				begin += sizeof(Length_prefix);
+			}
+
+			if (begin + size > file_.size())
+			{
+				position_ = file_.size();
+				return {};
+			}
+
+			ensure_mapped(begin, size);
+			position_ = begin + size;
+
+			return { window_ + (begin - window_offset_), size };
+		}
+
+		inline bool is_active() const override
+		{
+			auto left = file_.size() - position_;
+
+			if (settings_.format == Record_format::fixed_size)
+				return left > 0 && left >= settings_.record_size;
+
+			if (left < sizeof(Length_prefix))
+				return false;
+
+			// Size of the next record is checked only if it is mapped already,
+			// otherwise operator() detects truncation.
+			if (is_mapped(position_, sizeof(Length_prefix)))
+				return left - sizeof(Length_prefix) >= read_prefix();
+
+			return true;
+		}
+
+		/// <summary>
+		/// Offset of the next record in the file.
+		/// </summary>
+		inline std::uint64_t position() const noexcept { return position_; }
+
+		inline void close() noexcept
+		{
+			file_.close();
+			window_ = nullptr;
+			window_offset_ = 0;
+			window_size_ = 0;
+			position_ = 0;
+		}
+
+	private:
+		inline std::size_t header_size() const noexcept
+		{
+			return settings_.format == Record_format::length_prefixed
+				? sizeof(Length_prefix)
+				: settings_.record_size;
+		}
+
+		inline bool is_mapped(std::uint64_t offset, std::size_t size) const noexcept
+		{
+			return window_ != nullptr
+				&& offset >= window_offset_
+				&& offset + size <= window_offset_ + window_size_;
+		}
+
+		inline Length_prefix read_prefix() const noexcept
+		{
+			Length_prefix size;
+			std::memcpy(&size, window_ + (position_ - window_offset_), sizeof(size));
+			return size;
+		}
+
+		/// <summary>
+		/// Remaps window, so it contains the range. Window starts at the greatest aligned offset
+		/// before the range and is extended beyond window_size if a record does not fit into it.
+		/// </summary>
+		inline void ensure_mapped(std::uint64_t offset, std::size_t size)
+		{
+			if (is_mapped(offset, size))
+				return;
+
+			auto granularity = detail::File_mapping::granularity();
+			auto aligned = offset - offset % granularity;
+			auto needed = static_cast<std::size_t>(offset - aligned) + size;
+			auto length = static_cast<std::size_t>(std::min<std::uint64_t>(
+				std::max(settings_.window_size, needed),
+				file_.size() - aligned
+			));
+
+			window_ = nullptr;
+			window_ = file_.map(aligned, length);
+			window_offset_ = aligned;
+			window_size_ = length;
+		}
+
+		Mapped_file_settings settings_;
+		detail::File_mapping file_;
+
+		const std::byte* window_ = nullptr;
+		std::uint64_t window_offset_ = 0;
+		std::size_t window_size_ = 0;
+
+		std::uint64_t position_ = 0;
+	};
+}
+
+#endif
@@ -0,0 +1,237 @@
+/*
+Copyright 2019 Ilia S. Kovalev
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef SHARED_MEMORY_STAGES_HPP
+#define SHARED_MEMORY_STAGES_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <new>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+#include "../interfaces.hpp"
+#include "../detail/shared_memory.hpp"
+#include "async_file_sink.hpp"
+
+namespace algorithm_assembler::modules
+{
+	struct Shared_memory_settings
+	{
+		/// <summary>
+		/// Name of the shared memory object. An empty name makes the sink create a memfd,
+		/// its descriptor is passed to the source process by inheritance or over a socket.
+		/// </summary>
+		std::string name;
+
+		/// <summary>
+		/// Bytes of the ring, a record takes its payload and 16 bytes rounded up to 16.
+		/// </summary>
+		std::size_t capacity = std::size_t{ 1 } << 20;
+
+		/// <summary>
+		/// Sleep between checks of the ring after a few yields.
+		/// </summary>
+		std::chrono::microseconds poll_interval{ 50 };
+	};
+
+	/// <summary>
+	/// Trivially copyable values written by Raw_serializer are read in place.
+	/// </summary>
+	template<typename T, class Serializer>
+	constexpr bool is_read_in_place_v = std::is_trivially_copyable_v<T>
+		&& std::is_same_v<Serializer, Raw_serializer<T>>
+		&& alignof(T) <= detail::Shared_ring::alignment;
+
+
+	/// <summary>
+	/// Final stage of a pipeline passing its inputs to a Shared_memory_source of another process.
+	/// The sink creates the ring, so it is set before the source. Values are written
+	/// by the serializer (size() and write() as for Async_file_sink) straight into the ring.
+	/// Returns false when the ring was full and the call had to wait for the consumer.
+	/// The stream ends by close() or by destruction of the sink.
+	/// </summary>
+	template<typename T, class Serializer = Raw_serializer<T>>
+	class Shared_memory_sink :
+		public Functor<bool, const T&>,
+		public Uses_settings<Shared_memory_settings>
+	{
+	public:
+		Shared_memory_sink() = default;
+
+		Shared_memory_sink(const Shared_memory_sink&) = delete;
+		Shared_memory_sink& operator=(const Shared_memory_sink&) = delete;
+
+		~Shared_memory_sink() { ring_.close(); }
+
+		/// <summary>
+		/// Creates the shared memory ring.
+		/// </summary>
+		inline void set(const Shared_memory_settings& settings) override
+		{
+			ring_.close();
+			settings_ = settings;
+			ring_.create(settings_.name, settings_.capacity);
+		}
+
+		inline bool operator()(const T& value) override
+		{
+			if (!ring_.is_open())
+				throw std::logic_error("Shared_memory_sink is not set");
+
+			auto size = Serializer::size(value);
+
+			bool kept_up = true;
+			detail::Poll_backoff backoff(settings_.poll_interval);
+
+			std::byte* out;
+			while ((out = ring_.try_reserve(size)) == nullptr)
+			{
+				kept_up = false;
+				backoff.wait();
+			}
+
+			Serializer::write(value, out);
+			ring_.commit();
+
+			return kept_up;
+		}
+
+		/// <summary>
+		/// Ends the stream, the source reads the remaining values and becomes inactive.
+		/// </summary>
+		inline void close() noexcept { ring_.close(); }
+
+#ifndef _WIN32
+		/// <summary>
+		/// Descriptor of the shared memory for Shared_memory_source::open().
+		/// </summary>
+		inline int descriptor() const noexcept { return ring_.descriptor(); }
+#endif
+
+	private:
+		Shared_memory_settings settings_;
+		detail::Shared_ring ring_;
+	};
+
+
+	/// <summary>
+	/// Data source reading values of a Shared_memory_sink of another process.
+	/// is_active() waits for a value and is false when the sink closed the stream and it is read.
+	/// Trivially copyable values are returned in place without copying, other values are
+	/// restored by read() of the serializer. The returned reference is valid until the next call.
+	/// </summary>
+	template<typename T, class Serializer = Raw_serializer<T>>
+	class Shared_memory_source :
+		public Functor<const T&>,
+		public Uses_settings<Shared_memory_settings>
+	{
+		constexpr static bool in_place = is_read_in_place_v<T, Serializer>;
+
+	public:
+		/// <summary>
+		/// Opens the ring by the name.
+		/// </summary>
+		inline void set(const Shared_memory_settings& settings) override
+		{
+			settings_ = settings;
+			ring_.open(settings_.name);
+			pending_.reset();
+		}
+
+#ifndef _WIN32
+		/// <summary>
+		/// Opens the ring of a memfd created by a sink with an empty name.
+		/// </summary>
+		inline void open(int fd)
+		{
+			ring_.open(fd);
+			pending_.reset();
+		}
+#endif
+
+		inline const T& operator()() override
+		{
+			release();
+
+			std::size_t size = 0;
+			auto in = wait_for_record(size);
+			if (in == nullptr)
+				throw std::runtime_error("Shared memory stream is closed");
+
+			pending_ = size;
+
+			if constexpr (in_place)
+				return *std::launder(reinterpret_cast<const T*>(in));
+			else
+			{
+				value_ = Serializer::read(in, size);
+				return *value_;
+			}
+		}
+
+		inline bool is_active() const override
+		{
+			// The record of the last value is freed before waiting for the next one.
+			release();
+
+			std::size_t size = 0;
+			return wait_for_record(size) != nullptr;
+		}
+
+	private:
+		/// <summary>
+		/// Frees the record of the last returned value.
+		/// </summary>
+		inline void release() const noexcept
+		{
+			if (pending_)
+				ring_.pop(*pending_);
+			pending_.reset();
+		}
+
+		inline const std::byte* wait_for_record(std::size_t& size) const
+		{
+			if (!ring_.is_open())
+				throw std::logic_error("Shared_memory_source is not set");
+
+			detail::Poll_backoff backoff(settings_.poll_interval);
+
+			for (;;)
+			{
+				if (auto in = ring_.front(size); in != nullptr)
+					return in;
+
+				// Records written before closing are visible after the flag.
+				if (ring_.is_closed())
+					return ring_.front(size);
+
+				backoff.wait();
+			}
+		}
+
+		Shared_memory_settings settings_;
+
+		// Reading position moves in is_active() as well.
+		mutable detail::Shared_ring ring_;
+		mutable std::optional<std::size_t> pending_;
+		std::optional<T> value_;
+	};
+}
+
+#endif
@@ -0,0 +1,385 @@
+/*
+Copyright 2019 Ilia S. Kovalev
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef TRANSPORT_STAGES_HPP
+#define TRANSPORT_STAGES_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include "../interfaces.hpp"
+#include "../detail/socket.hpp"
+#include "async_file_sink.hpp"
+
+namespace algorithm_assembler::detail
+{
+	/// <summary>
+	/// Header of a batch: bytes of its records and their number.
+	/// A record is its size as a 32-bit word followed by the serialized value.
+	/// A header without records ends the stream. Both hosts must have the same byte order.
+	/// </summary>
+	struct Frame_header
+	{
+		std::uint32_t bytes;
+		std::uint32_t count;
+	};
+
+	constexpr std::size_t record_size_length = sizeof(std::uint32_t);
+}
+
+namespace algorithm_assembler::modules
+{
+	struct Transport_settings
+	{
+		Transport_protocol protocol = Transport_protocol::tcp;
+
+		/// <summary>
+		/// Host of TCP or path of a Unix socket. An empty host is every interface
+		/// for the source and the local host for the sink.
+		/// </summary>
+		std::string address;
+
+		/// <summary>
+		/// TCP port, 0 makes the source take a free one.
+		/// </summary>
+		std::uint16_t port = 0;
+
+		/// <summary>
+		/// Batch is sent when it has this number of values...
+		/// </summary>
+		std::size_t batch_size = 256;
+
+		/// <summary>
+		/// ...or this number of bytes.
+		/// </summary>
+		std::size_t batch_bytes = std::size_t{ 1 } << 16;
+
+		/// <summary>
+		/// Connection attempts of the sink before it gives up.
+		/// </summary>
+		std::size_t connect_attempts = 50;
+
+		std::chrono::milliseconds reconnect_interval{ 100 };
+	};
+
+
+	/// <summary>
+	/// Final stage of a pipeline sending its inputs to a Transport_source over a socket.
+	/// Values are serialized (size() and write() as for Async_file_sink) into a batch buffer
+	/// reused for every batch, a full batch is sent with its header by one vectored write.
+	/// A broken connection is reestablished and the batch is sent again, so values of a batch
+	/// may be received twice when the failure is noticed after delivery.
+	/// Returns false when the call sent a batch after reconnecting.
+	/// </summary>
+	template<typename T, class Serializer = Raw_serializer<T>>
+	class Transport_sink :
+		public Functor<bool, const T&>,
+		public Uses_settings<Transport_settings>
+	{
+	public:
+		Transport_sink() = default;
+
+		Transport_sink(const Transport_sink&) = delete;
+		Transport_sink& operator=(const Transport_sink&) = delete;
+
+		~Transport_sink()
+		{
+			try { close(); }
+			catch (...) {}
+		}
+
+		/// <summary>
+		/// Connects to the source, it has to listen already.
+		/// </summary>
+		inline void set(const Transport_settings& settings) override
+		{
+			close();
+			settings_ = settings;
+			connect();
+		}
+
+		inline bool operator()(const T& value) override
+		{
+			if (!socket_.is_open())
+				throw std::logic_error("Transport_sink is not connected");
+
+			constexpr std::size_t max_frame_bytes = std::numeric_limits<std::uint32_t>::max();
+
+			auto size = Serializer::size(value);
+			if (size > max_frame_bytes - detail::record_size_length)
+				throw std::length_error("Value is too large for transport");
+
+			// Byte count of a frame is a 32-bit word, the pending batch is sent before it overflows.
+			bool kept_up = true;
+			if (count_ > 0 && batch_.size() > max_frame_bytes - detail::record_size_length - size)
+				kept_up = send_batch();
+
+			auto offset = batch_.size();
+			batch_.resize(offset + detail::record_size_length + size);
+
+			auto size32 = static_cast<std::uint32_t>(size);
+			std::memcpy(batch_.data() + offset, &size32, sizeof(size32));
+			Serializer::write(value, batch_.data() + offset + detail::record_size_length);
+
+			if (++count_ >= settings_.batch_size || batch_.size() >= settings_.batch_bytes)
+				kept_up = send_batch() && kept_up;
+
+			return kept_up;
+		}
+
+		/// <summary>
+		/// Sends a partial batch.
+		/// </summary>
+		inline void flush()
+		{
+			if (count_ > 0)
+				send_batch();
+		}
+
+		/// <summary>
+		/// Sends the rest and ends the stream, the source becomes inactive after reading it.
+		/// </summary>
+		inline void close()
+		{
+			if (!socket_.is_open())
+				return;
+
+			flush();
+
+			detail::Frame_header end{ 0, 0 };
+			detail::Io_slice slice{ reinterpret_cast<const std::byte*>(&end), sizeof(end) };
+			socket_.send(&slice, 1);
+			socket_.shutdown();
+			socket_.close();
+		}
+
+		/// <summary>
+		/// Number of times the connection was reestablished.
+		/// </summary>
+		inline std::size_t reconnects() const noexcept { return reconnects_; }
+
+	private:
+		inline void connect()
+		{
+			for (std::size_t attempt = 1;; ++attempt)
+			{
+				try
+				{
+					socket_ = detail::Socket::connect(settings_.protocol, settings_.address, settings_.port);
+					return;
+				}
+				catch (const std::system_error&)
+				{
+					if (attempt >= settings_.connect_attempts)
+						throw;
+				}
+				std::this_thread::sleep_for(settings_.reconnect_interval);
+			}
+		}
+
+		/// <returns>false if the connection was reestablished.</returns>
+		inline bool send_batch()
+		{
+			bool kept_up = true;
+
+			detail::Frame_header header{ static_cast<std::uint32_t>(batch_.size()), static_cast<std::uint32_t>(count_) };
+
+			for (;;)
+			{
+				detail::Io_slice slices[] = {
+					{ reinterpret_cast<const std::byte*>(&header), sizeof(header) },
+					{ batch_.data(), batch_.size() }
+				};
+
+				try
+				{
+					socket_.send(slices, 2);
+					break;
+				}
+				catch (const std::system_error&)
+				{
+					kept_up = false;
+					socket_.close();
+					connect();
+					++reconnects_;
+				}
+			}
+
+			// The buffer keeps its capacity for the next batch.
+			batch_.clear();
+			count_ = 0;
+
+			return kept_up;
+		}
+
+		Transport_settings settings_;
+		detail::Socket socket_;
+
+		std::vector<std::byte> batch_;
+		std::size_t count_ = 0;
+		std::size_t reconnects_ = 0;
+	};
+
+
+	/// <summary>
+	/// Data source receiving values of a Transport_sink. It listens from set() on,
+	/// is_active() accepts a connection, waits for a batch and is false after the end of the stream.
+	/// A connection broken before the end is replaced by the next accepted one, a batch
+	/// received in part is dropped. Batches are read into one buffer growing to the largest batch.
+	/// The returned reference is valid until the next call.
+	/// </summary>
+	template<typename T, class Serializer = Raw_serializer<T>>
+	class Transport_source :
+		public Functor<const T&>,
+		public Uses_settings<Transport_settings>
+	{
+	public:
+		Transport_source() = default;
+
+		Transport_source(const Transport_source&) = delete;
+		Transport_source& operator=(const Transport_source&) = delete;
+
+		~Transport_source() { stop_listening(); }
+
+		/// <summary>
+		/// Starts listening.
+		/// </summary>
+		inline void set(const Transport_settings& settings) override
+		{
+			stop_listening();
+
+			settings_ = settings;
+			listener_ = detail::Socket::listen(settings_.protocol, settings_.address, settings_.port);
+			connection_.close();
+			remaining_ = 0;
+			is_ended_ = false;
+		}
+
+		/// <summary>
+		/// TCP port the source listens on.
+		/// </summary>
+		inline std::uint16_t port() const { return listener_.local_port(); }
+
+		inline const T& operator()() override
+		{
+			if (!is_active())
+				throw std::runtime_error("Transport stream is closed");
+
+			if (frame_bytes_ - position_ < detail::record_size_length)
+				throw std::runtime_error("Bad transport frame");
+
+			std::uint32_t size;
+			std::memcpy(&size, buffer_.data() + position_, sizeof(size));
+			position_ += detail::record_size_length;
+
+			if (size > frame_bytes_ - position_)
+				throw std::runtime_error("Bad transport frame");
+
+			value_ = Serializer::read(buffer_.data() + position_, size);
+			position_ += size;
+			--remaining_;
+
+			return *value_;
+		}
+
+		inline bool is_active() const override
+		{
+			if (!listener_.is_open())
+				throw std::logic_error("Transport_source is not set");
+
+			while (remaining_ == 0 && !is_ended_)
+				receive_batch();
+
+			return remaining_ > 0;
+		}
+
+		/// <summary>
+		/// Drops the current connection, the next batch comes from a new one.
+		/// </summary>
+		inline void disconnect() noexcept
+		{
+			connection_.close();
+			remaining_ = 0;
+		}
+
+	private:
+		inline void receive_batch() const
+		{
+			if (!connection_.is_open())
+				connection_ = listener_.accept();
+
+			detail::Frame_header header;
+			if (!connection_.receive(reinterpret_cast<std::byte*>(&header), sizeof(header)))
+			{
+				connection_.close();
+				return;
+			}
+
+			if (header.count == 0)
+			{
+				is_ended_ = true;
+				connection_.close();
+				return;
+			}
+
+			if (buffer_.size() < header.bytes)
+				buffer_.resize(header.bytes);
+
+			if (!connection_.receive(buffer_.data(), header.bytes))
+			{
+				connection_.close();
+				return;
+			}
+
+			frame_bytes_ = header.bytes;
+			position_ = 0;
+			remaining_ = header.count;
+		}
+
+		inline void stop_listening() noexcept
+		{
+			connection_.close();
+			listener_.close();
+
+			if (settings_.protocol == Transport_protocol::unix_socket && !settings_.address.empty())
+				detail::Socket::remove_path(settings_.address);
+		}
+
+		Transport_settings settings_;
+		detail::Socket listener_;
+
+		// Batches are received in is_active().
+		mutable detail::Socket connection_;
+		mutable std::vector<std::byte> buffer_;
+		mutable std::size_t frame_bytes_ = 0;
+		mutable std::size_t position_ = 0;
+		mutable std::size_t remaining_ = 0;
+		mutable bool is_ended_ = false;
+
+		std::optional<T> value_;
+	};
+}
+
+#endif
@@ -0,0 +1,59 @@
+/*
+Copyright 2019 Ilia S. Kovalev
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef WINDOW_HPP
+#define WINDOW_HPP
+
+#include <cstddef>
+
+#include "../interfaces.hpp"
+#include "../utils/ring_buffer.hpp"
+#include "../utils/span.hpp"
+
+namespace algorithm_assembler::modules
+{
+	/// <summary>
+	/// Sliding window over the last N inputs. Returns a contiguous view of the window,
+	/// oldest input first, for moving averages, filters and other windowed kernels.
+	/// The view is shorter than N until N inputs are seen and valid until the next call.
+	/// </summary>
+	template<std::size_t N, typename T>
+	class Window : public Functor<utils::Span<const T>, const T&>, public Transient_output
+	{
+		static_assert(N > 0, "Window must keep at least one input");
+
+	public:
+		inline utils::Span<const T> operator()(const T& in) override
+		{
+			buffer_.push(in);
+			return buffer_.view();
+		}
+
+		inline bool is_full() const noexcept { return buffer_.full(); }
+
+		/// <summary>
+		/// Forgets all inputs, e.g. after a gap in the data.
+		/// </summary>
+		inline void clear() noexcept { buffer_.clear(); }
+
+		inline const utils::Ring_buffer<T>& buffer() const noexcept { return buffer_; }
+
+	private:
+		utils::Ring_buffer<T> buffer_{ N };
+	};
+}
+
+#endif
@@ -0,0 +1,174 @@
+/*
+Copyright 2019 Ilia S. Kovalev
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef MULTI_RATE_HPP
+#define MULTI_RATE_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+#include "data_processor.hpp"
+#include "detail/sub_pipeline.hpp"
+
+namespace algorithm_assembler::detail
+{
+	/// <summary>
+	/// Module running a sub-pipeline only for some items, Derived::is_due() decides for which.
+	/// Skipped items get the last output of the sub-pipeline.
+	/// </summary>
+	template<class Derived, class Pipeline>
+	class Multi_rate :
+		public Combinator_functor<
+			Derived,
+			std::decay_t<typename sub_pipeline_t<Pipeline>::Output_type>,
+			typename sub_pipeline_t<Pipeline>::Input_types
+		>,
+		public combinator_aux_t<sub_pipeline_t<Pipeline>>
+	{
+		using P = sub_pipeline_t<Pipeline>;
+
+	public:
+		using Output = std::decay_t<typename P::Output_type>;
+
+		template<typename... Ins>
+		inline Output process(Ins&&... ins)
+		{
+			has_run_ = static_cast<Derived&>(*this).is_due() || !last_.has_value();
+			if (has_run_)
+				last_ = pipeline_.process(this->demanded_aux(), std::forward<Ins>(ins)...);
+
+			return *last_;
+		}
+
+		template<typename T, class F>
+		static inline T get(F& f)
+		{
+			return f.pipeline_.template get<T>();
+		}
+
+		/// <summary>
+		/// Generated data are new only if the sub-pipeline ran for the last item.
+		/// </summary>
+		template<typename T>
+		inline bool has_new_data() const
+		{
+			return has_run_ && pipeline_.template has_new_data<T>();
+		}
+
+		/// <summary>
+		/// Indicates if the sub-pipeline ran for the last item.
+		/// </summary>
+		inline bool has_run() const noexcept { return has_run_; }
+
+		/// <summary>
+		/// Drops the last output, the sub-pipeline runs for the next item.
+		/// </summary>
+		inline void reset() noexcept { last_.reset(); }
+
+		template<std::size_t I>
+		inline auto& module() noexcept { return pipeline_.template module<I>(); }
+
+	private:
+		P pipeline_;
+		std::optional<Output> last_;
+		bool has_run_ = false;
+	};
+}
+
+namespace algorithm_assembler
+{
+	/// <summary>
+	/// Module running a sub-pipeline for every N-th item, starting from the first one,
+	/// and returning its last output for the other items. A sub-pipeline is a module
+	/// or a Data_processor. Auxiliary data demanded inside are passed to it when it runs,
+	/// data generated inside are passed further with Updating_policy::sometimes,
+	/// so modules demanding them are set only after the sub-pipeline ran.
+	/// </summary>
+	template<std::size_t N, class Pipeline>
+	class Every : public detail::Multi_rate<Every<N, Pipeline>, Pipeline>
+	{
+		static_assert(N > 0, "Period must be positive");
+
+		friend class detail::Multi_rate<Every<N, Pipeline>, Pipeline>;
+
+	public:
+		inline void reset() noexcept
+		{
+			detail::Multi_rate<Every<N, Pipeline>, Pipeline>::reset();
+			position_ = 0;
+		}
+
+	private:
+		inline bool is_due() noexcept
+		{
+			bool is_first = position_ == 0;
+			if (++position_ == N)
+				position_ = 0;
+			return is_first;
+		}
+
+		std::size_t position_ = 0;
+	};
+
+
+	/// <summary>
+	/// Module running a sub-pipeline for an item if the period elapsed since its last run,
+	/// starting from the first item, and returning its last output for the other items.
+	/// Auxiliary data are passed as by Every.
+	/// </summary>
+	template<class Pipeline, class Clock = std::chrono::steady_clock>
+	class Periodic : public detail::Multi_rate<Periodic<Pipeline, Clock>, Pipeline>
+	{
+		using Base = detail::Multi_rate<Periodic<Pipeline, Clock>, Pipeline>;
+
+		friend Base;
+
+	public:
+		using Duration = typename Clock::duration;
+
+		/// <summary>
+		/// Sets the period, it is 100 ms by default.
+		/// </summary>
+		inline void set_period(Duration period) noexcept { period_ = period; }
+
+		inline Duration period() const noexcept { return period_; }
+
+		inline void reset() noexcept
+		{
+			Base::reset();
+			last_run_.reset();
+		}
+
+	private:
+		inline bool is_due()
+		{
+			auto now = Clock::now();
+			if (last_run_.has_value() && now - *last_run_ < period_)
+				return false;
+
+			last_run_ = now;
+			return true;
+		}
+
+		Duration period_ = std::chrono::duration_cast<Duration>(std::chrono::milliseconds(100));
+		std::optional<typename Clock::time_point> last_run_;
+	};
+}
+
+#endif
@@ -0,0 +1,233 @@
+/*
+Copyright 2019 Ilia S. Kovalev
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef PARALLEL_HPP
+#define PARALLEL_HPP
+
+#include <array>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "data_processor.hpp"
+#include "detail/sub_pipeline.hpp"
+#include "utils/thread_pool.hpp"
+
+namespace algorithm_assembler::detail
+{
+	template<typename T>
+	struct shared_input
+	{
+		using type = const std::decay_t<T>&;
+	};
+
+	template<typename T>
+	using shared_input_t = typename shared_input<T>::type;
+
+	/// <summary>
+	/// Position of the last pipeline generating T.
+	/// </summary>
+	template<typename T, class... Pipelines>
+	constexpr std::size_t last_pipeline_generating() noexcept
+	{
+		std::size_t index = sizeof...(Pipelines);
+		std::size_t i = 0;
+		((utils::contains_v<typename Pipelines::Generated_types, T> ? index = i++ : i++), ...);
+		return index;
+	}
+
+	/// <summary>
+	/// Waits for branches running on other threads. Copies do not share the state.
+	/// </summary>
+	class Join_counter
+	{
+	public:
+		Join_counter() = default;
+		Join_counter(const Join_counter&) noexcept {}
+		Join_counter& operator=(const Join_counter&) noexcept { return *this; }
+
+		inline void reset(std::size_t count)
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			remaining_ = count;
+		}
+
+		inline void arrive()
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			if (--remaining_ == 0)
+				cv_.notify_one();
+		}
+
+		inline void wait()
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			cv_.wait(lock, [this]() { return remaining_ == 0; });
+		}
+
+	private:
+		std::mutex mutex_;
+		std::condition_variable cv_;
+		std::size_t remaining_ = 0;
+	};
+}
+
+namespace algorithm_assembler
+{
+	/// <summary>
+	/// Module running several sub-pipelines on the same input and joining their outputs
+	/// into a tuple for the next module. A sub-pipeline is a module or a Data_processor.
+	/// Inputs are taken by const reference and shared by all sub-pipelines,
+	/// so only modules taking inputs by value copy them.
+	///
+	/// Sub-pipelines run one by one, after set_thread_pool() all but the first one
+	/// run on the pool while the first one runs on the calling thread.
+	/// Demanded auxiliary data are passed to every sub-pipeline, generated ones are merged
+	/// by type and passed further with Updating_policy::sometimes, a type generated
+	/// by several sub-pipelines is taken from the last of them.
+	/// </summary>
+	template<class Pipeline, class... Pipelines>
+	class Parallel :
+		public detail::Combinator_functor<
+			Parallel<Pipeline, Pipelines...>,
+			std::tuple<std::decay_t<typename detail::sub_pipeline_t<Pipeline>::Output_type>,
+				std::decay_t<typename detail::sub_pipeline_t<Pipelines>::Output_type>...>,
+			utils::map_t<typename detail::sub_pipeline_t<Pipeline>::Input_types, detail::shared_input<void>>
+		>,
+		public detail::combinator_aux_t<
+			detail::sub_pipeline_t<Pipeline>,
+			detail::sub_pipeline_t<Pipelines>...
+		>
+	{
+		using Inputs = utils::map_t<typename detail::sub_pipeline_t<Pipeline>::Input_types, std::decay<void>>;
+
+		static_assert((std::is_same_v<
+				utils::map_t<typename detail::sub_pipeline_t<Pipelines>::Input_types, std::decay<void>>,
+				Inputs
+			> && ...),
+			"Parallel sub-pipelines must take the same inputs");
+
+		static constexpr std::size_t count = sizeof...(Pipelines) + 1;
+
+	public:
+		using Output = std::tuple<
+			std::decay_t<typename detail::sub_pipeline_t<Pipeline>::Output_type>,
+			std::decay_t<typename detail::sub_pipeline_t<Pipelines>::Output_type>...
+		>;
+
+		template<typename... Ins>
+		inline Output process(const Ins&... ins)
+		{
+			if (pool_ == nullptr)
+				return process_sequentially(std::make_index_sequence<count>{}, ins...);
+			else
+				return process_on_threads(std::make_index_sequence<count>{}, ins...);
+		}
+
+		/// <summary>
+		/// Runs sub-pipelines on the pool, it must outlive processing.
+		/// </summary>
+		inline void set_thread_pool(utils::Thread_pool& pool) noexcept { pool_ = &pool; }
+
+		/// <summary>
+		/// Runs sub-pipelines one by one on the calling thread.
+		/// </summary>
+		inline void run_sequentially() noexcept { pool_ = nullptr; }
+
+		template<typename T, class F>
+		static inline T get(F& f)
+		{
+			constexpr auto I = detail::last_pipeline_generating<T,
+				detail::sub_pipeline_t<Pipeline>, detail::sub_pipeline_t<Pipelines>...>();
+			return std::get<I>(f.pipelines_).template get<T>();
+		}
+
+		template<typename T>
+		inline bool has_new_data() const
+		{
+			constexpr auto I = detail::last_pipeline_generating<T,
+				detail::sub_pipeline_t<Pipeline>, detail::sub_pipeline_t<Pipelines>...>();
+			return std::get<I>(pipelines_).template has_new_data<T>();
+		}
+
+		/// <summary>
+		/// Gives access to module I of sub-pipeline Index.
+		/// </summary>
+		template<std::size_t Index, std::size_t I>
+		inline auto& module() noexcept { return std::get<Index>(pipelines_).template module<I>(); }
+
+	private:
+		template<std::size_t... Is, typename... Ins>
+		inline Output process_sequentially(std::index_sequence<Is...>, const Ins&... ins)
+		{
+			// Elements of a braced list are evaluated in order.
+			return Output{ std::get<Is>(pipelines_).process(this->demanded_aux(), ins...)... };
+		}
+
+		template<std::size_t... Is, typename... Ins>
+		inline Output process_on_threads(std::index_sequence<Is...>, const Ins&... ins)
+		{
+			std::tuple<std::optional<std::tuple_element_t<Is, Output>>...> outputs;
+			std::array<std::exception_ptr, count> errors;
+
+			join_.reset(count - 1);
+			(post<Is>(outputs, errors, ins...), ...);
+
+			run<0>(outputs, errors, ins...);
+			join_.wait();
+
+			for (auto& e : errors)
+				if (e)
+					std::rethrow_exception(e);
+
+			return Output{ std::move(*std::get<Is>(outputs))... };
+		}
+
+		template<std::size_t I, typename Outputs, typename Errors, typename... Ins>
+		inline void post(Outputs& outputs, Errors& errors, const Ins&... ins)
+		{
+			if constexpr (I > 0)
+				pool_->post([this, &outputs, &errors, &ins...]() {
+					run<I>(outputs, errors, ins...);
+					join_.arrive();
+				});
+		}
+
+		template<std::size_t I, typename Outputs, typename Errors, typename... Ins>
+		inline void run(Outputs& outputs, Errors& errors, const Ins&... ins) noexcept
+		{
+			try
+			{
+				std::get<I>(outputs).emplace(std::get<I>(pipelines_).process(this->demanded_aux(), ins...));
+			}
+			catch (...)
+			{
+				errors[I] = std::current_exception();
+			}
+		}
+
+		std::tuple<detail::sub_pipeline_t<Pipeline>, detail::sub_pipeline_t<Pipelines>...> pipelines_;
+		utils::Thread_pool* pool_ = nullptr;
+		detail::Join_counter join_;
+	};
+}
+
+#endif
@@ -0,0 +1,448 @@
+/*
+Copyright 2019 Ilia S. Kovalev
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef SCHEDULER_HPP
+#define SCHEDULER_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "data_processor.hpp"
+#include "utils/misc.hpp"
+
+namespace algorithm_assembler::detail
+{
+	/// <summary>
+	/// Processor registered in Scheduler. A job runs on one worker at a time,
+	/// is_scheduled is set while it is queued or running.
+	/// </summary>
+	class Scheduled_job
+	{
+	public:
+		explicit Scheduled_job(std::size_t priority) noexcept : priority(priority > 0 ? priority : 1) {}
+
+		virtual ~Scheduled_job() = default;
+
+		/// <summary>
+		/// Processes up to n items.
+		/// </summary>
+		/// <returns>true if the job has more items.</returns>
+		virtual bool run(std::size_t n) = 0;
+
+		/// <summary>
+		/// Indicates if the job got items after it ran out of them.
+		/// </summary>
+		virtual bool has_items() = 0;
+
+		const std::size_t priority;
+		std::atomic<bool> is_scheduled{ false };
+	};
+
+	/// <summary>
+	/// Queue of jobs owned by a worker. The owner takes jobs from the front,
+	/// other workers steal from the back.
+	/// </summary>
+	struct alignas(utils::cache_line_size) Worker_queue
+	{
+		std::mutex mutex;
+		std::deque<Scheduled_job*> jobs;
+	};
+
+	struct Ignore_output
+	{
+		template<typename T>
+		inline void operator()(T&&) const noexcept {}
+	};
+}
+
+namespace algorithm_assembler
+{
+	struct Scheduler_settings
+	{
+		/// <summary>
+		/// Number of workers, 0 for hardware_concurrency().
+		/// </summary>
+		std::size_t threads = 0;
+
+		/// <summary>
+		/// Items a job of priority 1 processes per turn before other jobs get the worker.
+		/// A job of priority p processes p times more.
+		/// </summary>
+		std::size_t quantum = 16;
+	};
+
+	/// <summary>
+	/// Runs many Data_processor instances on a fixed number of worker threads.
+	/// A data source processor runs while it is active, a processor with inputs runs
+	/// when inputs are pushed to it. Every processor runs on one worker at a time
+	/// for a quantum of items and then yields the worker to the next queued one,
+	/// so processors share workers fairly in proportion to their priorities.
+	/// Workers take processors from their own queues and steal from others when idle.
+	/// Processors must outlive the scheduler or the end of processing.
+	/// </summary>
+	class Scheduler
+	{
+	public:
+		/// <summary>
+		/// Processor with inputs registered in the scheduler.
+		/// </summary>
+		template<class Processor, class Sink>
+		class Input_job : public detail::Scheduled_job
+		{
+			template<typename... Ins>
+			static std::tuple<std::decay_t<Ins>...> inputs_tuple(utils::Typelist<Ins...>);
+
+			using Inputs = decltype(inputs_tuple(typename Processor::Input_types{}));
+
+		public:
+			Input_job(Scheduler& scheduler, Processor& processor, Sink&& sink, std::size_t priority) :
+				Scheduled_job(priority), scheduler_(scheduler), processor_(processor), sink_(std::move(sink))
+			{}
+
+			/// <summary>
+			/// Queues an item, it is processed by a worker later.
+			/// </summary>
+			template<typename... Args>
+			inline void push(Args&&... args)
+			{
+				{
+					std::lock_guard<std::mutex> lock(mutex_);
+					inputs_.emplace_back(std::forward<Args>(args)...);
+				}
+				scheduler_.schedule(*this);
+			}
+
+			/// <summary>
+			/// Number of queued items.
+			/// </summary>
+			inline std::size_t queued() const
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+				return inputs_.size();
+			}
+
+			inline bool run(std::size_t n) override
+			{
+				for (std::size_t i = 0; i < n; ++i)
+				{
+					Inputs in;
+					{
+						std::lock_guard<std::mutex> lock(mutex_);
+						if (inputs_.empty())
+							return false;
+
+						in = std::move(inputs_.front());
+						inputs_.pop_front();
+					}
+
+					// An item failing to process is dropped, the next ones are processed.
+					try
+					{
+						sink_(std::apply(processor_, std::move(in)));
+					}
+					catch (...)
+					{
+						scheduler_.set_error(std::current_exception());
+					}
+				}
+
+				return has_items();
+			}
+
+			inline bool has_items() override
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+				return !inputs_.empty();
+			}
+
+		private:
+			Scheduler& scheduler_;
+			Processor& processor_;
+			Sink sink_;
+
+			mutable std::mutex mutex_;
+			std::deque<Inputs> inputs_;
+		};
+
+		explicit Scheduler(const Scheduler_settings& settings = {}) :
+			quantum_(settings.quantum > 0 ? settings.quantum : 1)
+		{
+			auto threads = settings.threads > 0 ? settings.threads : std::thread::hardware_concurrency();
+			if (threads == 0)
+				threads = 1;
+
+			queues_ = std::make_unique<detail::Worker_queue[]>(threads);
+
+			workers_.reserve(threads);
+			for (std::size_t i = 0; i < threads; ++i)
+				workers_.emplace_back([this, i]() { work(i); });
+		}
+
+		Scheduler(const Scheduler&) = delete;
+		Scheduler& operator=(const Scheduler&) = delete;
+
+		/// <summary>
+		/// Stops workers after their current turns, use wait() to finish processing.
+		/// </summary>
+		~Scheduler()
+		{
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+				is_stopping_ = true;
+			}
+			ready_cv_.notify_all();
+
+			for (auto& w : workers_)
+				w.join();
+		}
+
+		/// <summary>
+		/// Registers a data source processor, it runs until it is not active.
+		/// A source throwing an exception is stopped.
+		/// </summary>
+		/// <param name="sink">Called with every output on a worker thread.</param>
+		template<class Processor, class Sink = detail::Ignore_output>
+		inline void add_source(Processor& processor, Sink sink = {}, std::size_t priority = 1)
+		{
+			static_assert(Processor::Input_types::size == 0, "Processor is not a data source");
+
+			schedule(add_job(std::make_unique<Source_job<Processor, Sink>>(*this, processor, std::move(sink), priority)));
+		}
+
+		/// <summary>
+		/// Registers a processor with inputs, items are given by push() of the returned job.
+		/// </summary>
+		/// <param name="sink">Called with every output on a worker thread.</param>
+		template<class Processor, class Sink = detail::Ignore_output>
+		inline Input_job<Processor, Sink>& add(Processor& processor, Sink sink = {}, std::size_t priority = 1)
+		{
+			static_assert(Processor::Input_types::size > 0, "Data sources are added by add_source()");
+
+			return add_job(std::make_unique<Input_job<Processor, Sink>>(*this, processor, std::move(sink), priority));
+		}
+
+		/// <summary>
+		/// Waits until all sources finished and all pushed items are processed.
+		/// Rethrows the first exception thrown by a processor since the previous call.
+		/// </summary>
+		inline void wait()
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			idle_cv_.wait(lock, [this]() { return scheduled_ == 0; });
+
+			if (error_)
+				std::rethrow_exception(std::exchange(error_, nullptr));
+		}
+
+		inline std::size_t size() const noexcept { return workers_.size(); }
+
+	private:
+		template<class Processor, class Sink>
+		class Source_job : public detail::Scheduled_job
+		{
+		public:
+			Source_job(Scheduler& scheduler, Processor& processor, Sink&& sink, std::size_t priority) :
+				Scheduled_job(priority), scheduler_(scheduler), processor_(processor), sink_(std::move(sink))
+			{}
+
+			inline bool run(std::size_t n) override
+			{
+				try
+				{
+					for (std::size_t i = 0; i < n; ++i)
+					{
+						if (!processor_.is_active())
+							return false;
+						sink_(processor_());
+					}
+				}
+				catch (...)
+				{
+					scheduler_.set_error(std::current_exception());
+					is_failed_ = true;
+					return false;
+				}
+
+				return true;
+			}
+
+			inline bool has_items() override { return !is_failed_ && processor_.is_active(); }
+
+		private:
+			Scheduler& scheduler_;
+			Processor& processor_;
+			Sink sink_;
+			bool is_failed_ = false;
+		};
+
+		template<class Job>
+		inline Job& add_job(std::unique_ptr<Job> job)
+		{
+			auto& j = *job;
+
+			std::lock_guard<std::mutex> lock(mutex_);
+			jobs_.push_back(std::move(job));
+			return j;
+		}
+
+		/// <summary>
+		/// Queues a job unless it is queued or running already.
+		/// </summary>
+		inline void schedule(detail::Scheduled_job& job)
+		{
+			if (job.is_scheduled.exchange(true))
+				return;
+
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+				++scheduled_;
+			}
+
+			enqueue(job);
+		}
+
+		inline void enqueue(detail::Scheduled_job& job)
+		{
+			// Workers keep their jobs, other threads spread them.
+			auto i = current_worker_ < workers_.size() && this == current_scheduler_
+				? current_worker_
+				: next_queue_.fetch_add(1, std::memory_order_relaxed) % workers_.size();
+
+			{
+				std::lock_guard<std::mutex> lock(queues_[i].mutex);
+				queues_[i].jobs.push_back(&job);
+			}
+
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+				++ready_;
+			}
+			ready_cv_.notify_one();
+		}
+
+		inline detail::Scheduled_job* take(std::size_t worker)
+		{
+			{
+				auto& own = queues_[worker];
+				std::lock_guard<std::mutex> lock(own.mutex);
+				if (!own.jobs.empty())
+				{
+					auto job = own.jobs.front();
+					own.jobs.pop_front();
+					return job;
+				}
+			}
+
+			for (std::size_t k = 1; k < workers_.size(); ++k)
+			{
+				auto& other = queues_[(worker + k) % workers_.size()];
+				std::lock_guard<std::mutex> lock(other.mutex);
+				if (!other.jobs.empty())
+				{
+					auto job = other.jobs.back();
+					other.jobs.pop_back();
+					return job;
+				}
+			}
+
+			return nullptr;
+		}
+
+		inline void work(std::size_t worker)
+		{
+			current_worker_ = worker;
+			current_scheduler_ = this;
+
+			for (;;)
+			{
+				{
+					std::unique_lock<std::mutex> lock(mutex_);
+					ready_cv_.wait(lock, [this]() { return is_stopping_ || ready_ > 0; });
+					if (is_stopping_)
+						return;
+					--ready_;
+				}
+
+				// A counted job is in some queue, it may be taken by another worker meanwhile.
+				detail::Scheduled_job* job = nullptr;
+				while (job == nullptr)
+					job = take(worker);
+
+				if (job->run(quantum_ * job->priority))
+					enqueue(*job);
+				else
+					release(*job);
+			}
+		}
+
+		/// <summary>
+		/// Unschedules a job which ran out of items.
+		/// </summary>
+		inline void release(detail::Scheduled_job& job)
+		{
+			job.is_scheduled.store(false);
+
+			// Items pushed after the job ran out of them did not schedule it.
+			if (job.has_items() && !job.is_scheduled.exchange(true))
+			{
+				enqueue(job);
+				return;
+			}
+
+			std::lock_guard<std::mutex> lock(mutex_);
+			if (--scheduled_ == 0)
+				idle_cv_.notify_all();
+		}
+
+		inline void set_error(std::exception_ptr e)
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			if (!error_)
+				error_ = std::move(e);
+		}
+
+		std::size_t quantum_;
+
+		std::unique_ptr<detail::Worker_queue[]> queues_;
+		std::atomic<std::size_t> next_queue_{ 0 };
+
+		std::mutex mutex_;
+		std::condition_variable ready_cv_;
+		std::condition_variable idle_cv_;
+		std::size_t ready_ = 0;
+		std::size_t scheduled_ = 0;
+		bool is_stopping_ = false;
+		std::exception_ptr error_;
+
+		std::vector<std::unique_ptr<detail::Scheduled_job>> jobs_;
+		std::vector<std::thread> workers_;
+
+		static inline thread_local std::size_t current_worker_ = static_cast<std::size_t>(-1);
+		static inline thread_local const Scheduler* current_scheduler_ = nullptr;
+	};
+}
+
+#endif
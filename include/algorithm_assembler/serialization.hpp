@@ -0,0 +1,138 @@
+/*
+Copyright 2019 Ilia S. Kovalev
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef SERIALIZATION_HPP
+#define SERIALIZATION_HPP
+
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "data_processor.hpp"
+#include "detail/sub_pipeline.hpp"
+#include "utils/serialization.hpp"
+
+namespace algorithm_assembler
+{
+	/// <summary>
+	/// Tuple of values of the listed types, references and constness removed.
+	/// </summary>
+	template<typename Types>
+	struct values_tuple;
+
+	template<typename... Ts>
+	struct values_tuple<utils::Typelist<Ts...>>
+	{
+		using type = std::tuple<std::decay_t<Ts>...>;
+	};
+
+	template<typename Types>
+	using values_tuple_t = typename values_tuple<Types>::type;
+
+	/// <summary>
+	/// Values of Input_types of a module or a Data_processor.
+	/// </summary>
+	template<class Pipeline>
+	using inputs_tuple_t = values_tuple_t<typename detail::sub_pipeline_t<Pipeline>::Input_types>;
+
+	/// <summary>
+	/// Value of Output_type of a module or a Data_processor, empty tuple for void.
+	/// </summary>
+	template<class Pipeline>
+	using output_value_t = std::conditional_t<
+		std::is_void_v<typename detail::sub_pipeline_t<Pipeline>::Output_type>,
+		std::tuple<>,
+		std::decay_t<typename detail::sub_pipeline_t<Pipeline>::Output_type>
+	>;
+
+	/// <summary>
+	/// Values of all types generated by a module or by modules of a Data_processor.
+	/// </summary>
+	template<class Pipeline>
+	using generated_tuple_t = values_tuple_t<typename detail::sub_pipeline_t<Pipeline>::Generated_types>;
+
+
+	namespace detail
+	{
+		template<class Pipeline, typename T, class... Modules>
+		inline std::decay_t<T> generated_value(Pipeline& p, utils::Typelist<Modules...>)
+		{
+			if constexpr (is_data_processor_v<Pipeline>)
+			{
+				constexpr auto I = last_generator_index<T, Modules...>();
+				using M = utils::type_at_t<utils::Typelist<Modules...>, I>;
+				return M::template get<T>(p.template module<I>());
+			}
+			else
+				return Pipeline::template get<T>(p);
+		}
+
+		template<class Pipeline, typename... Ts>
+		inline generated_tuple_t<Pipeline> generated_values(Pipeline& p, utils::Typelist<Ts...>)
+		{
+			return { generated_value<Pipeline, Ts>(p, flatten_modules_t<Pipeline>{})... };
+		}
+	}
+
+	/// <summary>
+	/// Current values of the types generated by a module or a Data_processor, by the last generator of each type.
+	/// </summary>
+	template<class Pipeline>
+	inline generated_tuple_t<Pipeline> generated_values(Pipeline& pipeline)
+	{
+		return detail::generated_values(pipeline, typename detail::sub_pipeline_t<Pipeline>::Generated_types{});
+	}
+
+
+	/// <summary>
+	/// One call of a pipeline: its inputs, output and the generated data after it.
+	/// Serialized by utils::Binary_writer for recording, checkpoints and transport,
+	/// every member type needs memcpy-able layout, a serialize hook or a Binary_format.
+	/// Span members are written with their elements, such records are read back into
+	/// a structure holding std::vector in their place.
+	/// </summary>
+	template<class Pipeline>
+	struct Call_record
+	{
+		inputs_tuple_t<Pipeline> inputs;
+		output_value_t<Pipeline> output;
+		generated_tuple_t<Pipeline> generated;
+
+		template<class Archive>
+		inline void serialize(Archive& archive) { archive(inputs, output, generated); }
+	};
+
+	/// <summary>
+	/// Calls the pipeline and records the call.
+	/// </summary>
+	template<class Pipeline, typename... Ins>
+	inline Call_record<Pipeline> record_call(Pipeline& pipeline, Ins&&... ins)
+	{
+		Call_record<Pipeline> record;
+		record.inputs = inputs_tuple_t<Pipeline>(ins...);
+
+		if constexpr (std::is_void_v<typename detail::sub_pipeline_t<Pipeline>::Output_type>)
+			pipeline(std::forward<Ins>(ins)...);
+		else
+			record.output = pipeline(std::forward<Ins>(ins)...);
+
+		record.generated = generated_values(pipeline);
+		return record;
+	}
+}
+
+#endif
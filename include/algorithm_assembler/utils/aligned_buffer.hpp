@@ -0,0 +1,108 @@
+/*
+Copyright 2019 Ilia S. Kovalev
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef ALIGNED_BUFFER_HPP
+#define ALIGNED_BUFFER_HPP
+
+#include <cstddef>
+#include <new>
+#include <utility>
+
+namespace algorithm_assembler::utils
+{
+	/// <summary>
+	/// Growable byte buffer aligned for direct I/O.
+	/// </summary>
+	class Aligned_buffer
+	{
+	public:
+		static constexpr std::size_t alignment = 4096;
+
+		Aligned_buffer() = default;
+		explicit Aligned_buffer(std::size_t capacity) { reserve(capacity); }
+
+		Aligned_buffer(const Aligned_buffer&) = delete;
+		Aligned_buffer& operator=(const Aligned_buffer&) = delete;
+
+		Aligned_buffer(Aligned_buffer&& other) noexcept :
+			data_(other.data_), size_(other.size_), capacity_(other.capacity_)
+		{
+			other.data_ = nullptr;
+			other.size_ = other.capacity_ = 0;
+		}
+
+		Aligned_buffer& operator=(Aligned_buffer&& other) noexcept
+		{
+			std::swap(data_, other.data_);
+			std::swap(size_, other.size_);
+			std::swap(capacity_, other.capacity_);
+			return *this;
+		}
+
+		~Aligned_buffer() { deallocate(); }
+
+		/// <summary>
+		/// Ensures capacity, content is discarded if buffer is reallocated.
+		/// </summary>
+		inline void reserve(std::size_t capacity)
+		{
+			if (capacity <= capacity_)
+				return;
+
+			capacity = (capacity + alignment - 1) / alignment * alignment;
+
+			deallocate();
+			data_ = static_cast<std::byte*>(::operator new(capacity, std::align_val_t{ alignment }));
+			capacity_ = capacity;
+			size_ = 0;
+		}
+
+		inline std::byte* data() noexcept { return data_; }
+		inline const std::byte* data() const noexcept { return data_; }
+		inline std::size_t size() const noexcept { return size_; }
+		inline std::size_t capacity() const noexcept { return capacity_; }
+		inline std::size_t available() const noexcept { return capacity_ - size_; }
+		inline bool empty() const noexcept { return size_ == 0; }
+
+		/// <summary>
+		/// Extends used part of the buffer.
+		/// </summary>
+		/// <returns>Pointer to the first added byte.</returns>
+		inline std::byte* grow(std::size_t n) noexcept
+		{
+			auto p = data_ + size_;
+			size_ += n;
+			return p;
+		}
+
+		inline void clear() noexcept { size_ = 0; }
+
+	private:
+		inline void deallocate() noexcept
+		{
+			if (data_ != nullptr)
+				::operator delete(data_, std::align_val_t{ alignment });
+			data_ = nullptr;
+			capacity_ = size_ = 0;
+		}
+
+		std::byte* data_ = nullptr;
+		std::size_t size_ = 0;
+		std::size_t capacity_ = 0;
+	};
+}
+
+#endif
@@ -0,0 +1,155 @@
+/*
+Copyright 2019 Ilia S. Kovalev
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef ARENA_HPP
+#define ARENA_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+namespace algorithm_assembler::utils
+{
+	/// <summary>
+	/// Monotonic memory resource for short-lived temporaries.
+	/// Deallocation is a no-op, memory is reclaimed all at once by reset().
+	/// Blocks are kept between resets, so a steady workload stops calling the upstream resource.
+	/// </summary>
+	class Monotonic_arena : public std::pmr::memory_resource
+	{
+	public:
+		explicit Monotonic_arena(
+			std::size_t initial_size = 64 * 1024,
+			std::pmr::memory_resource* upstream = std::pmr::get_default_resource()
+		) :
+			next_block_size_(initial_size > 0 ? initial_size : 1),
+			upstream_(upstream)
+		{}
+
+		Monotonic_arena(const Monotonic_arena&) = delete;
+		Monotonic_arena& operator=(const Monotonic_arena&) = delete;
+
+		~Monotonic_arena() override { release(); }
+
+		/// <summary>
+		/// Makes all the memory available again. Invalidates everything allocated before.
+		/// If the last run did not fit into one block, blocks are merged into a single one
+		/// sized to the whole run.
+		/// </summary>
+		inline void reset() noexcept
+		{
+			if (blocks_.size() > 1)
+			{
+				std::size_t total = 0;
+				for (const auto& b : blocks_)
+					total += b.size;
+
+				release();
+				next_block_size_ = total;
+			}
+
+			current_ = 0;
+			offset_ = 0;
+		}
+
+		/// <summary>
+		/// Returns all blocks to the upstream resource.
+		/// </summary>
+		inline void release() noexcept
+		{
+			for (const auto& b : blocks_)
+				upstream_->deallocate(b.data, b.size, alignof(std::max_align_t));
+
+			blocks_.clear();
+			current_ = 0;
+			offset_ = 0;
+		}
+
+		/// <summary>
+		/// Total size of the owned blocks.
+		/// </summary>
+		inline std::size_t capacity() const noexcept
+		{
+			std::size_t total = 0;
+			for (const auto& b : blocks_)
+				total += b.size;
+			return total;
+		}
+
+		inline std::size_t blocks_count() const noexcept { return blocks_.size(); }
+
+	private:
+		struct Block
+		{
+			std::byte* data;
+			std::size_t size;
+		};
+
+		void* do_allocate(std::size_t bytes, std::size_t alignment) override
+		{
+			while (current_ < blocks_.size())
+			{
+				if (void* p = allocate_from(blocks_[current_], bytes, alignment))
+					return p;
+
+				++current_;
+				offset_ = 0;
+			}
+
+			std::size_t size = next_block_size_;
+			while (size < bytes + alignment)
+				size *= 2;
+
+			auto data = static_cast<std::byte*>(upstream_->allocate(size, alignof(std::max_align_t)));
+			blocks_.push_back({ data, size });
+			next_block_size_ = size * 2;
+
+			current_ = blocks_.size() - 1;
+			offset_ = 0;
+
+			return allocate_from(blocks_[current_], bytes, alignment);
+		}
+
+		void do_deallocate(void*, std::size_t, std::size_t) override {}
+
+		bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+		{
+			return this == &other;
+		}
+
+		inline void* allocate_from(const Block& b, std::size_t bytes, std::size_t alignment) noexcept
+		{
+			auto address = reinterpret_cast<std::uintptr_t>(b.data) + offset_;
+			auto aligned = (address + alignment - 1) & ~(static_cast<std::uintptr_t>(alignment) - 1);
+			auto new_offset = aligned - reinterpret_cast<std::uintptr_t>(b.data) + bytes;
+
+			if (new_offset > b.size)
+				return nullptr;
+
+			offset_ = new_offset;
+			return reinterpret_cast<void*>(aligned);
+		}
+
+		std::vector<Block> blocks_;
+		std::size_t current_ = 0;
+		std::size_t offset_ = 0;
+		std::size_t next_block_size_;
+		std::pmr::memory_resource* upstream_;
+	};
+}
+
+#endif
@@ -0,0 +1,122 @@
+/*
+Copyright 2019 Ilia S. Kovalev
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef BATCH_GENERATOR_HPP
+#define BATCH_GENERATOR_HPP
+
+#include "task.hpp"
+
+#ifdef ALGORITHM_ASSEMBLER_HAS_COROUTINES
+
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <utility>
+
+#include "span.hpp"
+
+namespace algorithm_assembler::utils
+{
+	/// <summary>
+	/// Coroutine yielding values into batches provided by a consumer.
+	/// co_yield suspends the coroutine only when the batch is full,
+	/// so a whole batch is produced by a single resumption.
+	/// </summary>
+	template<typename T>
+	class Batch_generator
+	{
+	public:
+		struct promise_type
+		{
+			T* out = nullptr;
+			std::size_t capacity = 0;
+			std::size_t count = 0;
+			std::exception_ptr error;
+
+			Batch_generator get_return_object() noexcept
+			{
+				return Batch_generator{ std::coroutine_handle<promise_type>::from_promise(*this) };
+			}
+
+			std::suspend_always initial_suspend() const noexcept { return {}; }
+			std::suspend_always final_suspend() const noexcept { return {}; }
+
+			template<typename U>
+			auto yield_value(U&& value)
+			{
+				struct Awaiter
+				{
+					bool is_full;
+
+					bool await_ready() const noexcept { return !is_full; }
+					void await_suspend(std::coroutine_handle<>) const noexcept {}
+					void await_resume() const noexcept {}
+				};
+
+				out[count++] = std::forward<U>(value);
+				return Awaiter{ count == capacity };
+			}
+
+			void return_void() const noexcept {}
+			void unhandled_exception() noexcept { error = std::current_exception(); }
+		};
+
+		Batch_generator() = default;
+
+		explicit Batch_generator(std::coroutine_handle<promise_type> h) noexcept : handle_(h) {}
+
+		Batch_generator(Batch_generator&& other) noexcept : handle_(std::exchange(other.handle_, {})) {}
+
+		Batch_generator& operator=(Batch_generator&& other) noexcept
+		{
+			std::swap(handle_, other.handle_);
+			return *this;
+		}
+
+		~Batch_generator() { if (handle_) handle_.destroy(); }
+
+		/// <summary>
+		/// Resumes the coroutine until the batch is full or the coroutine finishes.
+		/// </summary>
+		/// <returns>Number of produced values.</returns>
+		inline std::size_t fill(Span<T> batch)
+		{
+			if (done() || batch.empty())
+				return 0;
+
+			auto& promise = handle_.promise();
+			promise.out = batch.data();
+			promise.capacity = batch.size();
+			promise.count = 0;
+
+			handle_.resume();
+
+			if (promise.error)
+				std::rethrow_exception(std::exchange(promise.error, nullptr));
+
+			return promise.count;
+		}
+
+		inline bool done() const noexcept { return !handle_ || handle_.done(); }
+
+	private:
+		std::coroutine_handle<promise_type> handle_;
+	};
+}
+
+#endif
+
+#endif
@@ -0,0 +1,190 @@
+/*
+Copyright 2019 Ilia S. Kovalev
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef BUFFER_POOL_HPP
+#define BUFFER_POOL_HPP
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace algorithm_assembler::utils
+{
+	template<typename T> class Buffer_pool;
+}
+
+namespace algorithm_assembler::utils::buffer_pool_detail
+{
+	template<typename T>
+	struct Storage
+	{
+		explicit Storage(std::size_t max_free) : max_free(max_free) {}
+
+		/// <returns>false if the pool is full and the buffer is dropped.</returns>
+		inline bool put(std::unique_ptr<T>&& buffer)
+		{
+			std::lock_guard lock(mutex);
+			if (free.size() >= max_free)
+				return false;
+
+			free.push_back(std::move(buffer));
+			return true;
+		}
+
+		inline std::unique_ptr<T> take()
+		{
+			std::lock_guard lock(mutex);
+			if (free.empty())
+				return {};
+
+			auto buffer = std::move(free.back());
+			free.pop_back();
+			return buffer;
+		}
+
+		std::mutex mutex;
+		std::vector<std::unique_ptr<T>> free;
+		std::size_t max_free;
+	};
+}
+
+namespace algorithm_assembler::utils
+{
+	/// <summary>
+	/// Move-only handle to a buffer taken from Buffer_pool.
+	/// The buffer goes back to its pool when the handle is destroyed or released,
+	/// so a consumed pipeline output is recycled as soon as nothing refers to it.
+	/// </summary>
+	template<typename T>
+	class Pooled
+	{
+	public:
+		Pooled() = default;
+
+		Pooled(const Pooled&) = delete;
+		Pooled& operator=(const Pooled&) = delete;
+
+		Pooled(Pooled&& other) noexcept = default;
+
+		Pooled& operator=(Pooled&& other) noexcept
+		{
+			if (this != &other)
+			{
+				release();
+				buffer_ = std::move(other.buffer_);
+				storage_ = std::move(other.storage_);
+			}
+			return *this;
+		}
+
+		~Pooled() { release(); }
+
+		inline T& operator*() const noexcept { return *buffer_; }
+		inline T* operator->() const noexcept { return buffer_.get(); }
+		inline T* get() const noexcept { return buffer_.get(); }
+
+		inline explicit operator bool() const noexcept { return static_cast<bool>(buffer_); }
+
+		/// <summary>
+		/// Returns the buffer to its pool ahead of destruction.
+		/// </summary>
+		inline void release()
+		{
+			if (buffer_ && storage_)
+				storage_->put(std::move(buffer_));
+
+			buffer_.reset();
+			storage_.reset();
+		}
+
+	private:
+		friend class Buffer_pool<T>;
+
+		Pooled(std::unique_ptr<T>&& buffer, std::shared_ptr<buffer_pool_detail::Storage<T>> storage) :
+			buffer_(std::move(buffer)),
+			storage_(std::move(storage))
+		{}
+
+		std::unique_ptr<T> buffer_;
+		std::shared_ptr<buffer_pool_detail::Storage<T>> storage_;
+	};
+
+
+	/// <summary>
+	/// Pool of reusable buffers for large module outputs.
+	/// Recycled buffers keep their contents and capacity, a module is expected
+	/// to overwrite them. Handles may outlive the pool and may be released from any thread.
+	/// </summary>
+	template<typename T>
+	class Buffer_pool
+	{
+	public:
+		/// <param name="max_free">Maximal number of idle buffers kept for reuse.</param>
+		explicit Buffer_pool(std::size_t max_free = 16) :
+			storage_(std::make_shared<buffer_pool_detail::Storage<T>>(max_free))
+		{}
+
+		/// <summary>
+		/// Takes an idle buffer, or creates a new one from arguments if there is none.
+		/// </summary>
+		template<typename... Args>
+		inline Pooled<T> acquire(Args&&... args)
+		{
+			auto buffer = storage_->take();
+			if (!buffer)
+			{
+				buffer = std::make_unique<T>(std::forward<Args>(args)...);
+				++created_;
+			}
+
+			return Pooled<T>(std::move(buffer), storage_);
+		}
+
+		/// <summary>
+		/// Creates idle buffers in advance, so first items do not allocate.
+		/// No more than max_free idle buffers are kept, creation stops when the pool is full.
+		/// </summary>
+		template<typename... Args>
+		inline void reserve(std::size_t count, const Args&... args)
+		{
+			for (std::size_t i = 0; i < count; ++i)
+			{
+				if (!storage_->put(std::make_unique<T>(args...)))
+					break;
+				++created_;
+			}
+		}
+
+		inline std::size_t free_count() const
+		{
+			std::lock_guard lock(storage_->mutex);
+			return storage_->free.size();
+		}
+
+		/// <summary>
+		/// Number of buffers created by the pool so far.
+		/// </summary>
+		inline std::size_t created_count() const noexcept { return created_; }
+
+	private:
+		std::shared_ptr<buffer_pool_detail::Storage<T>> storage_;
+		std::size_t created_ = 0;
+	};
+}
+
+#endif
@@ -0,0 +1,283 @@
+/*
+Copyright 2019 Ilia S. Kovalev
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef CHANNEL_HPP
+#define CHANNEL_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <utility>
+
+#include "../enums.hpp"
+
+namespace algorithm_assembler::utils
+{
+	struct Channel_settings
+	{
+		std::size_t capacity = 1024;
+
+		Backpressure_policy policy = Backpressure_policy::block;
+
+		/// <summary>
+		/// A full channel with Backpressure_policy::sample keeps one of this number of new items.
+		/// </summary>
+		std::size_t sample_period = 4;
+
+		/// <summary>
+		/// The channel is congested when it has this number of items, 0 for the capacity.
+		/// </summary>
+		std::size_t high_watermark = 0;
+
+		/// <summary>
+		/// A congested channel is relieved when it has no more than this number of items,
+		/// 0 for a half of the high watermark.
+		/// </summary>
+		std::size_t low_watermark = 0;
+	};
+
+	struct Channel_stats
+	{
+		std::size_t pushed = 0;		/// Items given to the channel.
+		std::size_t popped = 0;		/// Items taken from the channel.
+		std::size_t dropped = 0;	/// Items dropped by the backpressure policy.
+		std::size_t waits = 0;		/// Pushes which waited for free space.
+	};
+
+	/// <summary>
+	/// Signal telling a producer to slow down.
+	/// </summary>
+	class Backpressure
+	{
+	public:
+		virtual ~Backpressure() = default;
+
+		/// <summary>
+		/// Waits while the consumer is congested.
+		/// </summary>
+		virtual void wait_until_relieved() const = 0;
+	};
+
+	/// <summary>
+	/// Bounded queue between pipeline stages running on different threads.
+	/// A full channel blocks the producer or drops items by its Backpressure_policy,
+	/// so memory and latency stay bounded when the consumer falls behind.
+	/// Congestion is signalled between the high and the low watermarks, so producers
+	/// may slow down before items are dropped.
+	/// </summary>
+	template<typename T>
+	class Channel : public Backpressure
+	{
+	public:
+		explicit Channel(const Channel_settings& settings = {}) :
+			settings_(settings)
+		{
+			if (settings_.capacity == 0)
+				settings_.capacity = 1;
+			if (settings_.sample_period == 0)
+				settings_.sample_period = 1;
+			if (settings_.high_watermark == 0 || settings_.high_watermark > settings_.capacity)
+				settings_.high_watermark = settings_.capacity;
+			if (settings_.low_watermark == 0 || settings_.low_watermark >= settings_.high_watermark)
+				settings_.low_watermark = settings_.high_watermark / 2;
+		}
+
+		Channel(const Channel&) = delete;
+		Channel& operator=(const Channel&) = delete;
+
+		/// <summary>
+		/// Queues an item, items pushed to a closed channel are dropped.
+		/// </summary>
+		/// <returns>false if the push waited or an item was dropped.</returns>
+		inline bool push(T value)
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			++stats_.pushed;
+
+			bool kept_up = true;
+
+			if (items_.size() >= settings_.capacity && !is_closed_)
+			{
+				kept_up = false;
+
+				switch (settings_.policy)
+				{
+				case Backpressure_policy::block:
+					++stats_.waits;
+					not_full_.wait(lock, [this]() { return items_.size() < settings_.capacity || is_closed_; });
+					break;
+
+				case Backpressure_policy::drop_oldest:
+					drop_oldest();
+					break;
+
+				case Backpressure_policy::drop_newest:
+					++stats_.dropped;
+					return false;
+
+				case Backpressure_policy::sample:
+					if (++since_sample_ < settings_.sample_period)
+					{
+						++stats_.dropped;
+						return false;
+					}
+					since_sample_ = 0;
+					drop_oldest();
+					break;
+				}
+			}
+			else
+				since_sample_ = 0;
+
+			if (is_closed_)
+			{
+				++stats_.dropped;
+				return false;
+			}
+
+			items_.push_back(std::move(value));
+			if (items_.size() >= settings_.high_watermark)
+				is_congested_ = true;
+
+			lock.unlock();
+			not_empty_.notify_one();
+
+			return kept_up;
+		}
+
+		/// <summary>
+		/// Waits for an item.
+		/// </summary>
+		/// <returns>The oldest item or nothing if the channel is closed and empty.</returns>
+		inline std::optional<T> pop()
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			not_empty_.wait(lock, [this]() { return !items_.empty() || is_closed_; });
+			return take(lock);
+		}
+
+		/// <summary>
+		/// Takes an item if there is one.
+		/// </summary>
+		inline std::optional<T> try_pop()
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			return take(lock);
+		}
+
+		/// <summary>
+		/// Waits for an item without taking it.
+		/// </summary>
+		/// <returns>false if the channel is closed and empty.</returns>
+		inline bool wait_for_item() const
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			not_empty_.wait(lock, [this]() { return !items_.empty() || is_closed_; });
+			return !items_.empty();
+		}
+
+		/// <summary>
+		/// Ends the stream, queued items may still be popped and waiting producers are released.
+		/// </summary>
+		inline void close()
+		{
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+				is_closed_ = true;
+			}
+			not_empty_.notify_all();
+			not_full_.notify_all();
+			relieved_.notify_all();
+		}
+
+		inline void wait_until_relieved() const override
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			relieved_.wait(lock, [this]() { return !is_congested_ || is_closed_; });
+		}
+
+		inline bool is_congested() const
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			return is_congested_;
+		}
+
+		inline bool is_closed() const
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			return is_closed_;
+		}
+
+		inline std::size_t size() const
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			return items_.size();
+		}
+
+		inline std::size_t capacity() const noexcept { return settings_.capacity; }
+
+		inline Channel_stats stats() const
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			return stats_;
+		}
+
+	private:
+		inline void drop_oldest()
+		{
+			items_.pop_front();
+			++stats_.dropped;
+		}
+
+		inline std::optional<T> take(std::unique_lock<std::mutex>& lock)
+		{
+			if (items_.empty())
+				return std::nullopt;
+
+			std::optional<T> value(std::move(items_.front()));
+			items_.pop_front();
+			++stats_.popped;
+
+			bool is_relieved = is_congested_ && items_.size() <= settings_.low_watermark;
+			if (is_relieved)
+				is_congested_ = false;
+
+			lock.unlock();
+			not_full_.notify_one();
+			if (is_relieved)
+				relieved_.notify_all();
+
+			return value;
+		}
+
+		Channel_settings settings_;
+
+		mutable std::mutex mutex_;
+		mutable std::condition_variable not_empty_;
+		std::condition_variable not_full_;
+		mutable std::condition_variable relieved_;
+
+		std::deque<T> items_;
+		Channel_stats stats_;
+		std::size_t since_sample_ = 0;
+		bool is_congested_ = false;
+		bool is_closed_ = false;
+	};
+}
+
+#endif
@@ -0,0 +1,194 @@
+/*
+Copyright 2019 Ilia S. Kovalev
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef CLOCK_CACHE_HPP
+#define CLOCK_CACHE_HPP
+
+#include <cstddef>
+#include <functional>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace algorithm_assembler::utils
+{
+	/// <summary>
+	/// Bounded hash map evicting entries by CLOCK (second chance) algorithm.
+	/// Entries live in one open addressing table with linear probing, the table is
+	/// at most half full, so lookups touch few adjacent slots and no memory is allocated
+	/// after construction. Erased entries are closed up by backward shifting, no tombstones.
+	/// </summary>
+	template<typename Key, typename Value, class Hash = std::hash<Key>, class Equal = std::equal_to<Key>>
+	class Clock_cache
+	{
+	public:
+		explicit Clock_cache(std::size_t capacity) :
+			capacity_(capacity > 0 ? capacity : 1),
+			slots_(table_size(capacity_)),
+			mask_(slots_.size() - 1)
+		{}
+
+		/// <summary>
+		/// Finds value of a key.
+		/// </summary>
+		/// <returns>Pointer to the value or nullptr, valid until the next insertion.</returns>
+		inline Value* find(const Key& key)
+		{
+			auto i = lookup(key, hash_(key));
+			if (!slots_[i].entry)
+				return nullptr;
+
+			slots_[i].is_referenced = true;
+			return &slots_[i].entry->second;
+		}
+
+		/// <summary>
+		/// Finds value of a key or inserts the value made by make().
+		/// Nothing is inserted if make() throws.
+		/// </summary>
+		/// <returns>Reference to the value and true if it was found.</returns>
+		template<typename K, class Make>
+		inline std::pair<Value&, bool> find_or_insert(K&& key, Make&& make)
+		{
+			auto hash = hash_(key);
+			auto i = lookup(key, hash);
+			if (slots_[i].entry)
+			{
+				slots_[i].is_referenced = true;
+				return { slots_[i].entry->second, true };
+			}
+
+			Value value = make();
+
+			if (size_ == capacity_)
+			{
+				evict();
+				i = lookup(key, hash);
+			}
+
+			slots_[i].entry.emplace(std::forward<K>(key), std::move(value));
+			slots_[i].hash = hash;
+			slots_[i].is_referenced = false;
+			++size_;
+
+			return { slots_[i].entry->second, false };
+		}
+
+		inline bool erase(const Key& key)
+		{
+			auto i = lookup(key, hash_(key));
+			if (!slots_[i].entry)
+				return false;
+
+			erase_slot(i);
+			return true;
+		}
+
+		inline void clear() noexcept
+		{
+			if (size_ == 0)
+				return;
+
+			for (auto& slot : slots_)
+				slot.entry.reset();
+			size_ = 0;
+			hand_ = 0;
+		}
+
+		inline std::size_t size() const noexcept { return size_; }
+		inline std::size_t capacity() const noexcept { return capacity_; }
+
+	private:
+		struct Slot
+		{
+			std::optional<std::pair<Key, Value>> entry;
+			std::size_t hash = 0;
+			bool is_referenced = false;
+		};
+
+		static inline std::size_t table_size(std::size_t capacity) noexcept
+		{
+			std::size_t size = 2;
+			while (size < 2 * capacity)
+				size *= 2;
+			return size;
+		}
+
+		/// <summary>
+		/// Returns the slot holding the key or the empty slot ending its probe sequence.
+		/// </summary>
+		inline std::size_t lookup(const Key& key, std::size_t hash) const
+		{
+			auto i = hash & mask_;
+			for (; slots_[i].entry; i = (i + 1) & mask_)
+				if (slots_[i].hash == hash && equal_(slots_[i].entry->first, key))
+					break;
+			return i;
+		}
+
+		/// <summary>
+		/// Moves the hand over the table clearing reference bits until an unreferenced entry is found.
+		/// </summary>
+		inline void evict()
+		{
+			for (;;)
+			{
+				auto i = hand_;
+				hand_ = (hand_ + 1) & mask_;
+
+				if (!slots_[i].entry)
+					continue;
+
+				if (slots_[i].is_referenced)
+					slots_[i].is_referenced = false;
+				else
+				{
+					erase_slot(i);
+					return;
+				}
+			}
+		}
+
+		inline void erase_slot(std::size_t i)
+		{
+			slots_[i].entry.reset();
+			--size_;
+
+			// An entry is shifted back unless the gap lies before its home slot.
+			for (auto j = (i + 1) & mask_; slots_[j].entry; j = (j + 1) & mask_)
+			{
+				auto home = slots_[j].hash & mask_;
+				if (((j - home) & mask_) >= ((j - i) & mask_))
+				{
+					slots_[i] = std::move(slots_[j]);
+					slots_[j].entry.reset();
+					i = j;
+				}
+			}
+		}
+
+		std::size_t capacity_;
+		std::vector<Slot> slots_;
+		std::size_t mask_;
+		std::size_t size_ = 0;
+		std::size_t hand_ = 0;
+
+		Hash hash_;
+		Equal equal_;
+	};
+}
+
+#endif
@@ -17,9 +17,60 @@ Copyright 2019 Ilia S. Kovalev
 #ifndef MISC_HPP
 #define MISC_HPP
 
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
 namespace algorithm_assembler::utils
 {
+	/// <summary>
+	/// Distance keeping data used by different threads off shared cache lines.
+	/// GCC warns that its std::hardware_destructive_interference_size depends on tuning flags,
+	/// so the common value is used there.
+	/// </summary>
+#if defined(__cpp_lib_hardware_interference_size) && !defined(__GNUC__)
+	constexpr std::size_t cache_line_size = std::hardware_destructive_interference_size;
+#else
+	constexpr std::size_t cache_line_size = 64;
+#endif
+
+	/// <summary>
+	/// Combines hashes of tuple elements, elements are hashed by std::hash.
+	/// </summary>
+	struct Tuple_hash
+	{
+		template<typename... Ts>
+		inline std::size_t operator()(const std::tuple<Ts...>& t) const
+		{
+			return std::apply([](const auto&... elements) {
+				std::size_t seed = 0;
+				((seed ^= std::hash<std::decay_t<decltype(elements)>>{}(elements)
+					+ static_cast<std::size_t>(0x9e3779b97f4a7c15ull) + (seed << 6) + (seed >> 2)), ...);
+				return seed;
+			}, t);
+		}
+	};
+
+	template<typename T, typename = void>
+	struct is_equality_comparable : public std::false_type {};
+
+	template<typename T>
+	struct is_equality_comparable<T, std::void_t<decltype(std::declval<const T&>() == std::declval<const T&>())>> :
+		public std::true_type
+	{};
+
+	/// <summary>
+	/// Comparison of std::optional is declared for any type, so its value type is checked.
+	/// </summary>
+	template<typename T>
+	struct is_equality_comparable<std::optional<T>> : public is_equality_comparable<T> {};
 
+	template<typename T>
+	constexpr bool is_equality_comparable_v = is_equality_comparable<T>::value;
 }
 
 
@@ -0,0 +1,116 @@
+/*
+Copyright 2019 Ilia S. Kovalev
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef UTILS_NUMA_HPP
+#define UTILS_NUMA_HPP
+
+#include <cstddef>
+#include <new>
+#include <utility>
+
+#include "../detail/numa.hpp"
+
+namespace algorithm_assembler::utils
+{
+	/// <summary>
+	/// Allocator placing memory on a NUMA node, e.g. for queues of a stage running
+	/// on threads of that node. Every allocation takes whole pages,
+	/// so it suits few large containers rather than many small objects.
+	/// </summary>
+	template<typename T>
+	class Numa_allocator
+	{
+	public:
+		using value_type = T;
+
+		explicit Numa_allocator(std::size_t node = 0) noexcept : node_(node) {}
+
+		template<typename U>
+		Numa_allocator(const Numa_allocator<U>& other) noexcept : node_(other.node()) {}
+
+		inline T* allocate(std::size_t n)
+		{
+			return static_cast<T*>(detail::allocate_on_node(n * sizeof(T), node_));
+		}
+
+		inline void deallocate(T* p, std::size_t n) noexcept
+		{
+			detail::deallocate_on_node(p, n * sizeof(T));
+		}
+
+		inline std::size_t node() const noexcept { return node_; }
+
+		template<typename U>
+		inline bool operator==(const Numa_allocator<U>& other) const noexcept { return node_ == other.node(); }
+
+		template<typename U>
+		inline bool operator!=(const Numa_allocator<U>& other) const noexcept { return node_ != other.node(); }
+
+	private:
+		std::size_t node_;
+	};
+
+
+	/// <summary>
+	/// Object constructed in memory of a NUMA node, e.g. state of a module
+	/// called by threads of that node. Members allocating on their own
+	/// place their memory by the policy of the allocating thread.
+	/// </summary>
+	template<typename T>
+	class Node_local
+	{
+	public:
+		template<typename... Args>
+		explicit Node_local(std::size_t node, Args&&... args) :
+			node_(node),
+			memory_(detail::allocate_on_node(sizeof(T), node))
+		{
+			try
+			{
+				value_ = new (memory_) T(std::forward<Args>(args)...);
+			}
+			catch (...)
+			{
+				detail::deallocate_on_node(memory_, sizeof(T));
+				throw;
+			}
+		}
+
+		Node_local(const Node_local&) = delete;
+		Node_local& operator=(const Node_local&) = delete;
+
+		~Node_local()
+		{
+			value_->~T();
+			detail::deallocate_on_node(memory_, sizeof(T));
+		}
+
+		inline T& operator*() noexcept { return *value_; }
+		inline const T& operator*() const noexcept { return *value_; }
+		inline T* operator->() noexcept { return value_; }
+		inline const T* operator->() const noexcept { return value_; }
+		inline T* get() noexcept { return value_; }
+
+		inline std::size_t node() const noexcept { return node_; }
+
+	private:
+		std::size_t node_;
+		void* memory_;
+		T* value_ = nullptr;
+	};
+}
+
+#endif
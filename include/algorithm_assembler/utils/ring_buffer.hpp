@@ -0,0 +1,100 @@
+/*
+Copyright 2019 Ilia S. Kovalev
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef RING_BUFFER_HPP
+#define RING_BUFFER_HPP
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include "span.hpp"
+
+namespace algorithm_assembler::utils
+{
+	/// <summary>
+	/// Keeps the last capacity() pushed values. Storage is mirrored: every value is written
+	/// to its slot in both halves of a buffer of twice the capacity, so the kept values
+	/// are always one contiguous range, oldest first. view() costs no copying and
+	/// kernels reading it need no wrap-around or modulo arithmetic.
+	/// </summary>
+	template<typename T>
+	class Ring_buffer
+	{
+	public:
+		explicit Ring_buffer(std::size_t capacity) :
+			capacity_(capacity > 0 ? capacity : 1),
+			data_(2 * capacity_)
+		{}
+
+		inline void push(const T& value)
+		{
+			data_[head_] = value;
+			data_[head_ + capacity_] = value;
+			advance();
+		}
+
+		inline void push(T&& value)
+		{
+			data_[head_ + capacity_] = value;
+			data_[head_] = std::move(value);
+			advance();
+		}
+
+		/// <summary>
+		/// Kept values, oldest first. Valid until the next push.
+		/// </summary>
+		inline Span<const T> view() const noexcept
+		{
+			return { data_.data() + head_ + capacity_ - size_, size_ };
+		}
+
+		/// <summary>
+		/// Value i of view().
+		/// </summary>
+		inline const T& operator[](std::size_t i) const noexcept { return data_[head_ + capacity_ - size_ + i]; }
+
+		inline const T& front() const noexcept { return (*this)[0]; }
+		inline const T& back() const noexcept { return data_[head_ + capacity_ - 1]; }
+
+		inline std::size_t size() const noexcept { return size_; }
+		inline std::size_t capacity() const noexcept { return capacity_; }
+		inline bool empty() const noexcept { return size_ == 0; }
+		inline bool full() const noexcept { return size_ == capacity_; }
+
+		inline void clear() noexcept
+		{
+			head_ = 0;
+			size_ = 0;
+		}
+
+	private:
+		inline void advance() noexcept
+		{
+			if (++head_ == capacity_)
+				head_ = 0;
+			if (size_ < capacity_)
+				++size_;
+		}
+
+		std::size_t capacity_;
+		std::vector<T> data_;
+		std::size_t head_ = 0;
+		std::size_t size_ = 0;
+	};
+}
+
+#endif
@@ -0,0 +1,454 @@
+/*
+Copyright 2019 Ilia S. Kovalev
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef UTILS_SERIALIZATION_HPP
+#define UTILS_SERIALIZATION_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "span.hpp"
+
+namespace algorithm_assembler::utils
+{
+	/// <summary>
+	/// Writes values into a preallocated buffer, a value not fitting the rest of it
+	/// throws std::length_error. Nothing is allocated while writing.
+	/// </summary>
+	class Binary_writer
+	{
+	public:
+		Binary_writer(std::byte* data, std::size_t capacity) noexcept : data_(data), capacity_(capacity) {}
+
+		explicit Binary_writer(Span<std::byte> buffer) noexcept : Binary_writer(buffer.data(), buffer.size()) {}
+
+		inline void write(const void* data, std::size_t size)
+		{
+			if (size > capacity_ - size_)
+				throw std::length_error("Serialized data do not fit the buffer");
+
+			if (size > 0)
+				std::memcpy(data_ + size_, data, size);
+			size_ += size;
+		}
+
+		/// <summary>
+		/// Writes values one after another.
+		/// </summary>
+		template<typename... Ts>
+		inline void operator()(const Ts&... values);
+
+		/// <summary>
+		/// Number of written bytes.
+		/// </summary>
+		inline std::size_t size() const noexcept { return size_; }
+
+		inline std::size_t capacity() const noexcept { return capacity_; }
+
+		inline std::byte* data() const noexcept { return data_; }
+
+		/// <summary>
+		/// Starts writing from the beginning of the buffer.
+		/// </summary>
+		inline void clear() noexcept { size_ = 0; }
+
+	private:
+		std::byte* data_;
+		std::size_t capacity_;
+		std::size_t size_ = 0;
+	};
+
+	/// <summary>
+	/// Counts bytes Binary_writer would write, so a buffer is allocated once.
+	/// </summary>
+	class Size_counter
+	{
+	public:
+		inline void write(const void*, std::size_t size) noexcept { size_ += size; }
+
+		template<typename... Ts>
+		inline void operator()(const Ts&... values);
+
+		inline std::size_t size() const noexcept { return size_; }
+
+	private:
+		std::size_t size_ = 0;
+	};
+
+	/// <summary>
+	/// Reads values written by Binary_writer, reading past the end throws std::length_error.
+	/// </summary>
+	class Binary_reader
+	{
+	public:
+		Binary_reader(const std::byte* data, std::size_t size) noexcept : data_(data), size_(size) {}
+
+		explicit Binary_reader(Span<const std::byte> buffer) noexcept : Binary_reader(buffer.data(), buffer.size()) {}
+
+		inline void read(void* data, std::size_t size)
+		{
+			if (size > remaining())
+				throw std::length_error("Serialized data end unexpectedly");
+
+			if (size > 0)
+				std::memcpy(data, data_ + position_, size);
+			position_ += size;
+		}
+
+		/// <summary>
+		/// Reads values one after another.
+		/// </summary>
+		template<typename... Ts>
+		inline void operator()(Ts&... values);
+
+		inline std::size_t remaining() const noexcept { return size_ - position_; }
+
+		inline std::size_t position() const noexcept { return position_; }
+
+	private:
+		const std::byte* data_;
+		std::size_t size_;
+		std::size_t position_ = 0;
+	};
+
+
+	template<typename T, class Archive, typename = void>
+	struct has_serialize_hook : std::false_type {};
+
+	/// <summary>
+	/// Hook of a user type: template&lt;class Archive&gt; void serialize(Archive&amp; archive)
+	/// passing its members to archive(...). It is called to write, to count and to read.
+	/// </summary>
+	template<typename T, class Archive>
+	struct has_serialize_hook<T, Archive, std::void_t<decltype(std::declval<T&>().serialize(std::declval<Archive&>()))>> :
+		std::true_type
+	{};
+
+	/// <summary>
+	/// Types referring to data they do not own, e.g. buffers of a module, which can not be
+	/// restored from serialized data. They are rejected by Binary_format, specialise it for such types.
+	/// </summary>
+	template<typename T>
+	struct is_unrestorable : std::false_type {};
+
+	template<typename T>
+	constexpr bool is_unrestorable_v = is_unrestorable<T>::value;
+
+	/// <summary>
+	/// Binary layout of a type. Types with the serialize hook use it, other trivially copyable
+	/// types are copied as they are. Specialisations cover standard containers and
+	/// may be added for other types.
+	/// </summary>
+	template<typename T, typename = void>
+	struct Binary_format
+	{
+		static_assert(!std::is_pointer_v<T>, "Pointers are not serialized");
+		static_assert(!is_unrestorable_v<T>, "Views of data owned by others are not serialized, copy the data into a value");
+
+		template<class Archive>
+		static inline void write(Archive& archive, const T& value)
+		{
+			if constexpr (has_serialize_hook<T, Archive>::value)
+				const_cast<T&>(value).serialize(archive);
+			else
+			{
+				static_assert(std::is_trivially_copyable_v<T>, "Type needs the serialize hook or Binary_format specialisation");
+				archive.write(&value, sizeof(T));
+			}
+		}
+
+		static inline void read(Binary_reader& reader, T& value)
+		{
+			if constexpr (has_serialize_hook<T, Binary_reader>::value)
+				value.serialize(reader);
+			else
+			{
+				static_assert(std::is_trivially_copyable_v<T>, "Type needs the serialize hook or Binary_format specialisation");
+				reader.read(&value, sizeof(T));
+			}
+		}
+	};
+
+	template<class Archive, typename T>
+	inline void serialize(Archive& archive, const T& value)
+	{
+		Binary_format<T>::write(archive, value);
+	}
+
+	template<typename T>
+	inline void deserialize(Binary_reader& reader, T& value)
+	{
+		Binary_format<T>::read(reader, value);
+	}
+
+	template<typename T>
+	inline T deserialize(Binary_reader& reader)
+	{
+		T value{};
+		Binary_format<T>::read(reader, value);
+		return value;
+	}
+
+	template<typename... Ts>
+	inline void Binary_writer::operator()(const Ts&... values) { (serialize(*this, values), ...); }
+
+	template<typename... Ts>
+	inline void Size_counter::operator()(const Ts&... values) { (serialize(*this, values), ...); }
+
+	template<typename... Ts>
+	inline void Binary_reader::operator()(Ts&... values) { (deserialize(*this, values), ...); }
+
+	/// <summary>
+	/// Bytes taken by serialized values.
+	/// </summary>
+	template<typename... Ts>
+	inline std::size_t serialized_size(const Ts&... values)
+	{
+		Size_counter counter;
+		counter(values...);
+		return counter.size();
+	}
+
+
+	namespace serialization_detail
+	{
+		template<class Archive>
+		inline void write_length(Archive& archive, std::size_t length)
+		{
+			auto l = static_cast<std::uint64_t>(length);
+			archive.write(&l, sizeof(l));
+		}
+
+		/// <summary>
+		/// Reads a length of elements at least min_size bytes each, so broken data
+		/// do not make a huge allocation.
+		/// </summary>
+		inline std::size_t read_length(Binary_reader& reader, std::size_t min_size)
+		{
+			std::uint64_t l;
+			reader.read(&l, sizeof(l));
+			if (min_size > 0 && l > reader.remaining() / min_size)
+				throw std::length_error("Serialized data end unexpectedly");
+			return static_cast<std::size_t>(l);
+		}
+
+		template<typename T>
+		constexpr bool is_copied_v = std::is_trivially_copyable_v<T> && !has_serialize_hook<T, Binary_reader>::value;
+
+		/// <summary>
+		/// Contiguous elements, trivially copyable ones are copied at once.
+		/// </summary>
+		template<class Archive, typename T>
+		inline void write_elements(Archive& archive, const T* data, std::size_t length)
+		{
+			if constexpr (is_copied_v<T>)
+				archive.write(data, length * sizeof(T));
+			else
+				for (std::size_t i = 0; i < length; ++i)
+					serialize(archive, data[i]);
+		}
+
+		template<typename T>
+		inline void read_elements(Binary_reader& reader, T* data, std::size_t length)
+		{
+			if constexpr (is_copied_v<T>)
+				reader.read(data, length * sizeof(T));
+			else
+				for (std::size_t i = 0; i < length; ++i)
+					deserialize(reader, data[i]);
+		}
+	}
+
+	template<typename T, class Allocator>
+	struct Binary_format<std::vector<T, Allocator>>
+	{
+		template<class Archive>
+		static inline void write(Archive& archive, const std::vector<T, Allocator>& v)
+		{
+			serialization_detail::write_length(archive, v.size());
+			if constexpr (std::is_same_v<T, bool>)
+				for (bool b : v)
+					archive.write(&b, sizeof(b));
+			else
+				serialization_detail::write_elements(archive, v.data(), v.size());
+		}
+
+		static inline void read(Binary_reader& reader, std::vector<T, Allocator>& v)
+		{
+			constexpr std::size_t min_size = serialization_detail::is_copied_v<T> ? sizeof(T) : 0;
+
+			auto length = serialization_detail::read_length(reader, min_size);
+			if constexpr (std::is_same_v<T, bool>)
+			{
+				v.resize(length);
+				for (std::size_t i = 0; i < v.size(); ++i)
+					v[i] = deserialize<bool>(reader);
+			}
+			else if constexpr (serialization_detail::is_copied_v<T>)
+			{
+				v.resize(length);
+				serialization_detail::read_elements(reader, v.data(), v.size());
+			}
+			else
+			{
+				// Serialized size of such elements is unknown, so the length is not bounded
+				// by the remaining data: the vector grows while elements are read.
+				v.clear();
+				for (std::size_t i = 0; i < length; ++i)
+					deserialize(reader, v.emplace_back());
+			}
+		}
+	};
+
+	/// <summary>
+	/// Span is written as a vector of its elements, so it is read back as std::vector.
+	/// Reading into a Span is an error as there is no storage for the elements.
+	/// </summary>
+	template<typename T>
+	struct Binary_format<Span<T>>
+	{
+		template<class Archive>
+		static inline void write(Archive& archive, const Span<T>& s)
+		{
+			serialization_detail::write_length(archive, s.size());
+			serialization_detail::write_elements(archive, s.data(), s.size());
+		}
+
+		static inline void read(Binary_reader&, Span<T>&)
+		{
+			static_assert(!std::is_same_v<T, T>, "Span is not restored, read std::vector instead");
+		}
+	};
+
+	template<typename Char, class Traits, class Allocator>
+	struct Binary_format<std::basic_string<Char, Traits, Allocator>>
+	{
+		template<class Archive>
+		static inline void write(Archive& archive, const std::basic_string<Char, Traits, Allocator>& s)
+		{
+			serialization_detail::write_length(archive, s.size());
+			archive.write(s.data(), s.size() * sizeof(Char));
+		}
+
+		static inline void read(Binary_reader& reader, std::basic_string<Char, Traits, Allocator>& s)
+		{
+			s.resize(serialization_detail::read_length(reader, sizeof(Char)));
+			reader.read(s.data(), s.size() * sizeof(Char));
+		}
+	};
+
+	template<typename T, std::size_t N>
+	struct Binary_format<std::array<T, N>, std::enable_if_t<!serialization_detail::is_copied_v<std::array<T, N>>>>
+	{
+		template<class Archive>
+		static inline void write(Archive& archive, const std::array<T, N>& a)
+		{
+			serialization_detail::write_elements(archive, a.data(), N);
+		}
+
+		static inline void read(Binary_reader& reader, std::array<T, N>& a)
+		{
+			serialization_detail::read_elements(reader, a.data(), N);
+		}
+	};
+
+	template<typename T>
+	struct Binary_format<std::optional<T>>
+	{
+		template<class Archive>
+		static inline void write(Archive& archive, const std::optional<T>& o)
+		{
+			bool has_value = o.has_value();
+			archive.write(&has_value, sizeof(has_value));
+			if (has_value)
+				serialize(archive, *o);
+		}
+
+		static inline void read(Binary_reader& reader, std::optional<T>& o)
+		{
+			if (deserialize<bool>(reader))
+				deserialize(reader, o.emplace());
+			else
+				o.reset();
+		}
+	};
+
+	template<typename... Ts>
+	struct Binary_format<std::tuple<Ts...>, std::enable_if_t<!serialization_detail::is_copied_v<std::tuple<Ts...>>>>
+	{
+		template<class Archive>
+		static inline void write(Archive& archive, const std::tuple<Ts...>& t)
+		{
+			std::apply([&archive](const auto&... elements) { (serialize(archive, elements), ...); }, t);
+		}
+
+		static inline void read(Binary_reader& reader, std::tuple<Ts...>& t)
+		{
+			std::apply([&reader](auto&... elements) { (deserialize(reader, elements), ...); }, t);
+		}
+	};
+
+	template<typename T, typename U>
+	struct Binary_format<std::pair<T, U>, std::enable_if_t<!serialization_detail::is_copied_v<std::pair<T, U>>>>
+	{
+		template<class Archive>
+		static inline void write(Archive& archive, const std::pair<T, U>& p)
+		{
+			serialize(archive, p.first);
+			serialize(archive, p.second);
+		}
+
+		static inline void read(Binary_reader& reader, std::pair<T, U>& p)
+		{
+			deserialize(reader, p.first);
+			deserialize(reader, p.second);
+		}
+	};
+
+
+	/// <summary>
+	/// Serializer of Async_file_sink, Shared_memory_sink and Transport_sink
+	/// writing values by Binary_format. Their sources read the values back.
+	/// </summary>
+	template<typename T>
+	struct Binary_serializer
+	{
+		static inline std::size_t size(const T& value) { return serialized_size(value); }
+
+		static inline void write(const T& value, std::byte* out)
+		{
+			Binary_writer writer(out, size(value));
+			writer(value);
+		}
+
+		static inline T read(const std::byte* in, std::size_t size)
+		{
+			Binary_reader reader(in, size);
+			return deserialize<T>(reader);
+		}
+	};
+}
+
+#endif
@@ -0,0 +1,75 @@
+/*
+Copyright 2019 Ilia S. Kovalev
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef SPAN_HPP
+#define SPAN_HPP
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+namespace algorithm_assembler::utils
+{
+	/// <summary>
+	/// Non-owning view of contiguous elements.
+	/// </summary>
+	template<typename T>
+	class Span
+	{
+	public:
+		using element_type = T;
+		using value_type = std::remove_cv_t<T>;
+		using iterator = T*;
+
+		constexpr Span() noexcept = default;
+
+		constexpr Span(T* data, std::size_t size) noexcept : data_(data), size_(size) {}
+
+		template<typename U, typename = std::enable_if_t<std::is_convertible_v<U(*)[], T(*)[]>>>
+		constexpr Span(const Span<U>& other) noexcept : data_(other.data()), size_(other.size()) {}
+
+		/// <summary>
+		/// Views a contiguous container (std::vector, std::array, std::string etc.).
+		/// </summary>
+		template<class Container, typename = std::enable_if_t<
+			!std::is_same_v<std::remove_cv_t<std::remove_reference_t<Container>>, Span> &&
+			std::is_convertible_v<
+				std::remove_pointer_t<decltype(std::declval<Container&>().data())>(*)[],
+				T(*)[]
+			>
+		>>
+		constexpr Span(Container&& c) noexcept : data_(c.data()), size_(c.size()) {}
+
+		constexpr T* data() const noexcept { return data_; }
+		constexpr std::size_t size() const noexcept { return size_; }
+		constexpr bool empty() const noexcept { return size_ == 0; }
+
+		constexpr T& operator[](std::size_t i) const noexcept { return data_[i]; }
+
+		constexpr T* begin() const noexcept { return data_; }
+		constexpr T* end() const noexcept { return data_ + size_; }
+
+		constexpr Span first(std::size_t n) const noexcept { return { data_, n }; }
+		constexpr Span subspan(std::size_t offset, std::size_t n) const noexcept { return { data_ + offset, n }; }
+		constexpr Span subspan(std::size_t offset) const noexcept { return { data_ + offset, size_ - offset }; }
+
+	private:
+		T* data_ = nullptr;
+		std::size_t size_ = 0;
+	};
+}
+
+#endif
@@ -0,0 +1,126 @@
+/*
+Copyright 2019 Ilia S. Kovalev
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef SPSC_RING_HPP
+#define SPSC_RING_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+
+#include "misc.hpp"
+
+namespace algorithm_assembler::utils
+{
+	/// <summary>
+	/// Bounded lock-free queue for one producer thread and one consumer thread.
+	/// Capacity is rounded up to a power of two. Each side caches the other side's
+	/// position and reloads it only when the queue looks full or empty.
+	/// </summary>
+	template<typename T>
+	class Spsc_ring
+	{
+	public:
+		explicit Spsc_ring(std::size_t capacity)
+		{
+			std::size_t size = 2;
+			while (size < capacity)
+				size *= 2;
+
+			mask_ = size - 1;
+			slots_ = std::make_unique<Slot[]>(size);
+		}
+
+		Spsc_ring(const Spsc_ring&) = delete;
+		Spsc_ring& operator=(const Spsc_ring&) = delete;
+
+		~Spsc_ring()
+		{
+			while (!empty())
+				pop();
+		}
+
+		/// <summary>
+		/// Called by the producer.
+		/// </summary>
+		/// <returns>false if the queue is full.</returns>
+		template<typename U>
+		inline bool try_push(U&& value)
+		{
+			auto tail = tail_.load(std::memory_order_relaxed);
+			if (tail - cached_head_ > mask_)
+			{
+				cached_head_ = head_.load(std::memory_order_acquire);
+				if (tail - cached_head_ > mask_)
+					return false;
+			}
+
+			new (slots_[tail & mask_].storage) T(std::forward<U>(value));
+			tail_.store(tail + 1, std::memory_order_release);
+			return true;
+		}
+
+		/// <summary>
+		/// Called by the consumer.
+		/// </summary>
+		/// <returns>The oldest value or nullptr if the queue is empty.</returns>
+		inline T* front() noexcept
+		{
+			auto head = head_.load(std::memory_order_relaxed);
+			if (head == cached_tail_)
+			{
+				cached_tail_ = tail_.load(std::memory_order_acquire);
+				if (head == cached_tail_)
+					return nullptr;
+			}
+
+			return std::launder(reinterpret_cast<T*>(slots_[head & mask_].storage));
+		}
+
+		/// <summary>
+		/// Removes the oldest value, called by the consumer after front() returned it.
+		/// </summary>
+		inline void pop() noexcept
+		{
+			auto head = head_.load(std::memory_order_relaxed);
+			std::launder(reinterpret_cast<T*>(slots_[head & mask_].storage))->~T();
+			head_.store(head + 1, std::memory_order_release);
+		}
+
+		inline bool empty() noexcept { return front() == nullptr; }
+
+		inline std::size_t capacity() const noexcept { return mask_ + 1; }
+
+	private:
+		struct Slot
+		{
+			alignas(T) unsigned char storage[sizeof(T)];
+		};
+
+		std::unique_ptr<Slot[]> slots_;
+		std::size_t mask_ = 0;
+
+		alignas(cache_line_size) std::atomic<std::size_t> head_{ 0 };
+		std::size_t cached_tail_ = 0;
+
+		alignas(cache_line_size) std::atomic<std::size_t> tail_{ 0 };
+		std::size_t cached_head_ = 0;
+	};
+}
+
+#endif
@@ -0,0 +1,259 @@
+/*
+Copyright 2019 Ilia S. Kovalev
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef TASK_HPP
+#define TASK_HPP
+
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+
+#define ALGORITHM_ASSEMBLER_HAS_COROUTINES 1
+
+#include <condition_variable>
+#include <coroutine>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+namespace algorithm_assembler::utils
+{
+	template<typename T = void> class Task;
+
+	namespace task_detail
+	{
+		struct Final_awaiter
+		{
+			bool await_ready() const noexcept { return false; }
+
+			template<class Promise>
+			std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> h) noexcept
+			{
+				auto continuation = h.promise().continuation;
+				return continuation ? continuation : std::noop_coroutine();
+			}
+
+			void await_resume() const noexcept {}
+		};
+
+		struct Promise_base
+		{
+			std::coroutine_handle<> continuation;
+			std::exception_ptr error;
+
+			std::suspend_always initial_suspend() const noexcept { return {}; }
+			Final_awaiter final_suspend() const noexcept { return {}; }
+			void unhandled_exception() noexcept { error = std::current_exception(); }
+		};
+
+		template<typename T>
+		struct Promise : public Promise_base
+		{
+			std::optional<T> value;
+
+			Task<T> get_return_object() noexcept;
+
+			template<typename U>
+			void return_value(U&& v) { value.emplace(std::forward<U>(v)); }
+
+			T result()
+			{
+				if (error)
+					std::rethrow_exception(error);
+				return std::move(*value);
+			}
+		};
+
+		template<>
+		struct Promise<void> : public Promise_base
+		{
+			Task<void> get_return_object() noexcept;
+
+			void return_void() const noexcept {}
+
+			void result() const
+			{
+				if (error)
+					std::rethrow_exception(error);
+			}
+		};
+
+		class Event
+		{
+		public:
+			void set()
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+				is_set_ = true;
+				cv_.notify_all();
+			}
+
+			void wait()
+			{
+				std::unique_lock<std::mutex> lock(mutex_);
+				cv_.wait(lock, [this]() { return is_set_; });
+			}
+
+		private:
+			std::mutex mutex_;
+			std::condition_variable cv_;
+			bool is_set_ = false;
+		};
+
+		/// <summary>
+		/// Coroutine setting event on completion, used to block a thread on a task.
+		/// </summary>
+		struct Sync_wait_task
+		{
+			struct promise_type
+			{
+				Event* event = nullptr;
+
+				Sync_wait_task get_return_object() noexcept
+				{
+					return Sync_wait_task{ std::coroutine_handle<promise_type>::from_promise(*this) };
+				}
+
+				std::suspend_always initial_suspend() const noexcept { return {}; }
+
+				auto final_suspend() const noexcept
+				{
+					struct Awaiter
+					{
+						bool await_ready() const noexcept { return false; }
+						void await_suspend(std::coroutine_handle<promise_type> h) const noexcept { h.promise().event->set(); }
+						void await_resume() const noexcept {}
+					};
+					return Awaiter{};
+				}
+
+				void return_void() const noexcept {}
+				void unhandled_exception() const noexcept { std::terminate(); }
+			};
+
+			explicit Sync_wait_task(std::coroutine_handle<promise_type> h) noexcept : handle(h) {}
+			Sync_wait_task(Sync_wait_task&& other) noexcept : handle(std::exchange(other.handle, {})) {}
+			~Sync_wait_task() { if (handle) handle.destroy(); }
+
+			std::coroutine_handle<promise_type> handle;
+		};
+	}
+
+	/// <summary>
+	/// Lazily started coroutine producing a value. It starts when awaited and resumes
+	/// the awaiting coroutine on completion (on the thread where it completed).
+	/// </summary>
+	template<typename T>
+	class [[nodiscard]] Task
+	{
+	public:
+		using promise_type = task_detail::Promise<T>;
+		using Value_type = T;
+
+		explicit Task(std::coroutine_handle<promise_type> h) noexcept : handle_(h) {}
+
+		Task(Task&& other) noexcept : handle_(std::exchange(other.handle_, {})) {}
+
+		Task& operator=(Task&& other) noexcept
+		{
+			std::swap(handle_, other.handle_);
+			return *this;
+		}
+
+		~Task() { if (handle_) handle_.destroy(); }
+
+		bool await_ready() const noexcept { return !handle_ || handle_.done(); }
+
+		std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+		{
+			handle_.promise().continuation = awaiting;
+			return handle_;
+		}
+
+		T await_resume() { return handle_.promise().result(); }
+
+	private:
+		template<typename U>
+		friend U sync_wait(Task<U> task);
+
+		/// <summary>
+		/// Awaits completion without taking the result.
+		/// </summary>
+		auto when_ready() noexcept
+		{
+			struct Awaiter
+			{
+				Task& task;
+
+				bool await_ready() const noexcept { return task.await_ready(); }
+				std::coroutine_handle<> await_suspend(std::coroutine_handle<> h) noexcept { return task.await_suspend(h); }
+				void await_resume() const noexcept {}
+			};
+			return Awaiter{ *this };
+		}
+
+		std::coroutine_handle<promise_type> handle_;
+	};
+
+	namespace task_detail
+	{
+		template<typename T>
+		inline Task<T> Promise<T>::get_return_object() noexcept
+		{
+			return Task<T>{ std::coroutine_handle<Promise<T>>::from_promise(*this) };
+		}
+
+		inline Task<void> Promise<void>::get_return_object() noexcept
+		{
+			return Task<void>{ std::coroutine_handle<Promise<void>>::from_promise(*this) };
+		}
+	}
+
+	/// <summary>
+	/// Runs task and blocks the calling thread until it completes.
+	/// </summary>
+	template<typename T>
+	inline T sync_wait(Task<T> task)
+	{
+		task_detail::Event event;
+
+		auto waiter = [](Task<T>& t) -> task_detail::Sync_wait_task { co_await t.when_ready(); }(task);
+		waiter.handle.promise().event = &event;
+		waiter.handle.resume();
+		event.wait();
+
+		return task.handle_.promise().result();
+	}
+
+	/// <summary>
+	/// Coroutine started immediately and destroyed on completion, nobody awaits it.
+	/// </summary>
+	struct Detached_task
+	{
+		struct promise_type
+		{
+			Detached_task get_return_object() const noexcept { return {}; }
+			std::suspend_never initial_suspend() const noexcept { return {}; }
+			std::suspend_never final_suspend() const noexcept { return {}; }
+			void return_void() const noexcept {}
+			void unhandled_exception() const noexcept { std::terminate(); }
+		};
+	};
+}
+
+#endif
+
+#endif
@@ -0,0 +1,202 @@
+/*
+Copyright 2019 Ilia S. Kovalev
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "../detail/numa.hpp"
+
+namespace algorithm_assembler::utils
+{
+	/// <summary>
+	/// Placement of Thread_pool workers.
+	/// </summary>
+	struct Thread_pool_settings
+	{
+		/// <summary>
+		/// Number of workers, 0 for one per placement CPU or hardware_concurrency() if there are none.
+		/// </summary>
+		std::size_t threads = 0;
+
+		/// <summary>
+		/// Worker i is pinned to cpus[i % cpus.size()].
+		/// </summary>
+		std::vector<std::size_t> cpus;
+
+		/// <summary>
+		/// NUMA node (socket) of workers. If cpus is empty, every worker may run
+		/// on any CPU of the node and the number of workers defaults to their count.
+		/// </summary>
+		std::optional<std::size_t> numa_node;
+	};
+
+	/// <summary>
+	/// Fixed number of worker threads executing tasks in submission order.
+	/// Queued tasks are finished before the pool is destroyed.
+	/// Workers may be pinned to CPUs or to a NUMA node, memory of stages running
+	/// on a pinned pool is kept local by Numa_allocator and Node_local of numa.hpp.
+	/// </summary>
+	class Thread_pool
+	{
+	public:
+		explicit Thread_pool(std::size_t threads = std::thread::hardware_concurrency())
+		{
+			start(threads > 0 ? threads : 1);
+		}
+
+		/// <summary>
+		/// Starts pinned workers.
+		/// </summary>
+		explicit Thread_pool(const Thread_pool_settings& settings) :
+			numa_node_(settings.numa_node)
+		{
+			auto cpus = settings.cpus;
+			bool is_pinned_to_node = cpus.empty() && numa_node_.has_value();
+			if (is_pinned_to_node)
+				cpus = detail::numa_node_cpus(*numa_node_);
+
+			auto threads = settings.threads;
+			if (threads == 0)
+				threads = cpus.empty() ? std::thread::hardware_concurrency() : cpus.size();
+
+			start(threads > 0 ? threads : 1);
+
+			try
+			{
+				for (std::size_t i = 0; i < workers_.size() && !cpus.empty(); ++i)
+					if (is_pinned_to_node)
+						detail::pin_thread(workers_[i].native_handle(), cpus);
+					else
+						detail::pin_thread(workers_[i].native_handle(), { cpus[i % cpus.size()] });
+			}
+			catch (...)
+			{
+				stop();
+				throw;
+			}
+		}
+
+		Thread_pool(const Thread_pool&) = delete;
+		Thread_pool& operator=(const Thread_pool&) = delete;
+
+		~Thread_pool()
+		{
+			stop();
+		}
+
+		/// <summary>
+		/// Queues task for execution.
+		/// </summary>
+		/// <returns>Future of the task result.</returns>
+		template<class F>
+		inline auto submit(F&& f) -> std::future<std::invoke_result_t<std::decay_t<F>>>
+		{
+			using Result = std::invoke_result_t<std::decay_t<F>>;
+
+			auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(f));
+			auto future = task->get_future();
+
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+				tasks_.emplace_back([task]() { (*task)(); });
+			}
+			cv_.notify_one();
+
+			return future;
+		}
+
+		/// <summary>
+		/// Queues task without a future, the task must not throw.
+		/// </summary>
+		template<class F>
+		inline void post(F&& f)
+		{
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+				tasks_.emplace_back(std::forward<F>(f));
+			}
+			cv_.notify_one();
+		}
+
+		inline std::size_t size() const noexcept { return workers_.size(); }
+
+		/// <summary>
+		/// NUMA node of the workers if it was set.
+		/// </summary>
+		inline std::optional<std::size_t> numa_node() const noexcept { return numa_node_; }
+
+	private:
+		inline void start(std::size_t threads)
+		{
+			workers_.reserve(threads);
+			for (std::size_t i = 0; i < threads; ++i)
+				workers_.emplace_back([this]() { work(); });
+		}
+
+		inline void stop()
+		{
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+				stop_ = true;
+			}
+			cv_.notify_all();
+
+			for (auto& w : workers_)
+				w.join();
+		}
+
+		inline void work()
+		{
+			for (;;)
+			{
+				std::function<void()> task;
+				{
+					std::unique_lock<std::mutex> lock(mutex_);
+					cv_.wait(lock, [this]() { return stop_ || !tasks_.empty(); });
+
+					if (tasks_.empty())
+						return;
+
+					task = std::move(tasks_.front());
+					tasks_.pop_front();
+				}
+				task();
+			}
+		}
+
+		std::mutex mutex_;
+		std::condition_variable cv_;
+		std::deque<std::function<void()>> tasks_;
+		bool stop_ = false;
+
+		std::vector<std::thread> workers_;
+		std::optional<std::size_t> numa_node_;
+	};
+}
+
+#endif
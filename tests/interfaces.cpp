@@ -93,6 +93,42 @@ TEST(Interfaces, Transformer)
 }
 
 
+class Transformer_contiguous_test :
+	public Transforms<Types_with_policy<Updating_policy::always, Contiguous<std::vector<float>>, int>>
+{
+public:
+	void transform(Span<float> data) override
+	{
+		for (auto& d : data)
+			d *= 2;
+	}
+
+	void transform(int& in) override { in += 1; }
+};
+
+TEST(Interfaces, Transformer_contiguous)
+{
+	Transformer_contiguous_test tt;
+
+	static_assert(std::is_same_v<
+		Transformer_contiguous_test::Transforms_types,
+		Typelist<std::vector<float>, int>
+	>);
+
+	std::vector<float> v{ 1.f, 2.f };
+	tt.transform(v);
+	ASSERT_EQ(v, (std::vector<float>{ 2.f, 4.f }));
+
+	detail::Transforms_type_with_policy<Updating_policy::always, std::vector<float>>& base = tt;
+	base.transform(v);
+	ASSERT_EQ(v, (std::vector<float>{ 4.f, 8.f }));
+
+	int i = 1;
+	tt.transform(i);
+	ASSERT_EQ(i, 2);
+}
+
+
 class Demadnand_test : public Demands<bool, float, int>
 {
 public: